@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AS5600.h"
+
+// Ángulo del AS5600 por su salida analógica, muestreada por el ADC1 en modo
+// continuo: el DMA llena tramas sin CPU y una tarea las promedia por bloques
+// de ADC_AS5600_DECIMACION lecturas (20 kHz -> 1 kHz) y deja cada muestra
+// en un anillo SPSC. Es una segunda vía de alta frecuencia cuando el bus
+// I2C está ocupado o compartido. Se compila con ADQUISICION_ADC.
+//
+// El ADC del ESP32 no es lineal cerca de 0 V ni del fondo de escala: el
+// modo 10-90 % deja la señal en la zona útil y es el de por defecto.
+
+// Solo ADC1: el ADC2 no se puede usar con Wi-Fi
+#ifndef ADC_AS5600_PIN
+#define ADC_AS5600_PIN 34
+#endif
+
+// AS5600_OUTMODE_ANALOG_100 o AS5600_OUTMODE_ANALOG_90
+#ifndef ADC_AS5600_MODO
+#define ADC_AS5600_MODO AS5600_OUTMODE_ANALOG_90
+#endif
+
+// 20 kHz es el mínimo del modo continuo en el ESP32
+#ifndef ADC_AS5600_FRECUENCIA_HZ
+#define ADC_AS5600_FRECUENCIA_HZ 20000
+#endif
+
+#ifndef ADC_AS5600_DECIMACION
+#define ADC_AS5600_DECIMACION 20
+#endif
+
+// Bytes que entrega el DMA en cada lectura (2 por conversión)
+#ifndef ADC_AS5600_BYTES_TRAMA
+#define ADC_AS5600_BYTES_TRAMA 128
+#endif
+
+// Calibración de dos puntos de cada placa: lectura cruda con el ángulo en 0
+// y en 4095. Sin definir se usan los valores nominales del modo.
+// Para medirlos, "Lectura cruda" en la opción 6 del menú.
+// #define ADC_AS5600_CRUDO_CERO 420
+// #define ADC_AS5600_CRUDO_FONDO 3650
+
+struct MuestraAdc {
+  uint32_t tiempoUs;   // Estimado: fin del bloque promediado
+  uint16_t angulo;     // 0..4095
+  uint16_t crudo;      // Media del bloque, sin calibrar
+};
+
+// Admite crudoCero > crudoFondo (escala invertida)
+struct CalibracionAdc {
+  uint16_t crudoCero;
+  uint16_t crudoFondo;
+};
+
+struct EstadisticasAdc {
+  uint32_t conversiones;
+  uint32_t muestras;
+  uint32_t bloquesVuelta;   // Bloques con el paso 4095 -> 0: última lectura
+  uint32_t descartadas;     // Anillo lleno
+  uint16_t ultimoCrudo;
+};
+
+// Pone la salida del AS5600 en el modo analógico y arranca el ADC y su
+// tarea en "nucleo"
+bool iniciarAdcAs5600(AS5600 &sensor, uint8_t nucleo, uint8_t prioridad);
+bool extraerMuestraAdc(MuestraAdc &muestra);
+EstadisticasAdc leerEstadisticasAdc();
+
+void fijarCalibracionAdc(const CalibracionAdc &calibracion);
+CalibracionAdc leerCalibracionAdc();
+CalibracionAdc calibracionNominalAdc(uint8_t modo);
+
+// Sin estado: se pueden probar fuera del ESP32
+uint16_t anguloDesdeAdc(uint32_t crudo, const CalibracionAdc &calibracion);
+// Lectura cruda de un bloque: la media, o la última lectura si el bloque
+// cruza el paso de 4095 a 0 (la media daría un ángulo intermedio falso)
+uint16_t decimarBloqueAdc(const uint16_t *crudos, size_t cantidad,
+                          const CalibracionAdc &calibracion, bool &cruzaVuelta);
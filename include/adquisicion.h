@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AS5600.h"
+
+// Tarea de adquisición: dueña del AS5600 y del contador de cajas.
+// Un temporizador hardware la despierta a ADQUISICION_FRECUENCIA_HZ; en cada
+// tick lee el ángulo, actualiza la posición acumulada del AS5600 y publica
+// una muestra con marca de tiempo en una cola SPSC que consume la red.
+// Además publica una instantánea de todos los sensores: portal, BLE y menú
+// la leen a ella y nunca tocan el bus I2C.
+//
+// Con ADQUISICION_PWM el ángulo llega por la salida OUT del AS5600 en modo
+// PWM, medido por la captura del MCPWM (captura_pwm.h): el I2C solo se usa
+// para la trama de estado cada ADQUISICION_DIVISOR_ESTADO ticks.
+// Con ADQUISICION_ADC llega por la salida analógica, muestreada por el ADC
+// en modo continuo (adc_as5600.h), con el mismo uso del I2C.
+
+// getCumulativePosition() necesita al menos dos lecturas por vuelta:
+// a 1 kHz admite ejes de hasta 30000 RPM.
+#ifndef ADQUISICION_FRECUENCIA_HZ
+#define ADQUISICION_FRECUENCIA_HZ 1000
+#endif
+
+#ifndef ADQUISICION_NUCLEO
+#define ADQUISICION_NUCLEO 1
+#endif
+
+#ifndef ADQUISICION_PRIORIDAD
+#define ADQUISICION_PRIORIDAD 5
+#endif
+
+// Temporizador hardware reservado para el muestreo
+#ifndef ADQUISICION_TIMER
+#define ADQUISICION_TIMER 0
+#endif
+
+// Cada cuántos ticks se lee la trama entera del AS5600 (estado del imán y
+// ángulo RAW en la misma transacción) y se recalcula la velocidad
+// (a 1 kHz, 10 veces por segundo)
+#ifndef ADQUISICION_DIVISOR_ESTADO
+#define ADQUISICION_DIVISOR_ESTADO 100
+#endif
+
+struct Muestra {
+  uint32_t tiempoUs;
+  uint32_t conteo;
+  int32_t posicion;    // Posición acumulada (4096 por vuelta)
+  uint16_t angulo;
+  bool conectado;
+};
+
+enum EstadoIman { IMAN_AUSENTE, IMAN_CORRECTO, IMAN_DEBIL, IMAN_FUERTE };
+
+// Estado de los sensores coherente en un instante. No se modifica una vez
+// publicada: cada publicación lleva un número de secuencia nuevo.
+struct InstantaneaSensores {
+  uint32_t secuencia;
+  uint32_t tiempoUs;       // Lectura del ángulo
+  uint16_t angulo;
+  uint16_t anguloRaw;      // Cada ADQUISICION_DIVISOR_ESTADO ticks
+  int32_t posicion;        // Posición acumulada (4096 por vuelta)
+  int32_t revoluciones;
+  uint32_t conteo;
+  float velocidadRpm;      // Cada ADQUISICION_DIVISOR_ESTADO ticks
+  EstadoIman iman;         // Cada ADQUISICION_DIVISOR_ESTADO ticks
+  bool conectado;
+};
+
+// Desviación del instante real de muestreo respecto del previsto
+struct EstadisticasJitter {
+  uint32_t muestras;
+  uint32_t jitterMedioUs;
+  uint32_t jitterMaxUs;
+  uint32_t descartadas;   // Cola llena: el consumidor no da abasto
+  uint32_t tardias;       // Ticks perdidos: la lectura duró más que el periodo
+  uint32_t tardiasFlash;  // De ellos, los que coinciden con el diario en flash
+  uint32_t erroresI2C;
+};
+
+// Contadores acumulados desde el arranque; no se reinician
+struct ContadoresI2C {
+  uint32_t transacciones;
+  uint32_t errores;
+};
+
+void iniciarAdquisicion(AS5600 &sensor, uint8_t pinCajas);
+
+// Lado consumidor (una sola tarea)
+bool extraerMuestra(Muestra &muestra);
+size_t muestrasPendientes();
+
+// Seguro desde cualquier tarea
+InstantaneaSensores leerInstantaneaSensores();
+// Tiempo transcurrido desde la lectura; crece si la adquisición se detiene
+uint32_t antiguedadInstantaneaUs(const InstantaneaSensores &instantanea);
+
+// La tarea que usa LittleFS avisa al empezar (true) y al terminar (false):
+// con la caché de la flash desactivada esta tarea no corre, y los ticks
+// perdidos mientras tanto se cuentan aparte en tardiasFlash
+void marcarOperacionFlash(bool enCurso);
+
+EstadisticasJitter leerJitterAdquisicion();
+ContadoresI2C leerContadoresI2C();
+void reiniciarJitterAdquisicion();
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Cola circular sin bloqueos para un único productor y un único consumidor.
+// El productor solo escribe `_cabeza` y el consumidor solo escribe `_cola`,
+// así que basta con orden adquirir/liberar entre los dos núcleos.
+template <typename T, size_t N>
+class AnilloSpsc {
+  static_assert((N & (N - 1)) == 0, "N debe ser potencia de 2");
+
+public:
+  // Lado productor. Devuelve false (y cuenta la pérdida) si está lleno.
+  bool insertar(const T &elemento) {
+    uint32_t cabeza = _cabeza.load(std::memory_order_relaxed);
+    if (cabeza - _cola.load(std::memory_order_acquire) == N) {
+      _descartados.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _datos[cabeza & (N - 1)] = elemento;
+    _cabeza.store(cabeza + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Lado consumidor
+  bool extraer(T &elemento) {
+    uint32_t cola = _cola.load(std::memory_order_relaxed);
+    if (cola == _cabeza.load(std::memory_order_acquire)) {
+      return false;
+    }
+    elemento = _datos[cola & (N - 1)];
+    _cola.store(cola + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t ocupados() const {
+    return _cabeza.load(std::memory_order_acquire) - _cola.load(std::memory_order_acquire);
+  }
+
+  size_t capacidad() const {
+    return N;
+  }
+
+  uint32_t descartados() const {
+    return _descartados.load(std::memory_order_relaxed);
+  }
+
+private:
+  T _datos[N];
+  std::atomic<uint32_t> _cabeza{0};
+  std::atomic<uint32_t> _cola{0};
+  std::atomic<uint32_t> _descartados{0};
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Ángulo del AS5600 por su salida PWM, medido con la unidad de captura del
+// MCPWM: el hardware marca cada flanco con el reloj APB (80 MHz) y una ISR
+// corta guarda el tiempo en alto y el periodo. No hay espera activa ni
+// tráfico I2C por muestra.
+//
+// Cada trama son 4351 bits: 128 de cabecera en alto, 4095 de dato y 128 en
+// bajo. El ángulo sale de la proporción alto/periodo, así que no depende de
+// la frecuencia real del oscilador del AS5600 (puede variar un 10 %).
+// Se compila con ADQUISICION_PWM.
+
+// Entrada conectada a la patilla OUT del AS5600
+#ifndef CAPTURA_PWM_PIN
+#define CAPTURA_PWM_PIN 27
+#endif
+
+// Tramas con un periodo fuera de 920 Hz ± 20 % se descartan
+#define CAPTURA_PWM_PERIODO_MIN_US 900
+#define CAPTURA_PWM_PERIODO_MAX_US 1360
+
+#define CAPTURA_PWM_BITS_TRAMA 4351
+#define CAPTURA_PWM_BITS_CABECERA 128
+
+struct LecturaPwm {
+  uint16_t angulo;        // 0..4095
+  uint32_t tiempoUs;      // micros() del final de la trama
+  uint32_t tramas;        // Tramas válidas desde el arranque
+  uint32_t descartadas;   // Periodo fuera de margen o flancos perdidos
+};
+
+// Configura la captura en ambos flancos del pin. El AS5600 debe estar ya en
+// modo PWM a 920 Hz. La ISR queda en el núcleo que lo llama.
+bool iniciarCapturaPwm(uint8_t pin);
+LecturaPwm leerCapturaPwm();
+
+// Ángulo 0..4095 de una trama medida en ticks de cualquier reloj.
+// Sin estado: se puede probar fuera del ESP32.
+uint16_t anguloDesdePwm(uint32_t ticksAlto, uint32_t ticksPeriodo);
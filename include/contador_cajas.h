@@ -0,0 +1,61 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Contador de cajas del sensor E18-D80NK.
+// Cada flanco de bajada (LIBRE -> OBSTACULO) cuenta una caja. Hay dos
+// implementaciones, elegidas al compilar:
+//  - por defecto: interrupción por software con ventana de rebote
+//  - CONTADOR_CAJAS_PCNT: periférico PCNT del ESP32 con filtro de glitches,
+//    cuenta sin CPU aunque el programa esté bloqueado en Wi-Fi o HTTP.
+//    No guarda marcas de tiempo por caja.
+
+// Ventana de rebote por defecto (microsegundos): tiempo que la línea debe
+// seguir LIBRE (en alto) para que el flanco de bajada siguiente cuente
+#ifndef CONTADOR_DEBOUNCE_US
+#define CONTADOR_DEBOUNCE_US 5000
+#endif
+
+// Marcas de tiempo que se guardan (debe ser potencia de 2)
+#ifndef CONTADOR_EVENTOS_MAX
+#define CONTADOR_EVENTOS_MAX 64
+#endif
+
+// Foto consistente del contador
+struct InstantaneaCajas {
+  uint32_t conteo;          // Cajas totales
+  uint32_t ultimoEventoUs;  // micros() de la última caja contada
+  uint32_t rechazados;      // Flancos descartados por rebote (solo software)
+};
+
+void iniciarContadorCajas(uint8_t pin, uint32_t debounceUs = CONTADOR_DEBOUNCE_US);
+void configurarDebounceCajas(uint32_t debounceUs);
+
+// Lecturas sin bloqueo, seguras desde cualquier tarea
+uint32_t leerConteoCajas();
+uint64_t leerConteoCajas64();
+InstantaneaCajas leerInstantaneaCajas();
+
+// Copia las marcas de tiempo (micros) de las cajas nuevas desde `cursor`.
+// Si el lector se queda atrás solo se conservan las últimas CONTADOR_EVENTOS_MAX.
+size_t leerEventosCajas(uint32_t &cursor, uint32_t *destino, size_t maximo);
+
+// Filtro de rebote. La ISR salta en los dos flancos: un flanco de bajada es
+// una caja solo si la línea llevaba al menos "debounce" en alto. Así el rebote
+// al soltar (la caja ya pasó) tampoco se cuenta, aunque llegue fuera de la
+// ventana medida desde la última caja.
+struct FiltroRebote {
+  uint32_t altoDesdeUs;   // Última subida
+  bool alto;              // Nivel leído en el último flanco
+  bool armado;            // En alto desde el arranque: la primera bajada cuenta
+};
+
+enum FlancoCaja : uint8_t {
+  FLANCO_SUBIDA,
+  FLANCO_CAJA,
+  FLANCO_REBOTE
+};
+
+// Sin estado global: se pueden probar fuera del ESP32
+void iniciarFiltroRebote(FiltroRebote &filtro, bool alto);
+FlancoCaja filtrarFlancoCaja(FiltroRebote &filtro, bool alto, uint32_t ahoraUs, uint32_t debounceUs);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "diario_telemetria.h"
+#include "lote_telemetria.h"
+
+// Destino de cada payload del enlace de subida: se entrega, pasa al diario
+// para reintentarlo o se descarta, y la espera exponencial entre intentos.
+// No conoce HTTP ni las colas: el envío se inyecta, así se puede probar
+// fuera del ESP32 con un servidor simulado.
+
+#ifndef ENLACE_ESPERA_MIN_MS
+#define ENLACE_ESPERA_MIN_MS 500
+#endif
+
+#ifndef ENLACE_ESPERA_MAX_MS
+#define ENLACE_ESPERA_MAX_MS 30000
+#endif
+
+enum RespuestaEnlace : uint8_t {
+  RESPUESTA_ENTREGADO,    // 2xx
+  RESPUESTA_REINTENTAR,   // Sin respuesta, 5xx, 408 o 429
+  RESPUESTA_RECHAZADO     // Resto: repetirlo daría lo mismo
+};
+
+// Sin estado: se puede probar fuera del ESP32
+RespuestaEnlace clasificarRespuestaHttp(int codigo);
+
+// Hace el POST. Devuelve el código HTTP, o <= 0 si no hubo respuesta.
+typedef int (*FuncionEnvio)(void *contexto, const char *datos, size_t longitud,
+                            uint32_t arranque, uint32_t numero);
+
+struct EstadisticasDespacho {
+  uint32_t enviados;
+  uint32_t fallidos;      // Intentos que se reintentarán
+  uint32_t rechazados;    // 4xx: no se reintentan
+  uint32_t descartados;   // Cola llena, payload demasiado grande o diario sin espacio
+};
+
+// Lo usa solo la tarea del enlace, salvo registrarDescarte() y las lecturas.
+// Si el servidor responde 415 a un lote binario, ese lote y todos los
+// binarios que queden (cola o diario) se convierten a JSON antes de enviarlos.
+class DespachoEnlace {
+public:
+  // "buffer" recibe los registros del diario al reenviarlos y los lotes
+  // convertidos a JSON
+  DespachoEnlace(DiarioTelemetria &diario, char *buffer, size_t capacidad,
+                 FuncionEnvio enviar, void *contexto);
+
+  // Ms hasta que se pueda volver a intentar tras un fallo (0 si ya se puede)
+  uint32_t esperaRestanteMs() const;
+
+  // Payload nuevo. Se envía si hay red, no toca esperar y el diario está
+  // vacío (para conservar el orden); si no, o si hay que reintentarlo, se
+  // anota en el diario.
+  void despachar(const char *datos, size_t longitud, uint32_t numero, bool enLinea);
+  // Reenvía el registro más antiguo del diario, si hay red y no toca esperar
+  void reenviarDiario(bool enLinea);
+
+  void registrarDescarte();
+  // false si el servidor respondió 415 a un lote binario
+  bool aceptaBinario() const;
+  EstadisticasDespacho estadisticas() const;
+
+private:
+  RespuestaEnlace intentar(const char *datos, size_t longitud, uint32_t arranque, uint32_t numero);
+  bool puedeEnviar(bool enLinea) const;
+  // Deja en _buffer el lote binario en JSON. Devuelve su longitud o 0.
+  size_t binarioAJson(const char *datos, size_t longitud);
+
+  DiarioTelemetria &_diario;
+  char *_buffer;
+  size_t _capacidad;
+  FuncionEnvio _enviar;
+  void *_contexto;
+  uint32_t _esperaMs = ENLACE_ESPERA_MIN_MS;
+  uint32_t _proximoIntento = 0;
+  bool _esperando = false;
+  LoteTelemetria _conversion;
+
+  std::atomic<uint32_t> _enviados{0};
+  std::atomic<uint32_t> _fallidos{0};
+  std::atomic<uint32_t> _rechazados{0};
+  std::atomic<uint32_t> _descartados{0};
+  std::atomic<bool> _binarioRechazado{false};
+};
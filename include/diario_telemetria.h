@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Diario de telemetría en flash para cuando no hay conexión.
+// Los payloads se añaden al final de segmentos de tamaño fijo (/diario/N.seg)
+// y se reenvían en orden al volver la red. Un checkpoint (segmento, offset)
+// marca lo ya confirmado por el servidor y se reescribe de forma atómica
+// (archivo temporal + rename), así un corte de luz nunca deja huecos.
+// Cada registro lleva un identificador (arranque, número) que viaja en la
+// cabecera X-Lote: si el corte ocurre entre la respuesta y el checkpoint el
+// registro se reenvía y el servidor puede descartar el duplicado.
+//
+// No es seguro entre tareas: lo usa solo la tarea del enlace HTTP, que es
+// también quien escribe en flash, nunca la de adquisición. Aun así, mientras
+// LittleFS lee, escribe o borra, la caché de la flash está desactivada en los
+// dos núcleos y la adquisición se detiene: por eso el checkpoint se reescribe
+// como mucho cada DIARIO_CHECKPOINT_MS y cada operación se avisa.
+
+#ifndef DIARIO_TAM_SEGMENTO
+#define DIARIO_TAM_SEGMENTO 16384
+#endif
+
+// Al superar este número de segmentos se pierde el más antiguo
+#ifndef DIARIO_MAX_SEGMENTOS
+#define DIARIO_MAX_SEGMENTOS 8
+#endif
+
+// Mínimo entre dos reescrituras del checkpoint durante el reenvío (un
+// archivo nuevo y un rename). Si hay un corte antes, los registros ya
+// confirmados desde el último se reenvían y X-Lote los identifica.
+// Al vaciarse el diario se guarda siempre.
+#ifndef DIARIO_CHECKPOINT_MS
+#define DIARIO_CHECKPOINT_MS 5000
+#endif
+
+// Se llama con true antes de tocar la flash y con false al terminar
+typedef void (*AvisoFlash)(bool enCurso);
+
+struct EstadisticasDiario {
+  uint32_t anotados;
+  uint32_t reenviados;
+  uint32_t perdidos;         // Segmentos antiguos descartados, registros dañados o errores de escritura
+  uint32_t bytesPendientes;
+  uint32_t arranque;
+};
+
+class DiarioTelemetria {
+public:
+  // El aviso, si lo hay, antes de iniciar()
+  void avisarFlash(AvisoFlash aviso);
+  bool iniciar(fs::FS &fs);
+
+  bool anotar(const char *datos, size_t longitud, uint32_t numero);
+  bool hayPendientes() const;
+
+  // Lee el registro siguiente al checkpoint sin avanzarlo.
+  // Devuelve la longitud del payload o 0 si no hay ninguno.
+  size_t leerSiguiente(char *destino, size_t maximo, uint32_t &arranque, uint32_t &numero);
+  // El servidor confirmó el último registro leído
+  void confirmar();
+
+  uint32_t arranque() const;
+  EstadisticasDiario estadisticas() const;
+
+private:
+  struct Cabecera {
+    uint32_t magia;
+    uint32_t arranque;
+    uint32_t numero;
+    uint32_t longitud;
+    uint32_t crc;
+  };
+
+  void rutaSegmento(uint32_t segmento, char *ruta) const;
+  // Pasa el checkpoint tras el último registro leído
+  void avanzar();
+  void guardarCheckpoint();
+  // Guarda el checkpoint si el diario quedó vacío o pasó DIARIO_CHECKPOINT_MS
+  void guardarCheckpointSiToca();
+  void descartarSegmentoLectura();
+  uint32_t tamanoSegmento(uint32_t segmento) const;
+
+  fs::FS *_fs = nullptr;
+  uint32_t _arranque = 0;
+  uint32_t _segLectura = 0;
+  uint32_t _offLectura = 0;
+  uint32_t _segEscritura = 0;
+  uint32_t _tamEscritura = 0;
+  uint32_t _siguienteOffset = 0;   // Tras el último registro leído
+  uint32_t _checkpointMs = 0;
+  bool _checkpointPendiente = false;
+  AvisoFlash _aviso = nullptr;
+  EstadisticasDiario _stats = {};
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// DNS del portal cautivo: cualquier nombre resuelve a la IP del punto de
+// acceso. En cada llamada a atenderDnsPortal() se vacían los paquetes
+// pendientes de un socket no bloqueante; la respuesta es la propia consulta
+// con la cabecera ajustada y un registro A ya preparado, sin reservas de
+// memoria. Las consultas AAAA se contestan vacías (NOERROR sin respuestas)
+// para que el cliente pase enseguida a IPv4.
+
+// Tope de paquetes por llamada, para no acaparar la tarea de red
+#ifndef DNS_MAX_POR_TICK
+#define DNS_MAX_POR_TICK 16
+#endif
+
+#ifndef DNS_TTL_S
+#define DNS_TTL_S 60
+#endif
+
+// Mayor consulta que se atiende (UDP sin EDNS)
+#define DNS_TAM_MAXIMO 512
+
+struct EstadisticasDns {
+  uint32_t consultas;
+  uint32_t respuestasA;
+  uint32_t respuestasVacias;   // AAAA y otros tipos
+  uint32_t descartadas;        // Mal formadas, no consultas o sin poder enviar
+  uint32_t consultasPorSegundo;
+};
+
+bool iniciarDnsPortal(IPAddress ip, uint16_t puerto = 53);
+void atenderDnsPortal();
+EstadisticasDns leerEstadisticasDns();
+
+// Registro A ya armado: puntero al nombre de la pregunta, tipo, clase, TTL e IP
+#define DNS_TAM_REGISTRO_A 16
+void prepararRegistroDns(uint8_t registro[DNS_TAM_REGISTRO_A], IPAddress ip, uint32_t ttlS);
+
+// Arma en "respuesta" la contestación a "consulta". Devuelve su longitud o 0
+// si hay que descartarla. Sin estado: se puede probar fuera del ESP32.
+size_t armarRespuestaDns(const uint8_t *consulta, size_t longitud, uint8_t *respuesta,
+                         size_t maximo, const uint8_t registro[DNS_TAM_REGISTRO_A], bool &esTipoA);
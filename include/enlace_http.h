@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Arduino.h>
+#include "despacho_enlace.h"
+#include "diario_telemetria.h"
+#include "histograma.h"
+
+// Enlace de subida al servidor.
+// Una tarea propia mantiene abierta una conexión keep-alive con serverUrl y
+// envía los payloads encolados; quien encola nunca espera a la red. Sin Wi-Fi,
+// o si un envío falla, el payload pasa al diario en LittleFS y se reenvía en
+// orden con espera exponencial cuando vuelve la conexión. Solo un 2xx cuenta
+// como entregado; qué se reintenta y qué no lo decide DespachoEnlace.
+
+#ifndef ENLACE_TAM_PAYLOAD
+#define ENLACE_TAM_PAYLOAD 4096
+#endif
+
+// Payloads que pueden esperar a la vez (memoria estática reservada)
+#ifndef ENLACE_COLA
+#define ENLACE_COLA 4
+#endif
+
+#ifndef ENLACE_NUCLEO
+#define ENLACE_NUCLEO 0
+#endif
+
+struct EstadisticasEnlace {
+  uint32_t enviados;
+  uint32_t fallidos;        // Intentos que se reintentarán
+  uint32_t rechazados;      // 4xx: el servidor no lo aceptará, no se reintenta
+  uint32_t descartados;     // Cola llena, payload demasiado grande o diario sin espacio
+  uint32_t conexiones;      // Conexiones TCP nuevas
+  uint32_t reutilizadas;    // Peticiones sobre una conexión ya abierta
+  // Percentiles aproximados: límite superior de la cubeta del histograma
+  uint32_t latenciaP50Ms;
+  uint32_t latenciaP90Ms;
+  uint32_t latenciaP99Ms;
+  uint32_t enCola;
+};
+
+void iniciarEnlaceHttp(const char *url);
+
+// Copia el payload a la cola. Devuelve false si no hay hueco.
+// Se envía como JSON si empieza por '{' y como binario en otro caso.
+bool encolarPayload(const char *datos, size_t longitud);
+
+// false si el servidor respondió 415 a un lote binario
+bool enlaceAceptaBinario();
+
+EstadisticasEnlace leerEstadisticasEnlace();
+// Latencia de cada POST en ms
+const Histograma &leerLatenciasEnlace();
+EstadisticasDiario leerEstadisticasDiario();
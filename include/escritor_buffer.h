@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Escritor de texto sobre un buffer fijo (pila o estático), sin usar el heap.
+// Siempre deja el texto terminado en '\0'. Si algo no cabe se trunca y queda
+// marcado como desbordado; quien lo use decide si descarta el resultado.
+// Con una función de vaciado el buffer se comporta como una ventana: al
+// llenarse se entrega el trozo (p. ej. como fragmento HTTP) y se sigue
+// escribiendo, así la memoria no depende del tamaño total del texto.
+
+// Devuelve false si no pudo entregar el trozo
+typedef bool (*FuncionVaciado)(void *contexto, const char *datos, size_t longitud);
+
+class EscritorBuffer {
+public:
+  EscritorBuffer(char *buffer, size_t capacidad);
+  EscritorBuffer(char *buffer, size_t capacidad, FuncionVaciado vaciado, void *contexto);
+
+  EscritorBuffer &agregar(const char *texto);
+  EscritorBuffer &agregar(const char *datos, size_t longitud);
+  EscritorBuffer &agregar(char c);
+  EscritorBuffer &agregarEntero(int32_t valor);
+  EscritorBuffer &agregarSinSigno(uint32_t valor);
+  // Coma fija redondeada, p. ej. agregarFijo(12.345, 1) -> "12.3". Escribe
+  // "nan" e "inf"; si no cabe en 32 bits reduce decimales y luego satura.
+  EscritorBuffer &agregarFijo(float valor, uint8_t decimales);
+
+  const char *c_str() const;
+  size_t longitud() const;
+  size_t capacidad() const;
+  // Con vaciado: desbordado también indica que falló una entrega
+  bool desbordado() const;
+  void reiniciar();
+  // Entrega lo pendiente. Sin función de vaciado no hace nada.
+  bool vaciar();
+
+private:
+  char *_buffer;
+  size_t _capacidad;
+  size_t _longitud = 0;
+  bool _desbordado = false;
+  FuncionVaciado _vaciado = nullptr;
+  void *_contexto = nullptr;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include "escritor_buffer.h"
+
+// Actualizaciones en vivo del portal con Server-Sent Events.
+// La página abre /eventos una sola vez; al conectar recibe el estado completo
+// y después solo los campos que cambian, como mucho cada EVENTOS_PERIODO_MS.
+// Salvo clientesEventos(), todo se llama desde la tarea del servidor HTTP.
+
+// Cuenta en el presupuesto de conexiones de servidor_portal.h
+#ifndef EVENTOS_MAX_CLIENTES
+#define EVENTOS_MAX_CLIENTES 2
+#endif
+
+// Límite de frecuencia: periodo con el que se publica
+#ifndef EVENTOS_PERIODO_MS
+#define EVENTOS_PERIODO_MS 200
+#endif
+
+// Sin cambios se manda un comentario para que el móvil no cierre la conexión
+#ifndef EVENTOS_KEEPALIVE_MS
+#define EVENTOS_KEEPALIVE_MS 15000
+#endif
+
+struct EstadoPortal {
+  uint32_t cajas;
+  uint16_t angulo;
+  bool conectado;   // AS5600 respondiendo
+  bool libre;       // E18-D80NK sin obstáculo
+};
+
+// Manejador de /eventos: se queda con el socket de la petición y le manda
+// las cabeceras y el estado completo. El hueco del cliente va en el contexto
+// de la sesión, así que se libera en cuanto el servidor la cierra.
+esp_err_t aceptarClienteEventos(httpd_req_t *req, const EstadoPortal &estado);
+
+// Envía a todos los clientes los campos que cambiaron desde el último envío
+void publicarEventos(httpd_handle_t servidor, const EstadoPortal &estado, uint32_t ahoraMs);
+
+// El socket es de un suscriptor (no entra en la purga de conexiones)
+bool esClienteEventos(int fd);
+
+// El mismo estado completo en JSON, para /datos
+bool serializarEstadoPortal(EscritorBuffer &json, const EstadoPortal &estado);
+
+// Seguro desde cualquier tarea
+uint8_t clientesEventos();
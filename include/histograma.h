@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Histograma de cubetas fijas sin memoria dinámica: registrar() es un par de
+// operaciones atómicas y se puede dejar activo en producción.
+// Un solo escritor; se puede leer desde cualquier tarea.
+
+#ifndef HISTOGRAMA_MAX_CUBETAS
+#define HISTOGRAMA_MAX_CUBETAS 12
+#endif
+
+class Histograma {
+public:
+  // "limites" es el límite superior (inclusive) de cada cubeta, creciente.
+  // Los valores por encima del último caen en una cubeta de desborde.
+  Histograma(const uint32_t *limites, size_t cantidad);
+
+  void registrar(uint32_t valor);
+
+  // Cubetas sin contar la de desborde
+  size_t cubetas() const;
+  uint32_t limite(size_t indice) const;
+  // indice == cubetas() es la de desborde
+  uint32_t cuenta(size_t indice) const;
+  uint32_t total() const;
+  uint64_t suma() const;
+
+  // Aproximado: límite superior de la cubeta que alcanza el percentil p
+  // (UINT32_MAX si cae en la de desborde)
+  uint32_t percentil(uint32_t p) const;
+
+private:
+  const uint32_t *_limites;
+  size_t _cantidad;
+  std::atomic<uint32_t> _cuentas[HISTOGRAMA_MAX_CUBETAS + 1];
+  std::atomic<uint64_t> _suma{0};
+};
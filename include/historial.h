@@ -0,0 +1,45 @@
+#pragma once
+
+#include <Arduino.h>
+#include "escritor_buffer.h"
+
+// Historial de los sensores en memoria fija, a varias resoluciones.
+// Cada nivel es un anillo de puntos de periodo fijo (1 s, 1 min, 15 min) con
+// mínimo, máximo y media de cada serie. Cada muestra se acumula en todos los
+// niveles al insertarla, así una consulta solo recorre los puntos que
+// devuelve. Si no llegan muestras durante un periodo queda un punto vacío.
+//
+// Escribe una sola tarea (la de red); se puede leer desde cualquier otra.
+
+#ifndef HISTORIAL_PUNTOS_SEGUNDO
+#define HISTORIAL_PUNTOS_SEGUNDO 120   // 2 minutos
+#endif
+
+#ifndef HISTORIAL_PUNTOS_MINUTO
+#define HISTORIAL_PUNTOS_MINUTO 120    // 2 horas
+#endif
+
+#ifndef HISTORIAL_PUNTOS_CUARTO
+#define HISTORIAL_PUNTOS_CUARTO 96     // 24 horas
+#endif
+
+#define HISTORIAL_NIVELES 3
+
+// Cajas es el contador acumulado: max - min son las cajas del periodo.
+// La media del ángulo sigue el giro (4090 y 6 dan 0, no 2048).
+struct PuntoHistorial {
+  int32_t cajasMin, cajasMax, cajasMedia;
+  int16_t anguloMin, anguloMax, anguloMedia;   // anguloMin < 0: punto vacío
+  int16_t rpmMin, rpmMax, rpmMedia;
+};
+
+void iniciarHistorial();
+void agregarHistorial(uint32_t ahoraMs, uint32_t cajas, uint16_t angulo, float rpm);
+
+uint32_t periodoHistorialS(uint8_t nivel);
+
+// JSON por filas, del más antiguo al más reciente:
+// {"periodo":s,"fin":s,"ahora":s,"p":[[cmin,cmax,cmed,amin,amax,amed,vmin,vmax,vmed]|null,..]}
+// "fin" es el final del último punto en segundos desde el arranque.
+// Devuelve false si el nivel no existe o no cupo.
+bool escribirHistorial(EscritorBuffer &json, uint8_t nivel, uint32_t ahoraMs);
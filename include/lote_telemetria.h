@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include "adquisicion.h"
+#include "escritor_buffer.h"
+
+// Lote de telemetría: acumula puntos con marca de tiempo y se envía en un
+// solo POST cuando se llena o cuando el punto más viejo alcanza la edad máxima.
+
+// Un punto cada LOTE_INTERVALO_MS (las muestras intermedias se descartan)
+#ifndef LOTE_INTERVALO_MS
+#define LOTE_INTERVALO_MS 100
+#endif
+
+#ifndef LOTE_MAX_PUNTOS
+#define LOTE_MAX_PUNTOS 100
+#endif
+
+#ifndef LOTE_MAX_EDAD_MS
+#define LOTE_MAX_EDAD_MS 10000
+#endif
+
+// Con -DTELEMETRIA_BINARIO el lote se envía con codificarBinario()
+#define TIPO_CONTENIDO_JSON "application/json"
+#define TIPO_CONTENIDO_BINARIO "application/x-telemetria-delta"
+#define LOTE_VERSION_BINARIO 1
+
+struct PuntoTelemetria {
+  uint32_t tiempoMs;
+  uint32_t conteo;
+  uint16_t angulo;
+};
+
+class LoteTelemetria {
+public:
+  // Devuelve false si el lote está lleno y el punto se perdió
+  bool agregar(const Muestra &muestra);
+  bool listoParaEnviar(uint32_t ahoraMs) const;
+  void vaciar();
+
+  // JSON por columnas:
+  // {"t0":ms,"ahora":ms,"t":[..],"angulo":[..],"conteo_cajas":[..]}
+  // "t" es relativo a "t0"; "ahora" permite al servidor pasar a hora real.
+  // Devuelve false si no cupo en el escritor.
+  bool serializar(EscritorBuffer &json, uint32_t ahoraMs) const;
+
+  // Binario compacto. Enteros sin signo en varint LEB128; los que llevan
+  // (z) en zig-zag. Todo relativo al valor anterior de la misma columna:
+  //   u8   versión (LOTE_VERSION_BINARIO, nunca '{')
+  //   var  n puntos
+  //   var  t0 (ms)
+  //   var  ahora - t0
+  //   var  intervalo nominal (LOTE_INTERVALO_MS)
+  //   n x var(z)  (t[i] - t[i-1]) - intervalo, con t[-1] = t0 - intervalo
+  //   n x var(z)  ángulo[i] - ángulo[i-1] llevado a -2048..2047, ángulo[-1] = 0
+  //   n x var(z)  conteo[i] - conteo[i-1], conteo[-1] = 0
+  // Devuelve los bytes escritos o 0 si no cabe.
+  size_t codificarBinario(uint8_t *destino, size_t maximo, uint32_t ahoraMs) const;
+  // Lo inverso: reemplaza los puntos del lote por los de "origen". Devuelve
+  // false si está mal formado o trae más de LOTE_MAX_PUNTOS; el lote queda vacío.
+  bool decodificarBinario(const uint8_t *origen, size_t longitud, uint32_t &ahoraMs);
+
+  size_t cantidad() const;
+  const PuntoTelemetria &punto(size_t indice) const;
+  uint32_t perdidos() const;
+
+private:
+  PuntoTelemetria _puntos[LOTE_MAX_PUNTOS];
+  size_t _cantidad = 0;
+  uint32_t _ultimoPuntoMs = 0;
+  uint32_t _perdidos = 0;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Arduino.h>
+#include "escritor_buffer.h"
+
+// Métricas del firmware en el formato de texto de Prometheus (/metrics).
+// Cada módulo lleva sus contadores atómicos preasignados; aquí solo se leen
+// y se les da formato cuando alguien las pide, así pueden quedar activas
+// en producción.
+
+// Tareas FreeRTOS cuya pila mínima libre se publica
+#ifndef METRICAS_MAX_TAREAS
+#define METRICAS_MAX_TAREAS 8
+#endif
+
+// Solo al arrancar cada módulo, nunca desde dos tareas a la vez
+void registrarTareaMetricas(const char *nombre, TaskHandle_t tarea);
+
+// Duración de una vuelta de la tarea de red que ejecutó alguna tarea
+void registrarVueltaRed(uint32_t duracionUs);
+
+// Devuelve false si no cupo en el escritor
+bool escribirMetricas(EscritorBuffer &texto);
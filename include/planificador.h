@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Planificador cooperativo por plazos.
+// Cada llamada a ejecutar() corre, como mucho, la tarea vencida con el plazo
+// más antiguo. Como el plazo de una tarea solo avanza cuando se ejecuta,
+// ninguna tarea puede dejar sin turno a otra indefinidamente.
+// Las tareas no deben bloquear: el presupuesto solo se vigila, no se impone.
+
+#ifndef PLANIFICADOR_MAX_TAREAS
+#define PLANIFICADOR_MAX_TAREAS 12
+#endif
+
+typedef void (*FuncionTarea)();
+typedef uint32_t (*FuenteReloj)();
+
+struct EstadisticasTarea {
+  uint32_t ejecuciones;
+  uint32_t desbordes;      // Ejecuciones que superaron el presupuesto
+  uint32_t duracionMaxUs;
+  uint32_t retrasoMaxMs;   // Mayor espera desde que venció el plazo
+};
+
+class Planificador {
+public:
+  // Los relojes se pueden sustituir por uno virtual para pruebas
+  Planificador(FuenteReloj relojMs = millis, FuenteReloj relojUs = micros);
+
+  // Devuelven el id de la tarea o -1 si no hay hueco
+  int agregarPeriodica(const char *nombre, FuncionTarea funcion,
+                       uint32_t periodoMs, uint32_t presupuestoUs);
+  int programarUnaVez(const char *nombre, FuncionTarea funcion,
+                      uint32_t retardoMs, uint32_t presupuestoUs);
+  void cancelar(int id);
+
+  // Ejecuta la tarea vencida más urgente. Devuelve false si no había ninguna.
+  bool ejecutar();
+
+  uint8_t cantidadTareas() const;
+  const char *nombreTarea(uint8_t indice) const;
+  EstadisticasTarea estadisticas(uint8_t indice) const;
+  void reiniciarEstadisticas();
+
+private:
+  struct Tarea {
+    const char *nombre;
+    FuncionTarea funcion;
+    uint32_t periodoMs;      // 0 = una sola vez
+    uint32_t presupuestoUs;
+    uint32_t plazoMs;
+    bool activa;
+    EstadisticasTarea stats;
+  };
+
+  int reservar(const char *nombre, FuncionTarea funcion, uint32_t periodoMs,
+               uint32_t retardoMs, uint32_t presupuestoUs);
+
+  FuenteReloj _relojMs;
+  FuenteReloj _relojUs;
+  Tarea _tareas[PLANIFICADOR_MAX_TAREAS];
+  uint8_t _cantidad = 0;
+  int _enCurso = -1;   // Su hueco no se reutiliza hasta anotar sus estadísticas
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Archivos del portal ya comprimidos con gzip. La tabla la genera
+// scripts/portal_gzip.py en src/recursos_portal.cpp a partir de portal/.
+struct RecursoPortal {
+  const char *ruta;
+  const char *tipo;
+  const char *etag;
+  const uint8_t *datos;
+  size_t longitud;
+  bool inmutable;   // La URL lleva el hash: se puede guardar en caché sin revalidar
+};
+
+extern const RecursoPortal RECURSOS_PORTAL[];
+extern const size_t CANTIDAD_RECURSOS_PORTAL;
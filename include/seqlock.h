@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Publicación de una estructura pequeña con un único escritor y varios
+// lectores sin bloqueos. La secuencia es impar mientras se escribe; el
+// lector repite la copia si la ve impar o si cambió durante la lectura.
+template <typename T>
+class Seqlock {
+public:
+  void publicar(const T &valor) {
+    uint32_t s = _secuencia.load(std::memory_order_relaxed);
+    _secuencia.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _valor = valor;
+    std::atomic_thread_fence(std::memory_order_release);
+    _secuencia.store(s + 2, std::memory_order_relaxed);
+  }
+
+  T leer() const {
+    T copia;
+    uint32_t s1, s2;
+    do {
+      s1 = _secuencia.load(std::memory_order_acquire);
+      copia = _valor;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      s2 = _secuencia.load(std::memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+    return copia;
+  }
+
+  // Número de publicaciones hechas
+  uint32_t secuencia() const {
+    return _secuencia.load(std::memory_order_acquire) >> 1;
+  }
+
+private:
+  T _valor{};
+  std::atomic<uint32_t> _secuencia{0};
+};
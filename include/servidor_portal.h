@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include "eventos_portal.h"
+
+// Servidor web del portal cautivo sobre esp_http_server: atiende en su propia
+// tarea, por eventos de socket, con conexiones persistentes y un límite de
+// clientes. No depende del planificador ni de la tarea del enlace HTTP.
+// También sirve /metrics en formato de texto de Prometheus.
+
+// Presupuesto de conexiones, todo aquí:
+//   EVENTOS_MAX_CLIENTES    suscriptores de /eventos; nunca se purgan
+//   PORTAL_CONEXIONES_HTTP  peticiones normales; al pasarse se cierra la más antigua
+//   + 1                     hueco para aceptar la nueva antes de cerrar la vieja
+// Con esp_http_server la purga LRU propia cerraría primero a los suscriptores
+// (no vuelven a enviar nada), así que se desactiva y se purga desde aquí.
+// Además el servidor usa 3 sockets internos y el enlace HTTP y el DNS del
+// portal uno cada uno; todo debe caber en CONFIG_LWIP_MAX_SOCKETS (10 en IDF).
+#ifndef PORTAL_CONEXIONES_HTTP
+#define PORTAL_CONEXIONES_HTTP 2
+#endif
+
+#define PORTAL_MAX_CONEXIONES (EVENTOS_MAX_CLIENTES + PORTAL_CONEXIONES_HTTP + 1)
+#define PORTAL_SOCKETS_AJENOS (3 + 1 + 1)
+
+#ifdef CONFIG_LWIP_MAX_SOCKETS
+static_assert(PORTAL_MAX_CONEXIONES + PORTAL_SOCKETS_AJENOS <= CONFIG_LWIP_MAX_SOCKETS,
+              "EVENTOS_MAX_CLIENTES + PORTAL_CONEXIONES_HTTP no caben en los sockets lwIP");
+#endif
+
+// Las respuestas generadas se envían en fragmentos de este tamaño
+#ifndef PORTAL_TAM_FRAGMENTO
+#define PORTAL_TAM_FRAGMENTO 512
+#endif
+
+// A donde se redirigen las sondas de portal cautivo (IP del punto de acceso)
+#ifndef PORTAL_URL
+#define PORTAL_URL "http://192.168.4.1/"
+#endif
+
+#ifndef PORTAL_NUCLEO
+#define PORTAL_NUCLEO 0
+#endif
+
+#ifndef PORTAL_PRIORIDAD
+#define PORTAL_PRIORIDAD 2
+#endif
+
+// Arranca el servidor en el puerto 80; llamarlo de nuevo no hace nada
+bool iniciarServidorPortal(uint8_t pinProximidad);
+
+// URLs con las que cada sistema comprueba si hay un portal cautivo.
+// Se responden desde una tabla fija, sin generar nada, y se cuentan.
+size_t cantidadSondasPortal();
+const char *rutaSondaPortal(size_t indice);
+uint32_t aciertosSondaPortal(size_t indice);
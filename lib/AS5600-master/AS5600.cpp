@@ -1,7 +1,7 @@
 //
 //    FILE: AS56000.cpp
 //  AUTHOR: Rob Tillaart
-// VERSION: 0.6.6
+// VERSION: 0.7.0
 // PURPOSE: Arduino library for AS5600 magnetic rotation meter
 //    DATE: 2022-05-28
 //     URL: https://github.com/RobTillaart/AS5600
@@ -9,6 +9,10 @@
 
 #include "AS5600.h"
 
+#if defined(AS5600_ASYNC_DRIVER)
+#include "driver/i2c.h"
+#endif
+
 
 //  CONFIGURATION REGISTERS
 const uint8_t AS5600_ZMCO = 0x00;
@@ -17,14 +21,14 @@ const uint8_t AS5600_MPOS = 0x03;   //  + 0x04
 const uint8_t AS5600_MANG = 0x05;   //  + 0x06
 const uint8_t AS5600_CONF = 0x07;   //  + 0x08
 
-//  CONFIGURATION BIT MASKS - byte level
-const uint8_t AS5600_CONF_POWER_MODE    = 0x03;
-const uint8_t AS5600_CONF_HYSTERESIS    = 0x0C;
-const uint8_t AS5600_CONF_OUTPUT_MODE   = 0x30;
-const uint8_t AS5600_CONF_PWM_FREQUENCY = 0xC0;
-const uint8_t AS5600_CONF_SLOW_FILTER   = 0x03;
-const uint8_t AS5600_CONF_FAST_FILTER   = 0x1C;
-const uint8_t AS5600_CONF_WATCH_DOG     = 0x20;
+//  CONFIGURATION BIT MASKS - word level, 0x07 = high byte
+const uint16_t AS5600_CONF_POWER_MODE    = 0x0003;
+const uint16_t AS5600_CONF_HYSTERESIS    = 0x000C;
+const uint16_t AS5600_CONF_OUTPUT_MODE   = 0x0030;
+const uint16_t AS5600_CONF_PWM_FREQUENCY = 0x00C0;
+const uint16_t AS5600_CONF_SLOW_FILTER   = 0x0300;
+const uint16_t AS5600_CONF_FAST_FILTER   = 0x1C00;
+const uint16_t AS5600_CONF_WATCH_DOG     = 0x2000;
 
 
 //  UNKNOWN REGISTERS 0x09-0x0A
@@ -165,15 +169,17 @@ uint16_t AS5600::getMaxAngle()
 bool AS5600::setConfigure(uint16_t value)
 {
   if (value > 0x3FFF) return false;
-  writeReg2(AS5600_CONF, value);
+  _conf = value;
+  _confValid = true;
+  _confDirty = true;
+  if (_autoCommit) commit();
   return true;
 }
 
 
 uint16_t AS5600::getConfigure()
 {
-  uint16_t value = readReg2(AS5600_CONF) & 0x3FFF;
-  return value;
+  return readConf();
 }
 
 
@@ -181,119 +187,156 @@ uint16_t AS5600::getConfigure()
 bool AS5600::setPowerMode(uint8_t powerMode)
 {
   if (powerMode > 3) return false;
-  uint8_t value = readReg(AS5600_CONF + 1);
-  value &= ~AS5600_CONF_POWER_MODE;
-  value |= powerMode;
-  writeReg(AS5600_CONF + 1, value);
+  updateConf(AS5600_CONF_POWER_MODE, powerMode);
   return true;
 }
 
 
 uint8_t AS5600::getPowerMode()
 {
-  return readReg(AS5600_CONF + 1) & 0x03;
+  return readConf() & 0x03;
 }
 
 
 bool AS5600::setHysteresis(uint8_t hysteresis)
 {
   if (hysteresis > 3) return false;
-  uint8_t value = readReg(AS5600_CONF + 1);
-  value &= ~AS5600_CONF_HYSTERESIS;
-  value |= (hysteresis << 2);
-  writeReg(AS5600_CONF + 1, value);
+  updateConf(AS5600_CONF_HYSTERESIS, hysteresis << 2);
   return true;
 }
 
 
 uint8_t AS5600::getHysteresis()
 {
-  return (readReg(AS5600_CONF + 1) >> 2) & 0x03;
+  return (readConf() >> 2) & 0x03;
 }
 
 
 bool AS5600::setOutputMode(uint8_t outputMode)
 {
   if (outputMode > 2) return false;
-  uint8_t value = readReg(AS5600_CONF + 1);
-  value &= ~AS5600_CONF_OUTPUT_MODE;
-  value |= (outputMode << 4);
-  writeReg(AS5600_CONF + 1, value);
+  updateConf(AS5600_CONF_OUTPUT_MODE, outputMode << 4);
   return true;
 }
 
 
 uint8_t AS5600::getOutputMode()
 {
-  return (readReg(AS5600_CONF + 1) >> 4) & 0x03;
+  return (readConf() >> 4) & 0x03;
 }
 
 
 bool AS5600::setPWMFrequency(uint8_t pwmFreq)
 {
   if (pwmFreq > 3) return false;
-  uint8_t value = readReg(AS5600_CONF + 1);
-  value &= ~AS5600_CONF_PWM_FREQUENCY;
-  value |= (pwmFreq << 6);
-  writeReg(AS5600_CONF + 1, value);
+  updateConf(AS5600_CONF_PWM_FREQUENCY, pwmFreq << 6);
   return true;
 }
 
 
 uint8_t AS5600::getPWMFrequency()
 {
-  return (readReg(AS5600_CONF + 1) >> 6) & 0x03;
+  return (readConf() >> 6) & 0x03;
 }
 
 
 bool AS5600::setSlowFilter(uint8_t mask)
 {
   if (mask > 3) return false;
-  uint8_t value = readReg(AS5600_CONF);
-  value &= ~AS5600_CONF_SLOW_FILTER;
-  value |= mask;
-  writeReg(AS5600_CONF, value);
+  updateConf(AS5600_CONF_SLOW_FILTER, mask << 8);
   return true;
 }
 
 
 uint8_t AS5600::getSlowFilter()
 {
-  return readReg(AS5600_CONF) & 0x03;
+  return (readConf() >> 8) & 0x03;
 }
 
 
 bool AS5600::setFastFilter(uint8_t mask)
 {
   if (mask > 7) return false;
-  uint8_t value = readReg(AS5600_CONF);
-  value &= ~AS5600_CONF_FAST_FILTER;
-  value |= (mask << 2);
-  writeReg(AS5600_CONF, value);
+  updateConf(AS5600_CONF_FAST_FILTER, mask << 10);
   return true;
 }
 
 
 uint8_t AS5600::getFastFilter()
 {
-  return (readReg(AS5600_CONF) >> 2) & 0x07;
+  return (readConf() >> 10) & 0x07;
 }
 
 
 bool AS5600::setWatchDog(uint8_t mask)
 {
   if (mask > 1) return false;
-  uint8_t value = readReg(AS5600_CONF);
-  value &= ~AS5600_CONF_WATCH_DOG;
-  value |= (mask << 5);
-  writeReg(AS5600_CONF, value);
+  updateConf(AS5600_CONF_WATCH_DOG, mask << 13);
   return true;
 }
 
 
 uint8_t AS5600::getWatchDog()
 {
-  return (readReg(AS5600_CONF) >> 5) & 0x01;
+  return (readConf() >> 13) & 0x01;
+}
+
+
+//  configuration cache
+void AS5600::setAutoCommit(bool autoCommit)
+{
+  _autoCommit = autoCommit;
+}
+
+
+bool AS5600::getAutoCommit()
+{
+  return _autoCommit;
+}
+
+
+bool AS5600::commit()
+{
+  if (!_confDirty) return true;
+  if (writeReg2(AS5600_CONF, _conf) != AS5600_OK) return false;
+  _confDirty = false;
+  return true;
+}
+
+
+bool AS5600::refresh()
+{
+  uint16_t value = readReg2(AS5600_CONF);
+  if (_error != AS5600_OK)
+  {
+    _confValid = false;
+    return false;
+  }
+  _conf = value & 0x3FFF;
+  _confValid = true;
+  _confDirty = false;
+  return true;
+}
+
+
+uint16_t AS5600::readConf()
+{
+  if (!_confValid) refresh();
+  return _conf;
+}
+
+
+void AS5600::updateConf(uint16_t mask, uint16_t value)
+{
+  //  without a valid copy the other fields would be overwritten.
+  if (!_confValid && !refresh()) return;
+  uint16_t conf = (_conf & ~mask) | value;
+  if (conf != _conf)
+  {
+    _conf = conf;
+    _confDirty = true;
+  }
+  if (_autoCommit) commit();
 }
 
 
@@ -303,16 +346,8 @@ uint8_t AS5600::getWatchDog()
 //
 uint16_t AS5600::rawAngle()
 {
-  int16_t value = readReg2(AS5600_RAW_ANGLE);
-  if (_offset > 0) value += _offset;
-  value &= 0x0FFF;
-
-  if ((_directionPin == AS5600_SW_DIRECTION_PIN) &&
-      (_direction == AS5600_COUNTERCLOCK_WISE))
-  {
-    value = (4096 - value) & 0x0FFF;
-  }
-  return value;
+  uint16_t value = readReg2(AS5600_RAW_ANGLE);
+  return adjustAngle(value);
 }
 
 
@@ -323,15 +358,7 @@ uint16_t AS5600::readAngle()
   {
     return _lastReadAngle;
   }
-  if (_offset > 0) value += _offset;
-  value &= 0x0FFF;
-
-  if ((_directionPin == AS5600_SW_DIRECTION_PIN) &&
-      (_direction == AS5600_COUNTERCLOCK_WISE))
-  {
-    //  mask needed for value == 0.
-    value = (4096 - value) & 0x0FFF;
-  }
+  value = adjustAngle(value);
   _lastReadAngle = value;
   return value;
 }
@@ -408,6 +435,174 @@ bool AS5600::magnetTooWeak()
 }
 
 
+/////////////////////////////////////////////////////////
+//
+//  FRAME
+//
+bool AS5600::readFrame(AS5600Frame &frame)
+{
+  //  The address pointer only stays on RAW ANGLE, ANGLE and MAGNITUDE
+  //  when it is set to their high byte. Starting at STATUS it increments
+  //  over all registers, including the unknown 0x10 .. 0x19.
+  uint8_t buffer[AS5600_FRAME_SIZE];
+  if (readRegs(AS5600_STATUS, buffer, AS5600_FRAME_SIZE) != AS5600_OK)
+  {
+    return false;
+  }
+  decodeFrame(buffer, frame);
+  return true;
+}
+
+
+/////////////////////////////////////////////////////////
+//
+//  STREAMING
+//
+//  The pointer does not increment after reading ANGLE, RAW ANGLE or
+//  MAGNITUDE if it was set to their high byte, see datasheet.
+//
+bool AS5600::beginStream(uint8_t mode)
+{
+  _streamReg = (mode == AS5600_STREAM_RAW_ANGLE) ? AS5600_RAW_ANGLE : AS5600_ANGLE;
+  return (writePointer(_streamReg) == AS5600_OK);
+}
+
+
+void AS5600::endStream()
+{
+  _streamReg = 0;
+  _streamPointer = false;
+}
+
+
+bool AS5600::isStreaming()
+{
+  return (_streamReg != 0);
+}
+
+
+uint16_t AS5600::readStream()
+{
+  if (_streamReg == 0) return readAngle();
+  if (!_streamPointer && (writePointer(_streamReg) != AS5600_OK))
+  {
+    return _lastReadAngle;
+  }
+  uint8_t buffer[2];
+  if (readNext(buffer, 2) != AS5600_OK)
+  {
+    return _lastReadAngle;
+  }
+  uint16_t value = ((buffer[0] << 8) | buffer[1]) & 0x0FFF;
+  value = adjustAngle(value);
+  if (_streamReg == AS5600_ANGLE)
+  {
+    _lastReadAngle = value;
+  }
+  return value;
+}
+
+
+/////////////////////////////////////////////////////////
+//
+//  ASYNCHRONOUS READ
+//
+bool AS5600::beginAsync(uint8_t port)
+{
+#if defined(AS5600_ASYNC_DRIVER)
+  if (_asyncTask != NULL) return true;
+  _asyncPort = port;
+  //  same core as the caller, the transfer itself is interrupt driven.
+  BaseType_t rv = xTaskCreatePinnedToCore(asyncTask, "AS5600", 2048, this,
+                                          uxTaskPriorityGet(NULL) + 1,
+                                          &_asyncTask, xPortGetCoreID());
+  if (rv != pdPASS)
+  {
+    _asyncTask = NULL;
+    return false;
+  }
+  return true;
+#else
+  (void) port;
+  return false;
+#endif
+}
+
+
+bool AS5600::startRead(uint8_t what)
+{
+  if (_asyncState == AS5600_ASYNC_BUSY) return false;
+  _asyncWhat = what;
+  _asyncState = AS5600_ASYNC_BUSY;
+  bool started;
+  if (what == AS5600_ASYNC_FRAME)
+  {
+    started = startTransfer(AS5600_STATUS, AS5600_FRAME_SIZE);
+  }
+  else
+  {
+    started = startTransfer(AS5600_ANGLE, 2);
+  }
+  if (!started)
+  {
+    _asyncState = AS5600_ASYNC_IDLE;
+    if (_error == AS5600_OK) _error = AS5600_ERROR_I2C_ASYNC;
+    return false;
+  }
+  return true;
+}
+
+
+uint8_t AS5600::poll()
+{
+  if (_asyncState != AS5600_ASYNC_BUSY) return AS5600_ASYNC_IDLE;
+
+  uint8_t state = transferState();
+  if (state == AS5600_ASYNC_BUSY) return state;
+
+  _asyncState = AS5600_ASYNC_IDLE;
+  //  synchronous fallback keeps the error of readRegs()
+  if ((state == AS5600_ASYNC_ERROR) && (_error == AS5600_OK))
+  {
+    _error = AS5600_ERROR_I2C_ASYNC;
+  }
+  if (state == AS5600_ASYNC_READY)
+  {
+    if (_asyncWhat == AS5600_ASYNC_FRAME)
+    {
+      decodeFrame(_asyncBuffer, _asyncFrame);
+    }
+    else
+    {
+      uint16_t angle = ((_asyncBuffer[0] << 8) | _asyncBuffer[1]) & 0x0FFF;
+      _asyncFrame.angle = adjustAngle(angle);
+      _lastReadAngle = _asyncFrame.angle;
+    }
+  }
+  if (_callback != NULL) _callback(this, _context);
+  return state;
+}
+
+
+void AS5600::setCallback(AS5600_callback callback, void * context)
+{
+  _callback = callback;
+  _context  = context;
+}
+
+
+uint16_t AS5600::asyncAngle()
+{
+  return _asyncFrame.angle;
+}
+
+
+AS5600Frame AS5600::asyncFrame()
+{
+  return _asyncFrame;
+}
+
+
 /////////////////////////////////////////////////////////
 //
 //  BURN COMMANDS
@@ -553,6 +748,7 @@ int AS5600::lastError()
 uint8_t AS5600::readReg(uint8_t reg)
 {
   _error = AS5600_OK;
+  _streamPointer = false;
   _wire->beginTransmission(_address);
   _wire->write(reg);
   if (_wire->endTransmission() != 0)
@@ -574,6 +770,7 @@ uint8_t AS5600::readReg(uint8_t reg)
 uint16_t AS5600::readReg2(uint8_t reg)
 {
   _error = AS5600_OK;
+  _streamPointer = false;
   _wire->beginTransmission(_address);
   _wire->write(reg);
   if (_wire->endTransmission() != 0)
@@ -597,6 +794,7 @@ uint16_t AS5600::readReg2(uint8_t reg)
 uint8_t AS5600::writeReg(uint8_t reg, uint8_t value)
 {
   _error = AS5600_OK;
+  _streamPointer = false;
   _wire->beginTransmission(_address);
   _wire->write(reg);
   _wire->write(value);
@@ -611,6 +809,7 @@ uint8_t AS5600::writeReg(uint8_t reg, uint8_t value)
 uint8_t AS5600::writeReg2(uint8_t reg, uint16_t value)
 {
   _error = AS5600_OK;
+  _streamPointer = false;
   _wire->beginTransmission(_address);
   _wire->write(reg);
   _wire->write(value >> 8);
@@ -623,6 +822,155 @@ uint8_t AS5600::writeReg2(uint8_t reg, uint16_t value)
 }
 
 
+uint8_t AS5600::readRegs(uint8_t reg, uint8_t * buffer, uint8_t count)
+{
+  _error = AS5600_OK;
+  _streamPointer = false;
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  if (_wire->endTransmission() != 0)
+  {
+    _error = AS5600_ERROR_I2C_READ_4;
+    return _error;
+  }
+  uint8_t n = _wire->requestFrom(_address, count);
+  if (n != count)
+  {
+    _error = AS5600_ERROR_I2C_READ_5;
+    return _error;
+  }
+  for (uint8_t i = 0; i < count; i++)
+  {
+    buffer[i] = _wire->read();
+  }
+  return _error;
+}
+
+
+void AS5600::decodeFrame(const uint8_t * buffer, AS5600Frame &frame)
+{
+  //  offsets in buffer = register - AS5600_STATUS
+  uint16_t raw   = ((buffer[1] << 8) | buffer[2]) & 0x0FFF;
+  uint16_t angle = ((buffer[3] << 8) | buffer[4]) & 0x0FFF;
+
+  frame.status    = buffer[0];
+  frame.rawAngle  = adjustAngle(raw);
+  frame.angle     = adjustAngle(angle);
+  frame.agc       = buffer[15];
+  frame.magnitude = ((buffer[16] << 8) | buffer[17]) & 0x0FFF;
+
+  _lastReadAngle = frame.angle;
+}
+
+
+bool AS5600::startTransfer(uint8_t reg, uint8_t count)
+{
+  _streamPointer = false;
+  _asyncReg   = reg;
+  _asyncCount = count;
+#if defined(AS5600_ASYNC_DRIVER)
+  if (_asyncTask != NULL)
+  {
+    _error = AS5600_OK;
+    __atomic_store_n(&_transferState, AS5600_ASYNC_BUSY, __ATOMIC_RELEASE);
+    xTaskNotifyGive(_asyncTask);
+    return true;
+  }
+#endif
+  //  synchronous fallback
+  readRegs(reg, _asyncBuffer, count);
+  _transferState = (_error == AS5600_OK) ? AS5600_ASYNC_READY : AS5600_ASYNC_ERROR;
+  return true;
+}
+
+
+uint8_t AS5600::transferState()
+{
+  return __atomic_load_n(&_transferState, __ATOMIC_ACQUIRE);
+}
+
+
+#if defined(AS5600_ASYNC_DRIVER)
+void AS5600::asyncTask(void * parameter)
+{
+  AS5600 * sensor = (AS5600 *) parameter;
+  //  start, address, register, restart, address, read, stop
+  uint8_t link[I2C_LINK_RECOMMENDED_SIZE(7)];
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link, sizeof(link));
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (sensor->_address << 1) | I2C_MASTER_WRITE, true);
+    i2c_master_write_byte(cmd, sensor->_asyncReg, true);
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, (sensor->_address << 1) | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, sensor->_asyncBuffer, sensor->_asyncCount, I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+    //  blocks this task only, the driver waits for the I2C interrupt.
+    esp_err_t rv = i2c_master_cmd_begin((i2c_port_t) sensor->_asyncPort, cmd,
+                                        pdMS_TO_TICKS(AS5600_ASYNC_TIMEOUT));
+    i2c_cmd_link_delete_static(cmd);
+
+    __atomic_store_n(&sensor->_transferState,
+                     (uint8_t) (rv == ESP_OK ? AS5600_ASYNC_READY : AS5600_ASYNC_ERROR),
+                     __ATOMIC_RELEASE);
+  }
+}
+#endif
+
+
+uint8_t AS5600::writePointer(uint8_t reg)
+{
+  _error = AS5600_OK;
+  _streamPointer = false;
+  _wire->beginTransmission(_address);
+  _wire->write(reg);
+  if (_wire->endTransmission() != 0)
+  {
+    _error = AS5600_ERROR_I2C_READ_2;
+    return _error;
+  }
+  _streamPointer = true;
+  return _error;
+}
+
+
+uint8_t AS5600::readNext(uint8_t * buffer, uint8_t count)
+{
+  _error = AS5600_OK;
+  uint8_t n = _wire->requestFrom(_address, count);
+  if (n != count)
+  {
+    _error = AS5600_ERROR_I2C_READ_3;
+    //  pointer state unknown
+    _streamPointer = false;
+    return _error;
+  }
+  for (uint8_t i = 0; i < count; i++)
+  {
+    buffer[i] = _wire->read();
+  }
+  return _error;
+}
+
+
+uint16_t AS5600::adjustAngle(uint16_t value)
+{
+  if (_offset > 0) value += _offset;
+  value &= 0x0FFF;
+
+  if ((_directionPin == AS5600_SW_DIRECTION_PIN) &&
+      (_direction == AS5600_COUNTERCLOCK_WISE))
+  {
+    //  mask needed for value == 0.
+    value = (4096 - value) & 0x0FFF;
+  }
+  return value;
+}
+
+
 /////////////////////////////////////////////////////////////////////////////
 //
 //  AS5600L
@@ -2,7 +2,7 @@
 //
 //    FILE: AS5600.h
 //  AUTHOR: Rob Tillaart
-// VERSION: 0.6.6
+// VERSION: 0.7.0
 // PURPOSE: Arduino library for AS5600 magnetic rotation meter
 //    DATE: 2022-05-28
 //     URL: https://github.com/RobTillaart/AS5600
@@ -11,8 +11,17 @@
 #include "Arduino.h"
 #include "Wire.h"
 
+#if defined(ESP32)
+#include "esp_idf_version.h"
+//  startRead() uses the IDF I2C driver that Wire is built on.
+//  IDF 5 / arduino-esp32 3.x use a new driver => synchronous fallback.
+#if ESP_IDF_VERSION_MAJOR < 5
+#define AS5600_ASYNC_DRIVER             1
+#endif
+#endif
 
-#define AS5600_LIB_VERSION              (F("0.6.6"))
+
+#define AS5600_LIB_VERSION              (F("0.7.0"))
 
 
 //  default addresses
@@ -44,8 +53,48 @@ const int     AS5600_ERROR_I2C_READ_0   = -100;
 const int     AS5600_ERROR_I2C_READ_1   = -101;
 const int     AS5600_ERROR_I2C_READ_2   = -102;
 const int     AS5600_ERROR_I2C_READ_3   = -103;
+const int     AS5600_ERROR_I2C_READ_4   = -104;
+const int     AS5600_ERROR_I2C_READ_5   = -105;
 const int     AS5600_ERROR_I2C_WRITE_0  = -200;
 const int     AS5600_ERROR_I2C_WRITE_1  = -201;
+const int     AS5600_ERROR_I2C_ASYNC    = -300;
+
+
+//  readFrame
+//  registers 0x0B STATUS .. 0x1C MAGNITUDE in one burst
+const uint8_t AS5600_FRAME_SIZE         = 18;
+
+struct AS5600Frame
+{
+  uint8_t  status;
+  uint16_t rawAngle;     //  offset + software direction applied
+  uint16_t angle;        //  offset + software direction applied
+  uint8_t  agc;
+  uint16_t magnitude;
+} __attribute__((packed));
+
+
+//  beginStream()
+const uint8_t AS5600_STREAM_ANGLE       = 0;
+const uint8_t AS5600_STREAM_RAW_ANGLE   = 1;
+
+//  startRead()
+const uint8_t AS5600_ASYNC_ANGLE        = 0;
+const uint8_t AS5600_ASYNC_FRAME        = 1;
+
+//  poll()
+const uint8_t AS5600_ASYNC_IDLE         = 0;
+const uint8_t AS5600_ASYNC_BUSY         = 1;
+const uint8_t AS5600_ASYNC_READY        = 2;
+const uint8_t AS5600_ASYNC_ERROR        = 3;
+
+//  timeout of one asynchronous transfer in milliseconds.
+#ifndef AS5600_ASYNC_TIMEOUT
+#define AS5600_ASYNC_TIMEOUT            10
+#endif
+
+class AS5600;
+typedef void (*AS5600_callback)(AS5600 * sensor, void * context);
 
 
 //  CONFIGURE CONSTANTS
@@ -185,6 +234,20 @@ public:
   bool     setWatchDog(uint8_t mask);
   uint8_t  getWatchDog();
 
+  //  EXPERIMENTAL 0.7.0 - CONFIGURATION CACHE
+  //  the setters and getters above work on a copy of CONF,
+  //  read from the device on first use.
+  //  autoCommit = true  (default) every setter writes CONF.
+  //  autoCommit = false setters only change the copy until commit().
+  void     setAutoCommit(bool autoCommit = true);
+  bool     getAutoCommit();
+  //  writes CONF in one transaction if the copy has changed.
+  //  returns false on I2C error.
+  bool     commit();
+  //  reads CONF from the device, discards uncommitted changes.
+  //  returns false on I2C error.
+  bool     refresh();
+
 
   //  READ OUTPUT REGISTERS
   uint16_t rawAngle();
@@ -210,6 +273,49 @@ public:
   bool     magnetTooWeak();
 
 
+  //  EXPERIMENTAL 0.7.0
+  //  reads STATUS, RAW ANGLE, ANGLE, AGC and MAGNITUDE
+  //  in a single I2C transaction (18 bytes).
+  //  returns false on I2C error, frame is not changed then.
+  //  updates the angle used by getCumulativePosition(false)
+  //  and getAngularSpeed(mode, false).
+  bool     readFrame(AS5600Frame &frame);
+
+
+  //  EXPERIMENTAL 0.7.0 - STREAMING
+  //  sets the register pointer once to ANGLE or RAW ANGLE,
+  //  thereafter readStream() only reads the two data bytes.
+  //  any other register access moves the pointer, the next
+  //  readStream() sets it again.
+  //  mode = AS5600_STREAM_ANGLE or AS5600_STREAM_RAW_ANGLE
+  bool     beginStream(uint8_t mode = AS5600_STREAM_ANGLE);
+  void     endStream();
+  bool     isStreaming();
+  //  offset and software direction applied.
+  //  not streaming: same as readAngle().
+  uint16_t readStream();
+
+
+  //  EXPERIMENTAL 0.7.0 - ASYNCHRONOUS READ
+  //  ESP32 (IDF 4.x): a worker task runs the transfer on the I2C driver
+  //  so the caller can do other work until poll() returns READY.
+  //  port = I2C port Wire is using, call after Wire.begin().
+  //  other platforms: returns false, startRead() reads synchronously.
+  bool     beginAsync(uint8_t port = 0);
+  //  what = AS5600_ASYNC_ANGLE or AS5600_ASYNC_FRAME
+  //  returns false if a read is still busy or could not be started,
+  //  see lastError().
+  bool     startRead(uint8_t what = AS5600_ASYNC_ANGLE);
+  //  returns READY or ERROR once when the transfer is done,
+  //  BUSY before and IDLE after. Calls the callback when done.
+  uint8_t  poll();
+  void     setCallback(AS5600_callback callback, void * context = NULL);
+  //  results of the last successful asynchronous read.
+  //  ANGLE updates only the angle.
+  uint16_t asyncAngle();
+  AS5600Frame asyncFrame();
+
+
   //  BURN COMMANDS
   //  DO NOT UNCOMMENT - USE AT OWN RISK - READ DATASHEET
   //  use getZMCO() to get the counter how often ZPOS/MPOS is "burned".
@@ -246,6 +352,52 @@ protected:
   virtual uint16_t readReg2(uint8_t reg);
   virtual uint8_t  writeReg(uint8_t reg, uint8_t value);
   virtual uint8_t  writeReg2(uint8_t reg, uint16_t value);
+  virtual uint8_t  readRegs(uint8_t reg, uint8_t * buffer, uint8_t count);
+  //  streaming, write pointer only / read without pointer.
+  //  functions that move the pointer must clear _streamPointer.
+  virtual uint8_t  writePointer(uint8_t reg);
+  virtual uint8_t  readNext(uint8_t * buffer, uint8_t count);
+
+  //  streaming, 0 = off
+  uint8_t  _streamReg       = 0;
+  bool     _streamPointer   = false;
+
+  //  configuration cache
+  uint16_t readConf();
+  void     updateConf(uint16_t mask, uint16_t value);
+
+  uint16_t _conf            = 0;
+  bool     _confValid       = false;
+  bool     _confDirty       = false;
+  bool     _autoCommit      = true;
+
+  //  applies offset and software direction.
+  uint16_t adjustAngle(uint16_t value);
+  void     decodeFrame(const uint8_t * buffer, AS5600Frame &frame);
+
+  //  asynchronous transport, made virtual to allow other drivers.
+  //  startTransfer() reads count bytes from reg into _asyncBuffer,
+  //  returns false if the transfer could not be started.
+  //  transferState() returns AS5600_ASYNC_BUSY, _READY or _ERROR.
+  virtual bool     startTransfer(uint8_t reg, uint8_t count);
+  virtual uint8_t  transferState();
+
+  uint8_t  _asyncBuffer[AS5600_FRAME_SIZE];
+  uint8_t  _asyncReg        = 0;
+  uint8_t  _asyncCount      = 0;
+  uint8_t  _asyncWhat       = AS5600_ASYNC_ANGLE;
+  uint8_t  _asyncState      = AS5600_ASYNC_IDLE;
+  //  written by the worker task on ESP32
+  volatile uint8_t _transferState = AS5600_ASYNC_IDLE;
+  AS5600Frame      _asyncFrame = { 0, 0, 0, 0, 0 };
+  AS5600_callback  _callback = NULL;
+  void *           _context  = NULL;
+
+#if defined(AS5600_ASYNC_DRIVER)
+  static void asyncTask(void * parameter);
+  TaskHandle_t     _asyncTask = NULL;
+  uint8_t          _asyncPort = 0;
+#endif
 
   uint8_t  _address         = AS5600_DEFAULT_ADDRESS;
   uint8_t  _directionPin    = 255;
@@ -0,0 +1,80 @@
+//
+//    FILE: AS5600_async_read.ino
+// PURPOSE: demo asynchronous read, count work done while the I2C bus is busy.
+//     URL: https://github.com/RobTillaart/AS5600
+//
+//  Examples may use AS5600 or AS5600L devices.
+//  Check if your sensor matches the one used in the example.
+//  Optionally adjust the code.
+//
+//  On ESP32 (IDF 4.x) the transfer runs in a worker task,
+//  on other boards startRead() reads synchronously.
+
+
+#include "AS5600.h"
+
+
+AS5600 as5600;   //  use default Wire
+
+volatile uint32_t reads = 0;
+
+
+void onRead(AS5600 * sensor, void * context)
+{
+  (void) sensor;
+  (void) context;
+  reads++;
+}
+
+
+void setup()
+{
+  while(!Serial);
+  Serial.begin(115200);
+  Serial.println();
+  Serial.println(__FILE__);
+  Serial.print("AS5600_LIB_VERSION: ");
+  Serial.println(AS5600_LIB_VERSION);
+  Serial.println();
+
+  Wire.begin();
+
+  as5600.begin(4);  //  set direction pin.
+  as5600.setDirection(AS5600_CLOCK_WISE);
+  Serial.print("Connect: ");
+  Serial.println(as5600.isConnected());
+  Serial.print("Async: ");
+  Serial.println(as5600.beginAsync(0));   //  Wire uses I2C port 0
+  as5600.setCallback(onRead);
+  delay(1000);
+}
+
+
+void loop()
+{
+  uint32_t work = 0;
+  uint32_t start = micros();
+
+  as5600.startRead(AS5600_ASYNC_FRAME);
+  while (as5600.poll() == AS5600_ASYNC_BUSY)
+  {
+    work++;   //  other work goes here
+  }
+  uint32_t duration = micros() - start;
+
+  AS5600Frame frame = as5600.asyncFrame();
+  Serial.print(frame.angle);
+  Serial.print("\t");
+  Serial.print(frame.status, HEX);
+  Serial.print("\t");
+  Serial.print(duration);
+  Serial.print(" us\t");
+  Serial.print(work);
+  Serial.print(" loops\t");
+  Serial.println(reads);
+
+  delay(1000);
+}
+
+
+//  -- END OF FILE --
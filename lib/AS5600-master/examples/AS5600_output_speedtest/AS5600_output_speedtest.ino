@@ -11,6 +11,7 @@
 //  Check if your sensor matches the one used in the example.
 //  Optionally adjust the code.
 //  (minor edits by Rob)
+//  0.7.0 added sample rate classic versus streaming register read.
 
 
 #include <Arduino.h>
@@ -187,6 +188,36 @@ float measureAnalogAngle()
 }
 
 
+//  samples per second, classic readAngle() versus readStream()
+//  which sets the register pointer only once.
+void measureSampleRate()
+{
+  const uint32_t samples = 1000;
+
+  uint32_t start = micros();
+  for (uint32_t i = 0; i < samples; i++)
+  {
+    as5600.readAngle();
+  }
+  uint32_t classicTime = micros() - start;
+
+  as5600.beginStream(AS5600_STREAM_ANGLE);
+  start = micros();
+  for (uint32_t i = 0; i < samples; i++)
+  {
+    as5600.readStream();
+  }
+  uint32_t streamTime = micros() - start;
+  as5600.endStream();
+
+  Serial.print("classic   readAngle()  samples/s: ");
+  Serial.println(samples * 1e6 / classicTime);
+  Serial.print("streaming readStream() samples/s: ");
+  Serial.println(samples * 1e6 / streamTime);
+  Serial.println();
+}
+
+
 void loop()
 {
   if ( !bOutmodeAnalog)
@@ -491,6 +522,8 @@ void loop()
           Serial.print(" (");
           Serial.print(iNmax);
           Serial.println(")");
+          Serial.println();
+          measureSampleRate();
           bOutmodeAnalog = false;
           bOutmodePWM = false;
           bHighFreq = false;
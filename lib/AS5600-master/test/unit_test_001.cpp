@@ -281,6 +281,364 @@ unittest(test_failing_set_commands)
 }
 
 
+//  STUB: serves reads from a register map and counts I2C traffic.
+class AS5600_stub : public AS5600
+{
+public:
+  uint8_t  regs[256];
+  uint32_t transactions = 0;
+  uint32_t bytes = 0;       //  pointer writes + data bytes
+
+  AS5600_stub() : AS5600()
+  {
+    memset(regs, 0, sizeof(regs));
+  }
+
+  void set2(uint8_t reg, uint16_t value)
+  {
+    regs[reg] = value >> 8;
+    regs[reg + 1] = value & 0xFF;
+  }
+
+protected:
+  uint8_t readReg(uint8_t reg)
+  {
+    uint8_t value;
+    readRegs(reg, &value, 1);
+    return value;
+  }
+
+  uint16_t readReg2(uint8_t reg)
+  {
+    uint8_t value[2];
+    readRegs(reg, value, 2);
+    return (value[0] << 8) | value[1];
+  }
+
+  uint8_t readRegs(uint8_t reg, uint8_t * buffer, uint8_t count)
+  {
+    _error = AS5600_OK;
+    _streamPointer = false;
+    pointer = reg;
+    transactions++;
+    bytes += 1 + count;
+    clock += latency;       //  blocking
+    for (uint8_t i = 0; i < count; i++) buffer[i] = regs[reg + i];
+    return _error;
+  }
+
+  uint8_t writeReg(uint8_t reg, uint8_t value)
+  {
+    _error = AS5600_OK;
+    _streamPointer = false;
+    transactions++;
+    bytes += 2;
+    regs[reg] = value;
+    return _error;
+  }
+
+  uint8_t writeReg2(uint8_t reg, uint16_t value)
+  {
+    _error = AS5600_OK;
+    _streamPointer = false;
+    transactions++;
+    bytes += 3;
+    set2(reg, value);
+    return _error;
+  }
+
+  uint8_t writePointer(uint8_t reg)
+  {
+    _error = AS5600_OK;
+    transactions++;
+    bytes += 1;
+    pointer = reg;
+    _streamPointer = true;
+    return _error;
+  }
+
+  uint8_t readNext(uint8_t * buffer, uint8_t count)
+  {
+    _error = AS5600_OK;
+    transactions++;
+    bytes += count;
+    for (uint8_t i = 0; i < count; i++) buffer[i] = regs[pointer + i];
+    return _error;
+  }
+
+  //  simulated bus, transfer is done latency microseconds after start.
+  bool startTransfer(uint8_t reg, uint8_t count)
+  {
+    if (failStart) return false;
+    _error = AS5600_OK;
+    _asyncReg   = reg;
+    _asyncCount = count;
+    transactions++;
+    bytes += 1 + count;
+    done = clock + latency;
+    return true;
+  }
+
+  uint8_t transferState()
+  {
+    if (clock < done) return AS5600_ASYNC_BUSY;
+    if (failTransfer) return AS5600_ASYNC_ERROR;
+    for (uint8_t i = 0; i < _asyncCount; i++) _asyncBuffer[i] = regs[_asyncReg + i];
+    return AS5600_ASYNC_READY;
+  }
+
+public:
+  uint8_t  pointer = 0;     //  register pointer of the device
+  uint32_t clock   = 0;     //  simulated microseconds
+  uint32_t latency = 0;
+  uint32_t done    = 0;
+  bool     failStart    = false;
+  bool     failTransfer = false;
+};
+
+
+void count_callback(AS5600 * sensor, void * context)
+{
+  (void) sensor;
+  (*(int *) context)++;
+}
+
+
+unittest(test_readFrame)
+{
+  AS5600_stub as5600;
+
+  as5600.begin();
+  as5600.regs[0x0B] = 0x20;        //  magnet detected
+  as5600.set2(0x0C, 1000);
+  as5600.set2(0x0E, 1010);
+  as5600.regs[0x1A] = 128;
+  as5600.set2(0x1B, 2000);
+
+  AS5600Frame frame;
+  assertTrue(as5600.readFrame(frame));
+  assertEqual(0x20, frame.status);
+  assertEqual(1000, frame.rawAngle);
+  assertEqual(1010, frame.angle);
+  assertEqual(128, frame.agc);
+  assertEqual(2000, frame.magnitude);
+
+  //  same values as the single register calls
+  as5600.setOffset(90);
+  as5600.setDirection(AS5600_COUNTERCLOCK_WISE);
+  assertTrue(as5600.readFrame(frame));
+  assertEqual(as5600.rawAngle(), frame.rawAngle);
+  assertEqual(as5600.readAngle(), frame.angle);
+  assertEqual(as5600.readStatus(), frame.status);
+  assertEqual(as5600.readAGC(), frame.agc);
+  assertEqual(as5600.readMagnitude(), frame.magnitude);
+}
+
+
+unittest(test_readFrame_bus_traffic)
+{
+  AS5600_stub as5600;
+  as5600.begin();
+
+  //  full sample with single register calls
+  as5600.readStatus();
+  as5600.rawAngle();
+  as5600.readAngle();
+  as5600.readAGC();
+  as5600.readMagnitude();
+  fprintf(stderr, "single: %u transactions, %u bytes\n",
+          (unsigned) as5600.transactions, (unsigned) as5600.bytes);
+  assertEqual(5, as5600.transactions);
+  assertEqual(13, as5600.bytes);
+
+  as5600.transactions = 0;
+  as5600.bytes = 0;
+  AS5600Frame frame;
+  as5600.readFrame(frame);
+  fprintf(stderr, " frame: %u transactions, %u bytes\n",
+          (unsigned) as5600.transactions, (unsigned) as5600.bytes);
+  assertEqual(1, as5600.transactions);
+  assertEqual(1 + AS5600_FRAME_SIZE, as5600.bytes);
+}
+
+
+unittest(test_async_overlap)
+{
+  AS5600_stub as5600;
+  as5600.begin();
+  as5600.set2(0x0E, 1234);
+  as5600.latency = 400;     //  microseconds per transfer
+
+  //  blocking read followed by 4 x 100 us other work
+  as5600.clock = 0;
+  assertEqual(1234, as5600.readAngle());
+  as5600.clock += 4 * 100;
+  uint32_t blocking = as5600.clock;
+
+  //  same work done while the transfer is running
+  int calls = 0;
+  as5600.setCallback(count_callback, &calls);
+  as5600.clock = 0;
+  assertTrue(as5600.startRead());
+  assertFalse(as5600.startRead());
+  uint8_t state;
+  while ((state = as5600.poll()) == AS5600_ASYNC_BUSY)
+  {
+    as5600.clock += 100;
+  }
+  uint32_t overlapped = as5600.clock;
+  fprintf(stderr, "blocking: %u us, async: %u us\n", (unsigned) blocking, (unsigned) overlapped);
+
+  assertEqual(AS5600_ASYNC_READY, state);
+  assertEqual(1234, as5600.asyncAngle());
+  assertEqual(1, calls);
+  assertEqual(AS5600_ASYNC_IDLE, as5600.poll());
+  assertEqual(800, blocking);
+  assertEqual(400, overlapped);
+
+  //  frame gives the same values as readFrame()
+  AS5600Frame frame;
+  as5600.regs[0x0B] = 0x20;
+  as5600.set2(0x1B, 2000);
+  assertTrue(as5600.readFrame(frame));
+  assertTrue(as5600.startRead(AS5600_ASYNC_FRAME));
+  as5600.clock += as5600.latency;
+  assertEqual(AS5600_ASYNC_READY, as5600.poll());
+  assertEqual(frame.status, as5600.asyncFrame().status);
+  assertEqual(frame.angle, as5600.asyncFrame().angle);
+  assertEqual(frame.magnitude, as5600.asyncFrame().magnitude);
+  assertEqual(2, calls);
+}
+
+
+unittest(test_async_error)
+{
+  AS5600_stub as5600;
+  as5600.begin();
+  as5600.set2(0x0E, 1234);
+  int calls = 0;
+  as5600.setCallback(count_callback, &calls);
+
+  //  transfer could not be started
+  as5600.failStart = true;
+  assertFalse(as5600.startRead());
+  assertEqual(AS5600_ERROR_I2C_ASYNC, as5600.lastError());
+  assertEqual(AS5600_ASYNC_IDLE, as5600.poll());
+  assertEqual(0, calls);
+
+  //  transfer failed in the worker
+  as5600.failStart = false;
+  as5600.failTransfer = true;
+  assertTrue(as5600.startRead());
+  assertEqual(AS5600_ASYNC_ERROR, as5600.poll());
+  assertEqual(AS5600_ERROR_I2C_ASYNC, as5600.lastError());
+  assertEqual(1, calls);
+
+  //  next read works again
+  as5600.failTransfer = false;
+  assertTrue(as5600.startRead());
+  assertEqual(AS5600_ASYNC_READY, as5600.poll());
+  assertEqual(AS5600_OK, as5600.lastError());
+  assertEqual(1234, as5600.asyncAngle());
+}
+
+
+unittest(test_configuration_cache)
+{
+  //  auto commit: one read, thereafter one write per setter
+  AS5600_stub as5600;
+  as5600.begin();
+  assertTrue(as5600.getAutoCommit());
+  as5600.setPowerMode(AS5600_POWERMODE_LOW1);
+  assertEqual(2, as5600.transactions);
+  as5600.setHysteresis(AS5600_HYST_LSB2);
+  assertEqual(3, as5600.transactions);
+  assertEqual(0x09, as5600.regs[0x08]);
+  assertEqual(AS5600_POWERMODE_LOW1, as5600.getPowerMode());
+  assertEqual(AS5600_HYST_LSB2, as5600.getHysteresis());
+  assertEqual(3, as5600.transactions);
+
+  //  batched: all setters + commit
+  AS5600_stub batch;
+  batch.begin();
+  batch.setAutoCommit(false);
+  batch.setPowerMode(AS5600_POWERMODE_LOW3);
+  batch.setHysteresis(AS5600_HYST_LSB1);
+  batch.setOutputMode(AS5600_OUTMODE_PWM);
+  batch.setPWMFrequency(AS5600_PWM_920);
+  batch.setSlowFilter(AS5600_SLOW_FILT_2X);
+  batch.setFastFilter(AS5600_FAST_FILT_LSB9);
+  batch.setWatchDog(AS5600_WATCHDOG_ON);
+  assertEqual(1, batch.transactions);
+  assertEqual(0, batch.regs[0x08]);
+  assertTrue(batch.commit());
+  fprintf(stderr, "configuration: %u transactions\n", (unsigned) batch.transactions);
+  assertEqual(2, batch.transactions);
+  assertEqual(0x2F, batch.regs[0x07]);
+  assertEqual(0xE7, batch.regs[0x08]);
+
+  //  getters use the copy, unchanged copy is not written again
+  assertEqual(AS5600_PWM_920, batch.getPWMFrequency());
+  assertEqual(AS5600_FAST_FILT_LSB9, batch.getFastFilter());
+  assertEqual(AS5600_WATCHDOG_ON, batch.getWatchDog());
+  assertEqual(0x2FE7, batch.getConfigure());
+  assertTrue(batch.commit());
+  assertEqual(2, batch.transactions);
+
+  //  refresh() reads the device again
+  batch.regs[0x08] = 0x00;
+  assertTrue(batch.refresh());
+  assertEqual(3, batch.transactions);
+  assertEqual(AS5600_POWERMODE_NOMINAL, batch.getPowerMode());
+  assertEqual(AS5600_SLOW_FILT_2X, batch.getSlowFilter());
+}
+
+
+unittest(test_streaming)
+{
+  AS5600_stub as5600;
+  as5600.begin();
+  as5600.set2(0x0C, 500);
+  as5600.set2(0x0E, 1000);
+
+  //  classic: pointer + data per sample
+  for (int i = 0; i < 10; i++) as5600.readAngle();
+  fprintf(stderr, "classic: %u transactions, %u bytes\n",
+          (unsigned) as5600.transactions, (unsigned) as5600.bytes);
+  assertEqual(10, as5600.transactions);
+  assertEqual(30, as5600.bytes);
+
+  //  streaming: pointer once
+  as5600.transactions = 0;
+  as5600.bytes = 0;
+  assertFalse(as5600.isStreaming());
+  assertTrue(as5600.beginStream());
+  assertTrue(as5600.isStreaming());
+  for (int i = 0; i < 10; i++) assertEqual(1000, as5600.readStream());
+  fprintf(stderr, " stream: %u transactions, %u bytes\n",
+          (unsigned) as5600.transactions, (unsigned) as5600.bytes);
+  assertEqual(11, as5600.transactions);
+  assertEqual(21, as5600.bytes);
+
+  //  other register access, pointer is set again
+  as5600.readStatus();
+  as5600.transactions = 0;
+  assertEqual(1000, as5600.readStream());
+  assertEqual(2, as5600.transactions);
+  assertEqual(1000, as5600.readStream());
+  assertEqual(3, as5600.transactions);
+
+  //  raw angle, offset applied
+  as5600.setOffset(90);
+  assertTrue(as5600.beginStream(AS5600_STREAM_RAW_ANGLE));
+  assertEqual(as5600.rawAngle(), as5600.readStream());
+
+  as5600.endStream();
+  assertFalse(as5600.isStreaming());
+  assertEqual(as5600.readAngle(), as5600.readStream());
+}
+
+
 //  FOR REMAINING ONE NEED A STUB
 
 
@@ -1311,6 +1311,50 @@ void WiFiManager::HTTPSend(const String &content){
   server->send(200, FPSTR(HTTP_HEAD_CT), content);
 }
 
+/**
+ * chunked page output, peak ram is the largest piece instead of the whole page
+ * and the client can start rendering before the page is complete
+ */
+void WiFiManager::HTTPSendBegin(){
+  server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server->send(200, FPSTR(HTTP_HEAD_CT), "");
+}
+
+// sends and clears content, so the same String can be reused for the next piece
+void WiFiManager::HTTPSendChunk(String &content){
+  if(content.length() > 0) server->sendContent(content);
+  content = "";
+}
+
+// same output as getHTTPHead(), the script and style go out straight from flash
+void WiFiManager::HTTPSendHead(String title, String classes){
+  String page = FPSTR(HTTP_HEAD_START);
+  page.replace(FPSTR(T_v), title);
+  HTTPSendChunk(page);
+  server->sendContent_P(HTTP_SCRIPT);
+  server->sendContent_P(HTTP_STYLE);
+  page += _customHeadElement;
+
+  String p = FPSTR(HTTP_HEAD_END);
+  if (_bodyClass != "") {
+    if (classes != "") {
+      classes += " ";  // add spacing, if necessary
+    }
+    classes += _bodyClass;  // add class str
+  }
+  p.replace(FPSTR(T_c), classes);
+  page += p;
+
+  if (_customBodyHeader) {
+    page += _customBodyHeader;
+  }
+  HTTPSendChunk(page);
+}
+
+void WiFiManager::HTTPSendEnd(){
+  server->sendContent(""); // zero length chunk ends the response
+}
+
 /** 
  * HTTPD handler for page requests
  */
@@ -1347,17 +1391,20 @@ void WiFiManager::handleRoot() {
   #endif
   if (captivePortal()) return; // If captive portal redirect instead of displaying the page
   handleRequest();
-  String page = getHTTPHead(_title, FPSTR(C_root)); // @token options @todo replace options with title
+  HTTPSendBegin();
+  HTTPSendHead(_title, FPSTR(C_root)); // @token options @todo replace options with title
+  String page;
   String str  = FPSTR(HTTP_ROOT_MAIN); // @todo custom title
   str.replace(FPSTR(T_t),_title);
   str.replace(FPSTR(T_v),configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())); // use ip if ap is not active for heading @todo use hostname?
   page += str;
   page += FPSTR(HTTP_PORTAL_OPTIONS);
   page += getMenuOut();
+  HTTPSendChunk(page);
   reportStatus(page);
   page += getHTTPEnd();
-
-  HTTPSend(page);
+  HTTPSendChunk(page);
+  HTTPSendEnd();
   if(_preloadwifiscan) WiFi_scanNetworks(_scancachetime,true); // preload wifiscan throttled, async
   // @todo buggy, captive portals make a query on every page load, causing this to run every time in addition to the real page load
   // I dont understand why, when you are already in the captive portal, I guess they want to know that its still up and not done or gone
@@ -1372,13 +1419,18 @@ void WiFiManager::handleWifi(boolean scan) {
   DEBUG_WM(WM_DEBUG_VERBOSE,F("<- HTTP Wifi"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlewifi), FPSTR(C_wifi)); // @token titlewifi
   if (scan) {
     #ifdef WM_DEBUG_LEVEL
     // DEBUG_WM(WM_DEBUG_DEV,"refresh flag:",server->hasArg(F("refresh")));
     #endif
     WiFi_scanNetworks(server->hasArg(F("refresh")),false); //wifiscan, force if arg refresh
-    page += getScanItemOut();
+  }
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titlewifi), FPSTR(C_wifi)); // @token titlewifi
+  String page;
+  if (scan) {
+    page = getScanItemOut(); // largest piece, grows with the number of networks, moved not copied
+    HTTPSendChunk(page);
   }
   String pitem = "";
 
@@ -1413,7 +1465,8 @@ void WiFiManager::handleWifi(boolean scan) {
   reportStatus(page);
   page += getHTTPEnd();
 
-  HTTPSend(page);
+  HTTPSendChunk(page);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(WM_DEBUG_DEV,F("Sent config page"));
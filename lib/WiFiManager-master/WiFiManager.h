@@ -674,6 +674,11 @@ public:
     void          handleNotFound();
 protected:
     void          HTTPSend(const String &content);
+    // chunked transfer, page is sent piece by piece as it is rendered
+    void          HTTPSendBegin();
+    void          HTTPSendChunk(String &content);
+    void          HTTPSendHead(String title, String classes);
+    void          HTTPSendEnd();
     void          handleRoot();
     void          handleWifi(boolean scan);
     void          handleWifiSave();
@@ -0,0 +1,101 @@
+// Valores del portal: en vivo por /eventos o, sin EventSource, consultando /datos
+function $(id) {
+  return document.getElementById(id);
+}
+
+function mostrar(d) {
+  if ('cajas' in d) {
+    $('cajas').textContent = d.cajas;
+  }
+  if ('angulo' in d) {
+    $('angulo').textContent = d.angulo;
+    $('grados').textContent = (d.angulo * 0.087890625).toFixed(1) + '°';
+  }
+  if ('conectado' in d) {
+    $('conectado').textContent = d.conectado ? 'Conectado' : 'No conectado';
+    $('conectado').style.color = d.conectado ? 'green' : 'red';
+    if (!d.conectado) {
+      $('angulo').textContent = '-';
+      $('grados').textContent = '-';
+    }
+  }
+  if ('libre' in d) {
+    $('libre').textContent = d.libre ? 'LIBRE' : 'OBSTÁCULO DETECTADO';
+    $('color').style.color = d.libre ? 'green' : 'red';
+  }
+}
+
+function consultar() {
+  fetch('/datos')
+    .then(function(r) { return r.json(); })
+    .then(mostrar)
+    .catch(function() {})
+    .then(function() { setTimeout(consultar, 2000); });
+}
+
+if (window.EventSource) {
+  var es = new EventSource('/eventos');
+  es.onopen = function() { $('enlace').textContent = 'Actualización en vivo'; };
+  es.onerror = function() { $('enlace').textContent = 'Sin conexión, reintentando...'; };
+  es.onmessage = function(e) { mostrar(JSON.parse(e.data)); };
+} else {
+  $('enlace').textContent = 'Actualización cada 2 segundos';
+  consultar();
+}
+
+// Historial: banda mínimo-máximo y línea de la media
+var temporizadorHistorial = null;
+
+function dibujarHistorial(h) {
+  var lienzo = $('grafica');
+  var ctx = lienzo.getContext('2d');
+  var serie = parseInt($('serie').value, 10);
+  var w = lienzo.width, alto = lienzo.height;
+  ctx.clearRect(0, 0, w, alto);
+
+  // Cajas: el contador es acumulado, se dibujan las del periodo (max - min)
+  var puntos = h.p.map(function(p) {
+    if (!p) return null;
+    if (serie === 0) { var c = p[1] - p[0]; return [c, c, c]; }
+    return [p[serie], p[serie + 1], p[serie + 2]];
+  });
+  var validos = puntos.filter(function(p) { return p; });
+  if (!validos.length) return;
+  var minimo = Math.min.apply(null, validos.map(function(p) { return p[0]; }));
+  var maximo = Math.max.apply(null, validos.map(function(p) { return p[1]; }));
+  if (maximo === minimo) { maximo += 1; }
+  var x = function(i) { return puntos.length > 1 ? i * (w - 1) / (puntos.length - 1) : 0; };
+  var y = function(v) { return alto - 10 - (v - minimo) * (alto - 20) / (maximo - minimo); };
+
+  ctx.fillStyle = '#cfe2ff';
+  puntos.forEach(function(p, i) {
+    if (p) ctx.fillRect(x(i) - 1, y(p[1]), 2, Math.max(1, y(p[0]) - y(p[1])));
+  });
+  ctx.strokeStyle = '#007bff';
+  ctx.beginPath();
+  var enTrazo = false;
+  puntos.forEach(function(p, i) {
+    if (!p) { enTrazo = false; return; }
+    if (enTrazo) ctx.lineTo(x(i), y(p[2])); else ctx.moveTo(x(i), y(p[2]));
+    enTrazo = true;
+  });
+  ctx.stroke();
+  ctx.fillStyle = '#666';
+  ctx.fillText(maximo, 2, 10);
+  ctx.fillText(minimo, 2, alto - 2);
+}
+
+function cargarHistorial() {
+  clearTimeout(temporizadorHistorial);
+  fetch('/history?nivel=' + $('nivel').value)
+    .then(function(r) { return r.json(); })
+    .then(function(h) {
+      dibujarHistorial(h);
+      temporizadorHistorial = setTimeout(cargarHistorial, Math.max(2, h.periodo) * 1000);
+    })
+    .catch(function() { temporizadorHistorial = setTimeout(cargarHistorial, 5000); });
+}
+
+$('serie').onchange = cargarHistorial;
+$('nivel').onchange = cargarHistorial;
+cargarHistorial();
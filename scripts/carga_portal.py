@@ -0,0 +1,93 @@
+# Prueba de carga del portal: N clientes con conexión persistente piden una
+# ruta sin parar durante unos segundos e informan peticiones/s y latencias.
+# Las respuestas con error cuentan aparte y no entran en las latencias.
+#
+#   python scripts/carga_portal.py http://192.168.4.1/datos -c 4 -d 10
+
+import argparse
+import http.client
+import threading
+import time
+from urllib.parse import urlparse
+
+
+def cliente(url, fin, latencias, errores, revalidadas, candado):
+    propias = []
+    fallos = 0
+    no_modificadas = 0
+    etag = None
+    conexion = None
+    while time.monotonic() < fin:
+        if conexion is None:
+            conexion = http.client.HTTPConnection(url.hostname, url.port or 80, timeout=5)
+        inicio = time.monotonic()
+        try:
+            # Como el navegador: acepta gzip y revalida con el ETag de la
+            # respuesta anterior si lo hubo
+            cabeceras = {"Accept-Encoding": "gzip"}
+            if etag:
+                cabeceras["If-None-Match"] = etag
+            conexion.request("GET", url.path or "/", headers=cabeceras)
+            respuesta = conexion.getresponse()
+            respuesta.read()
+            if respuesta.status >= 400:
+                fallos += 1
+            else:
+                propias.append(time.monotonic() - inicio)
+                if respuesta.status == 304:
+                    no_modificadas += 1
+                etag = respuesta.getheader("ETag", etag)
+            if respuesta.getheader("Connection", "").lower() == "close":
+                conexion.close()
+                conexion = None
+        except (OSError, http.client.HTTPException):
+            fallos += 1
+            conexion.close()
+            conexion = None
+    if conexion is not None:
+        conexion.close()
+    with candado:
+        latencias.extend(propias)
+        errores[0] += fallos
+        revalidadas[0] += no_modificadas
+
+
+def percentil(ordenadas, p):
+    if not ordenadas:
+        return 0.0
+    return ordenadas[min(len(ordenadas) - 1, int(len(ordenadas) * p / 100))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Prueba de carga del portal")
+    parser.add_argument("url", help="p. ej. http://192.168.4.1/")
+    parser.add_argument("-c", "--clientes", type=int, default=4)
+    parser.add_argument("-d", "--duracion", type=float, default=10.0, help="segundos")
+    args = parser.parse_args()
+
+    url = urlparse(args.url)
+    latencias = []
+    errores = [0]
+    revalidadas = [0]
+    candado = threading.Lock()
+    inicio = time.monotonic()
+    fin = inicio + args.duracion
+
+    hilos = [threading.Thread(target=cliente, args=(url, fin, latencias, errores, revalidadas, candado))
+             for _ in range(args.clientes)]
+    for hilo in hilos:
+        hilo.start()
+    for hilo in hilos:
+        hilo.join()
+    transcurrido = time.monotonic() - inicio
+
+    latencias.sort()
+    print("Peticiones: %d correctas (%d con 304), %d errores en %.1f s" % (
+        len(latencias), revalidadas[0], errores[0], transcurrido))
+    print("Peticiones/s: %.1f" % (len(latencias) / transcurrido))
+    print("Latencia p50 / p90 / p99 (ms): %.1f / %.1f / %.1f" % (
+        percentil(latencias, 50) * 1000, percentil(latencias, 90) * 1000, percentil(latencias, 99) * 1000))
+
+
+if __name__ == "__main__":
+    main()
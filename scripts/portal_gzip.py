@@ -0,0 +1,93 @@
+# Genera src/recursos_portal.cpp a partir de portal/: minifica cada archivo,
+# lo comprime con gzip y lo incrusta como arreglo de bytes en flash.
+# PlatformIO lo ejecuta antes de compilar (extra_scripts = pre:...);
+# también se puede lanzar a mano con "python scripts/portal_gzip.py".
+
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821 (lo define PlatformIO)
+    PROYECTO = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROYECTO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ORIGEN = os.path.join(PROYECTO, "portal")
+DESTINO = os.path.join(PROYECTO, "src", "recursos_portal.cpp")
+
+# Ruta, archivo y tipo. Los que no son la página llevan su hash en la URL
+# y se pueden guardar en caché indefinidamente.
+RECURSOS = [
+    ("/portal.css", "portal.css", "text/css"),
+    ("/portal.js", "portal.js", "application/javascript"),
+    ("/", "index.html", "text/html"),
+]
+
+
+def minificar(nombre, texto):
+    if nombre.endswith(".css"):
+        texto = re.sub(r"/\*.*?\*/", "", texto, flags=re.S)
+        texto = "".join(linea.strip() for linea in texto.splitlines())
+        return re.sub(r"\s*([{};:,])\s*", r"\1", texto)
+    lineas = [linea.strip() for linea in texto.splitlines()]
+    if nombre.endswith(".js"):
+        lineas = [l for l in lineas if not l.startswith("//")]
+    return "\n".join(l for l in lineas if l)
+
+
+def arreglo_c(datos):
+    filas = []
+    for i in range(0, len(datos), 16):
+        filas.append("  " + ", ".join("0x%02x" % b for b in datos[i:i + 16]) + ",")
+    return "\n".join(filas)
+
+
+def generar():
+    hashes = {}
+    bloques = []
+    tabla = []
+    total_original = 0
+    total_gzip = 0
+
+    for ruta, archivo, tipo in RECURSOS:
+        with open(os.path.join(ORIGEN, archivo), encoding="utf-8") as f:
+            texto = f.read()
+        total_original += len(texto.encode("utf-8"))
+
+        # {{portal.css}} -> hash del recurso, para invalidar la caché del navegador
+        texto = re.sub(r"\{\{([\w.]+)\}\}", lambda m: hashes[m.group(1)], texto)
+        texto = minificar(archivo, texto)
+
+        # mtime=0 para que la salida no cambie si no cambia el portal
+        datos = gzip.compress(texto.encode("utf-8"), 9, mtime=0)
+        total_gzip += len(datos)
+        hashes[archivo] = hashlib.sha1(datos).hexdigest()[:8]
+
+        simbolo = "RECURSO_" + re.sub(r"\W", "_", archivo).upper()
+        bloques.append("static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (simbolo, arreglo_c(datos)))
+        tabla.append('  {"%s", "%s", "\\"%s\\"", %s, sizeof(%s), %s},' % (
+            ruta, tipo, hashes[archivo], simbolo, simbolo, "false" if ruta == "/" else "true"))
+
+    salida = (
+        "// Generado por scripts/portal_gzip.py a partir de portal/. No editar.\n"
+        '#include "recursos_portal.h"\n\n'
+        + "\n".join(bloques)
+        + "\nconst RecursoPortal RECURSOS_PORTAL[] = {\n"
+        + "\n".join(tabla)
+        + "\n};\n\nconst size_t CANTIDAD_RECURSOS_PORTAL = sizeof(RECURSOS_PORTAL) / sizeof(RECURSOS_PORTAL[0]);\n"
+    )
+
+    anterior = None
+    if os.path.exists(DESTINO):
+        with open(DESTINO, encoding="utf-8") as f:
+            anterior = f.read()
+    if salida != anterior:
+        with open(DESTINO, "w", encoding="utf-8") as f:
+            f.write(salida)
+
+    print("Portal: %d B -> %d B con gzip" % (total_original, total_gzip))
+
+
+generar()
@@ -0,0 +1,56 @@
+# Servidor de telemetría para medir el jitter de la adquisición con la red
+# mal: cada POST tarda lo indicado, falla con 503 o se queda sin respuesta.
+# Con el firmware apuntando aquí, la opción 6 del menú da el jitter medio y
+# máximo y los ticks tardíos; se reinicia al leerla.
+#
+#   python scripts/servidor_lento.py -p 8080 --retraso 3
+#   python scripts/servidor_lento.py -p 8080 --modo error
+#   python scripts/servidor_lento.py -p 8080 --modo colgado
+
+import argparse
+import http.server
+import time
+
+
+def manejador(modo, retraso):
+    class Manejador(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def do_POST(self):
+            self.rfile.read(int(self.headers.get("Content-Length", 0)))
+            lote = self.headers.get("X-Lote", "-")
+            if modo == "colgado":
+                # Ni respuesta ni cierre: el cliente agota su tiempo
+                print("Lote %s: sin respuesta" % lote)
+                time.sleep(3600)
+                return
+            time.sleep(retraso)
+            codigo = 503 if modo == "error" else 200
+            print("Lote %s: %d tras %.1f s" % (lote, codigo, retraso))
+            self.send_response(codigo)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+
+        def log_message(self, formato, *args):
+            pass
+
+    return Manejador
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Servidor de telemetría lento o caído")
+    parser.add_argument("-p", "--puerto", type=int, default=8080)
+    parser.add_argument("--modo", choices=["lento", "error", "colgado"], default="lento")
+    parser.add_argument("--retraso", type=float, default=3.0, help="segundos antes de responder")
+    args = parser.parse_args()
+
+    servidor = http.server.ThreadingHTTPServer(("", args.puerto), manejador(args.modo, args.retraso))
+    print("Escuchando en el puerto %d (%s)" % (args.puerto, args.modo))
+    try:
+        servidor.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,197 @@
+#include "adc_as5600.h"
+
+CalibracionAdc calibracionNominalAdc(uint8_t modo) {
+  CalibracionAdc calibracion;
+  if (modo == AS5600_OUTMODE_ANALOG_90) {
+    calibracion.crudoCero = 410;    // 10 % de 4095
+    calibracion.crudoFondo = 3686;  // 90 %
+  } else {
+    calibracion.crudoCero = 0;
+    calibracion.crudoFondo = 4095;
+  }
+  return calibracion;
+}
+
+uint16_t anguloDesdeAdc(uint32_t crudo, const CalibracionAdc &calibracion) {
+  int32_t rango = (int32_t)calibracion.crudoFondo - calibracion.crudoCero;
+  int32_t desplazado = ((int32_t)crudo - calibracion.crudoCero) * 4095;
+  if (rango < 0) {
+    rango = -rango;
+    desplazado = -desplazado;
+  }
+  if (rango == 0 || desplazado <= 0) {
+    return 0;
+  }
+  int32_t angulo = (desplazado + rango / 2) / rango;
+  return angulo > 4095 ? 4095 : angulo;
+}
+
+uint16_t decimarBloqueAdc(const uint16_t *crudos, size_t cantidad,
+                          const CalibracionAdc &calibracion, bool &cruzaVuelta) {
+  cruzaVuelta = false;
+  if (cantidad == 0) {
+    return 0;
+  }
+  uint16_t minimo = crudos[0];
+  uint16_t maximo = crudos[0];
+  uint32_t suma = 0;
+  for (size_t i = 0; i < cantidad; i++) {
+    if (crudos[i] < minimo) minimo = crudos[i];
+    if (crudos[i] > maximo) maximo = crudos[i];
+    suma += crudos[i];
+  }
+  // Dentro de un bloque de 1 ms el eje no gira media vuelta: un salto así
+  // es el paso de 4095 a 0
+  uint32_t rango = abs((int32_t)calibracion.crudoFondo - calibracion.crudoCero);
+  if ((uint32_t)(maximo - minimo) > rango / 2) {
+    cruzaVuelta = true;
+    return crudos[cantidad - 1];
+  }
+  return (suma + cantidad / 2) / cantidad;
+}
+
+#ifdef ADQUISICION_ADC
+
+#include <atomic>
+#include <driver/adc.h>
+#include "anillo_spsc.h"
+#include "metricas.h"
+
+static AnilloSpsc<MuestraAdc, 64> anilloAdc;
+static TaskHandle_t tareaAdc = NULL;
+static uint8_t canalAdc = 0;
+
+#if defined(ADC_AS5600_CRUDO_CERO) && defined(ADC_AS5600_CRUDO_FONDO)
+static std::atomic<uint32_t> calibracionEmpaquetada(((uint32_t)ADC_AS5600_CRUDO_FONDO << 16) | ADC_AS5600_CRUDO_CERO);
+#else
+static std::atomic<uint32_t> calibracionEmpaquetada(0);
+#endif
+
+static std::atomic<uint32_t> conversiones(0);
+static std::atomic<uint32_t> muestras(0);
+static std::atomic<uint32_t> bloquesVuelta(0);
+static std::atomic<uint32_t> ultimoCrudo(0);
+
+static void tareaLecturaAdc(void *) {
+  const uint32_t periodoUs = 1000000UL / ADC_AS5600_FRECUENCIA_HZ;
+  uint8_t trama[ADC_AS5600_BYTES_TRAMA];
+  uint16_t bloque[ADC_AS5600_DECIMACION];
+  size_t enBloque = 0;
+
+  for (;;) {
+    uint32_t longitud = 0;
+    // Bloquea hasta que el DMA completa una trama; sin CPU mientras tanto
+    esp_err_t r = adc_digi_read_bytes(trama, sizeof(trama), &longitud, portMAX_DELAY);
+    if (r != ESP_OK && r != ESP_ERR_INVALID_STATE) {   // INVALID_STATE: se perdieron datos
+      continue;
+    }
+    uint32_t ahora = micros();
+    CalibracionAdc calibracion = leerCalibracionAdc();
+    size_t lecturas = longitud / SOC_ADC_DIGI_RESULT_BYTES;
+    conversiones.fetch_add(lecturas, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < lecturas; i++) {
+      const adc_digi_output_data_t *dato =
+          (const adc_digi_output_data_t *)&trama[i * SOC_ADC_DIGI_RESULT_BYTES];
+      if (dato->type1.channel != canalAdc) {
+        continue;
+      }
+      bloque[enBloque++] = dato->type1.data;
+      if (enBloque < ADC_AS5600_DECIMACION) {
+        continue;
+      }
+      enBloque = 0;
+
+      bool cruzaVuelta;
+      MuestraAdc muestra;
+      muestra.crudo = decimarBloqueAdc(bloque, ADC_AS5600_DECIMACION, calibracion, cruzaVuelta);
+      muestra.angulo = anguloDesdeAdc(muestra.crudo, calibracion);
+      muestra.tiempoUs = ahora - (lecturas - 1 - i) * periodoUs;
+      if (cruzaVuelta) {
+        bloquesVuelta.fetch_add(1, std::memory_order_relaxed);
+      }
+      anilloAdc.insertar(muestra);
+      muestras.fetch_add(1, std::memory_order_relaxed);
+      ultimoCrudo.store(muestra.crudo, std::memory_order_relaxed);
+    }
+  }
+}
+
+bool iniciarAdcAs5600(AS5600 &sensor, uint8_t nucleo, uint8_t prioridad) {
+  int8_t canal = digitalPinToAnalogChannel(ADC_AS5600_PIN);
+  if (canal < 0 || canal > 7) {
+    return false;   // No es del ADC1
+  }
+  canalAdc = canal;
+  if (calibracionEmpaquetada.load() == 0) {
+    fijarCalibracionAdc(calibracionNominalAdc(ADC_AS5600_MODO));
+  }
+
+  // Un solo commit de CONF
+  sensor.setAutoCommit(false);
+  sensor.setOutputMode(ADC_AS5600_MODO);
+  sensor.commit();
+  sensor.setAutoCommit(true);
+
+  adc_digi_init_config_t inicio = {};
+  inicio.max_store_buf_size = ADC_AS5600_BYTES_TRAMA * 4;
+  inicio.conv_num_each_intr = ADC_AS5600_BYTES_TRAMA;
+  inicio.adc1_chan_mask = BIT(canal);
+  inicio.adc2_chan_mask = 0;
+  if (adc_digi_initialize(&inicio) != ESP_OK) {
+    return false;
+  }
+
+  adc_digi_pattern_config_t patron = {};
+  patron.atten = ADC_ATTEN_DB_11;   // Hasta ~3,1 V
+  patron.channel = canal;
+  patron.unit = 0;                  // ADC1
+  patron.bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+
+  adc_digi_configuration_t config = {};
+  config.conv_limit_en = true;      // Obligatorio en el ESP32
+  config.conv_limit_num = 250;
+  config.pattern_num = 1;
+  config.adc_pattern = &patron;
+  config.sample_freq_hz = ADC_AS5600_FRECUENCIA_HZ;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+  if (adc_digi_controller_configure(&config) != ESP_OK || adc_digi_start() != ESP_OK) {
+    adc_digi_deinitialize();
+    return false;
+  }
+
+  xTaskCreatePinnedToCore(tareaLecturaAdc, "adc", 3072, NULL, prioridad, &tareaAdc, nucleo);
+  registrarTareaMetricas("adc", tareaAdc);
+  return true;
+}
+
+bool extraerMuestraAdc(MuestraAdc &muestra) {
+  return anilloAdc.extraer(muestra);
+}
+
+EstadisticasAdc leerEstadisticasAdc() {
+  EstadisticasAdc stats;
+  stats.conversiones = conversiones.load(std::memory_order_relaxed);
+  stats.muestras = muestras.load(std::memory_order_relaxed);
+  stats.bloquesVuelta = bloquesVuelta.load(std::memory_order_relaxed);
+  stats.descartadas = anilloAdc.descartados();
+  stats.ultimoCrudo = ultimoCrudo.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// Empaquetada en 32 bits para que la tarea del ADC lea los dos puntos a la vez
+void fijarCalibracionAdc(const CalibracionAdc &calibracion) {
+  calibracionEmpaquetada.store(((uint32_t)calibracion.crudoFondo << 16) | calibracion.crudoCero,
+                               std::memory_order_relaxed);
+}
+
+CalibracionAdc leerCalibracionAdc() {
+  uint32_t valor = calibracionEmpaquetada.load(std::memory_order_relaxed);
+  CalibracionAdc calibracion;
+  calibracion.crudoCero = valor & 0xFFFF;
+  calibracion.crudoFondo = valor >> 16;
+  return calibracion;
+}
+
+#endif // ADQUISICION_ADC
@@ -0,0 +1,333 @@
+#include "adquisicion.h"
+#include "anillo_spsc.h"
+#include "contador_cajas.h"
+#include "metricas.h"
+#include "seqlock.h"
+#ifdef ADQUISICION_PWM
+#include "captura_pwm.h"
+#endif
+#ifdef ADQUISICION_ADC
+#include "adc_as5600.h"
+#endif
+
+static AnilloSpsc<Muestra, 256> anilloMuestras;
+static Seqlock<InstantaneaSensores> instantaneaPublicada;
+static AS5600 *sensor = nullptr;
+static uint8_t pinCajas = 0;
+static TaskHandle_t tareaHandle = NULL;
+static hw_timer_t *temporizador = NULL;
+
+// Estadísticas publicadas por la tarea de adquisición
+static std::atomic<uint32_t> totalMuestras(0);
+static std::atomic<uint32_t> jitterMedio(0);
+static std::atomic<uint32_t> jitterMax(0);
+static std::atomic<uint32_t> tardias(0);
+static std::atomic<uint32_t> tardiasFlash(0);
+// Crece al empezar y al terminar cada operación: impar mientras dura
+static std::atomic<uint32_t> operacionesFlash(0);
+static std::atomic<uint32_t> erroresI2C(0);
+static std::atomic<bool> pedirReinicio(false);
+static std::atomic<uint32_t> transaccionesI2C(0);
+static std::atomic<uint32_t> erroresI2CTotal(0);
+
+// Bits del registro STATUS del AS5600
+static const uint8_t ESTADO_IMAN_FUERTE = 0x08;
+static const uint8_t ESTADO_IMAN_DEBIL = 0x10;
+static const uint8_t ESTADO_IMAN_DETECTADO = 0x20;
+
+static EstadoIman decodificarIman(uint8_t estado) {
+  if (!(estado & ESTADO_IMAN_DETECTADO)) {
+    return IMAN_AUSENTE;
+  }
+  if (estado & ESTADO_IMAN_DEBIL) {
+    return IMAN_DEBIL;
+  }
+  if (estado & ESTADO_IMAN_FUERTE) {
+    return IMAN_FUERTE;
+  }
+  return IMAN_CORRECTO;
+}
+
+static void contarI2C(bool correcta) {
+  transaccionesI2C.fetch_add(1, std::memory_order_relaxed);
+  if (!correcta) {
+    erroresI2C.fetch_add(1, std::memory_order_relaxed);
+    erroresI2CTotal.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+#if defined(ADQUISICION_PWM) && defined(ADQUISICION_ADC)
+#error "ADQUISICION_PWM y ADQUISICION_ADC usan la misma salida OUT: elegir una"
+#endif
+
+#if defined(ADQUISICION_PWM) || defined(ADQUISICION_ADC)
+// El ángulo no pasa por la librería: posición acumulada con la misma regla
+// que getCumulativePosition(), menos de media vuelta entre dos lecturas
+static int32_t posicionLocal = 0;
+static uint16_t ultimoAnguloLocal = 0;
+
+static int32_t desplegarAngulo(uint16_t angulo) {
+  int32_t delta = (int32_t)angulo - ultimoAnguloLocal;
+  if (delta > 2048) {
+    delta -= 4096;
+  } else if (delta < -2048) {
+    delta += 4096;
+  }
+  posicionLocal += delta;
+  ultimoAnguloLocal = angulo;
+  return posicionLocal;
+}
+
+static int32_t revolucionesLocales() {
+  int32_t vueltas = posicionLocal >> 12;
+  if (vueltas < 0) {
+    vueltas++;   // Igual que getRevolutions()
+  }
+  return vueltas;
+}
+#endif
+
+#ifdef ADQUISICION_PWM
+// Sin tramas nuevas en este tiempo se da el sensor por desconectado
+static const uint32_t PWM_CADUCIDAD_US = 3 * CAPTURA_PWM_PERIODO_MAX_US;
+static uint32_t ultimasTramas = 0;
+
+// Solo una trama nueva mueve la posición: antes de la primera la captura
+// da ángulo 0, y repetir la misma no aporta nada
+static bool leerAnguloPwm(uint32_t ahora, uint16_t &angulo, int32_t &posicion) {
+  LecturaPwm pwm = leerCapturaPwm();
+  if (pwm.tramas != ultimasTramas) {
+    ultimasTramas = pwm.tramas;
+    desplegarAngulo(pwm.angulo);
+  }
+  angulo = ultimoAnguloLocal;
+  posicion = posicionLocal;
+  return pwm.tramas > 0 && ahora - pwm.tiempoUs < PWM_CADUCIDAD_US;
+}
+
+// Salida OUT en PWM a 920 Hz: trama de ~1,09 ms, la más cercana a 1 kHz.
+// Un solo commit de CONF.
+static void configurarSalidaPwm() {
+  sensor->setAutoCommit(false);
+  sensor->setOutputMode(AS5600_OUTMODE_PWM);
+  sensor->setPWMFrequency(AS5600_PWM_920);
+  sensor->commit();
+  sensor->setAutoCommit(true);
+  iniciarCapturaPwm(CAPTURA_PWM_PIN);
+}
+#endif
+
+#ifdef ADQUISICION_ADC
+// Sin muestras nuevas del ADC en este tiempo se da el sensor por desconectado
+static const uint32_t ADC_CADUCIDAD_US = 5000;
+static MuestraAdc ultimaMuestraAdc = {};
+static bool hayMuestraAdc = false;
+
+// Se consumen todas las muestras pendientes para no perder vueltas
+static bool leerAnguloAdc(uint32_t ahora, uint16_t &angulo, int32_t &posicion) {
+  MuestraAdc muestra;
+  while (extraerMuestraAdc(muestra)) {
+    desplegarAngulo(muestra.angulo);
+    ultimaMuestraAdc = muestra;
+    hayMuestraAdc = true;
+  }
+  angulo = ultimoAnguloLocal;
+  posicion = posicionLocal;
+  return hayMuestraAdc && ahora - ultimaMuestraAdc.tiempoUs < ADC_CADUCIDAD_US;
+}
+#endif
+
+static void IRAM_ATTR isrTemporizador() {
+  BaseType_t despertar = pdFALSE;
+  vTaskNotifyGiveFromISR(tareaHandle, &despertar);
+  portYIELD_FROM_ISR(despertar);
+}
+
+static void tareaAdquisicion(void *) {
+  // La ISR del E18 se instala en el núcleo que la registra: el de adquisición
+  iniciarContadorCajas(pinCajas);
+
+  // Posición inicial = ángulo actual, así la vuelta 0 coincide con el ángulo
+  sensor->resetCumulativePosition(sensor->readAngle());
+#if defined(ADQUISICION_PWM) || defined(ADQUISICION_ADC)
+  ultimoAnguloLocal = sensor->readAngle();
+  posicionLocal = ultimoAnguloLocal;
+#endif
+#if defined(ADQUISICION_PWM)
+  // La ISR de captura también queda en este núcleo
+  configurarSalidaPwm();
+#elif defined(ADQUISICION_ADC)
+  // La tarea del ADC lee a menor prioridad que esta y en el mismo núcleo
+  iniciarAdcAs5600(*sensor, ADQUISICION_NUCLEO, ADQUISICION_PRIORIDAD - 1);
+#else
+  // El puntero de registro queda en ANGLE: cada tick solo lee los dos bytes
+  sensor->beginStream();
+#endif
+
+  const uint32_t periodoUs = 1000000UL / ADQUISICION_FRECUENCIA_HZ;
+  temporizador = timerBegin(ADQUISICION_TIMER, 80, true);  // 1 tick = 1 us
+  timerAttachInterrupt(temporizador, isrTemporizador, true);
+  timerAlarmWrite(temporizador, periodoUs, true);
+  uint32_t previstoUs = micros();
+  timerAlarmEnable(temporizador);
+  uint64_t sumaJitter = 0;
+  uint32_t n = 0;
+  uint32_t maximo = 0;
+
+  // Lo que se lee a menor frecuencia se conserva entre publicaciones
+  InstantaneaSensores instantanea = {};
+  uint32_t tickEstado = 0;
+  uint32_t velocidadDesdeUs = micros();
+  int32_t velocidadDesdePos = sensor->getCumulativePosition(false);
+
+  uint32_t flashAnterior = operacionesFlash.load(std::memory_order_relaxed);
+
+  for (;;) {
+    // Cada notificación es un tick; más de una significa ticks perdidos.
+    // Si entre tanto hubo una operación en flash (o sigue) se le atribuyen.
+    uint32_t ticks = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    uint32_t flash = operacionesFlash.load(std::memory_order_relaxed);
+    if (ticks > 1) {
+      tardias.fetch_add(ticks - 1, std::memory_order_relaxed);
+      if (flash != flashAnterior || (flash & 1)) {
+        tardiasFlash.fetch_add(ticks - 1, std::memory_order_relaxed);
+      }
+    }
+    flashAnterior = flash;
+
+    uint32_t ahora = micros();
+    previstoUs += periodoUs * ticks;
+    int32_t desvio = (int32_t)(ahora - previstoUs);
+    uint32_t jitter = desvio < 0 ? -desvio : desvio;
+    // Tras un salto grande (p. ej. depurador) se vuelve a sincronizar
+    if (jitter > periodoUs) {
+      previstoUs = ahora;
+    }
+
+    // Cuando toca el estado se lee la trama entera del AS5600 en una ráfaga
+    bool tocaEstado = ++tickEstado >= ADQUISICION_DIVISOR_ESTADO;
+    AS5600Frame trama;
+    bool tramaLeida = false;
+    if (tocaEstado) {
+      tramaLeida = sensor->readFrame(trama);
+      contarI2C(tramaLeida);
+      if (tramaLeida) {
+        instantanea.iman = decodificarIman(trama.status);
+        instantanea.anguloRaw = trama.rawAngle;
+      }
+    }
+
+    Muestra m;
+    m.tiempoUs = ahora;
+#ifdef ADQUISICION_PWM
+    // Ángulo de la última trama PWM capturada, sin tráfico I2C
+    m.conectado = leerAnguloPwm(ahora, m.angulo, m.posicion);
+#elif defined(ADQUISICION_ADC)
+    // Última muestra decimada del ADC, sin tráfico I2C
+    m.conectado = leerAnguloAdc(ahora, m.angulo, m.posicion);
+#else
+    // Una sola lectura I2C por tick; la posición acumulada reutiliza ese
+    // ángulo. Tras la trama el siguiente tick vuelve a fijar el puntero.
+    if (tocaEstado) {
+      m.conectado = tramaLeida;
+      m.angulo = tramaLeida ? trama.angle : instantanea.angulo;
+    } else {
+      m.angulo = sensor->readStream();
+      m.conectado = (sensor->lastError() == AS5600_OK);
+      contarI2C(m.conectado);
+    }
+    m.posicion = sensor->getCumulativePosition(false);
+#endif
+    m.conteo = leerConteoCajas();
+    anilloMuestras.insertar(m);
+
+    if (tocaEstado) {
+      tickEstado = 0;
+      uint32_t dtUs = ahora - velocidadDesdeUs;
+      instantanea.velocidadRpm = (m.posicion - velocidadDesdePos) * (60e6f / 4096.0f) / dtUs;
+      velocidadDesdeUs = ahora;
+      velocidadDesdePos = m.posicion;
+    }
+
+    instantanea.secuencia++;
+    instantanea.tiempoUs = ahora;
+    instantanea.angulo = m.angulo;
+    instantanea.posicion = m.posicion;
+#if defined(ADQUISICION_PWM) || defined(ADQUISICION_ADC)
+    instantanea.revoluciones = revolucionesLocales();
+#else
+    instantanea.revoluciones = sensor->getRevolutions();
+#endif
+    instantanea.conteo = m.conteo;
+    instantanea.conectado = m.conectado;
+    instantaneaPublicada.publicar(instantanea);
+
+    if (pedirReinicio.exchange(false)) {
+      sumaJitter = 0;
+      n = 0;
+      maximo = 0;
+      tardias.store(0, std::memory_order_relaxed);
+      tardiasFlash.store(0, std::memory_order_relaxed);
+      erroresI2C.store(0, std::memory_order_relaxed);
+    }
+    sumaJitter += jitter;
+    n++;
+    if (jitter > maximo) {
+      maximo = jitter;
+    }
+    totalMuestras.store(n, std::memory_order_relaxed);
+    jitterMedio.store(sumaJitter / n, std::memory_order_relaxed);
+    jitterMax.store(maximo, std::memory_order_relaxed);
+  }
+}
+
+void iniciarAdquisicion(AS5600 &as5600, uint8_t pin) {
+  sensor = &as5600;
+  pinCajas = pin;
+  xTaskCreatePinnedToCore(tareaAdquisicion, "adquisicion", 4096, NULL,
+                          ADQUISICION_PRIORIDAD, &tareaHandle, ADQUISICION_NUCLEO);
+  registrarTareaMetricas("adquisicion", tareaHandle);
+}
+
+bool extraerMuestra(Muestra &muestra) {
+  return anilloMuestras.extraer(muestra);
+}
+
+size_t muestrasPendientes() {
+  return anilloMuestras.ocupados();
+}
+
+InstantaneaSensores leerInstantaneaSensores() {
+  return instantaneaPublicada.leer();
+}
+
+uint32_t antiguedadInstantaneaUs(const InstantaneaSensores &instantanea) {
+  return micros() - instantanea.tiempoUs;
+}
+
+EstadisticasJitter leerJitterAdquisicion() {
+  EstadisticasJitter stats;
+  stats.muestras = totalMuestras.load(std::memory_order_relaxed);
+  stats.jitterMedioUs = jitterMedio.load(std::memory_order_relaxed);
+  stats.jitterMaxUs = jitterMax.load(std::memory_order_relaxed);
+  stats.descartadas = anilloMuestras.descartados();
+  stats.tardias = tardias.load(std::memory_order_relaxed);
+  stats.tardiasFlash = tardiasFlash.load(std::memory_order_relaxed);
+  stats.erroresI2C = erroresI2C.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void marcarOperacionFlash(bool) {
+  operacionesFlash.fetch_add(1, std::memory_order_relaxed);
+}
+
+ContadoresI2C leerContadoresI2C() {
+  ContadoresI2C contadores;
+  contadores.transacciones = transaccionesI2C.load(std::memory_order_relaxed);
+  contadores.errores = erroresI2CTotal.load(std::memory_order_relaxed);
+  return contadores;
+}
+
+void reiniciarJitterAdquisicion() {
+  pedirReinicio.store(true);
+}
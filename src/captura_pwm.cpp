@@ -0,0 +1,105 @@
+#include "captura_pwm.h"
+
+uint16_t anguloDesdePwm(uint32_t ticksAlto, uint32_t ticksPeriodo) {
+  if (ticksPeriodo == 0 || ticksAlto > ticksPeriodo) {
+    return 0;
+  }
+  // Bits en alto, redondeados
+  uint32_t bitsAlto = ((uint64_t)ticksAlto * CAPTURA_PWM_BITS_TRAMA + ticksPeriodo / 2) / ticksPeriodo;
+  if (bitsAlto <= CAPTURA_PWM_BITS_CABECERA) {
+    return 0;
+  }
+  uint32_t angulo = bitsAlto - CAPTURA_PWM_BITS_CABECERA;
+  return angulo > 4095 ? 4095 : angulo;
+}
+
+#ifdef ADQUISICION_PWM
+
+#include <atomic>
+#include <driver/mcpwm.h>
+
+// El contador de captura va con el reloj APB
+#define TICKS_POR_US 80
+static const uint32_t PERIODO_MIN_TICKS = CAPTURA_PWM_PERIODO_MIN_US * TICKS_POR_US;
+static const uint32_t PERIODO_MAX_TICKS = CAPTURA_PWM_PERIODO_MAX_US * TICKS_POR_US;
+
+// Estado solo de la ISR
+static uint32_t subidaAnterior = 0;
+static uint32_t bajada = 0;
+static bool haySubida = false;
+static bool hayBajada = false;
+
+// Publicado por la ISR (seqlock a mano: la ISR está en IRAM y no puede
+// llamar a código en flash)
+static std::atomic<uint32_t> secuencia(0);
+static std::atomic<uint32_t> ticksAlto(0);
+static std::atomic<uint32_t> ticksPeriodo(0);
+static std::atomic<uint32_t> tiempoUs(0);
+static std::atomic<uint32_t> tramas(0);
+static std::atomic<uint32_t> descartadas(0);
+
+// Una trama se cierra en la subida siguiente: alto = bajada - subida,
+// periodo = subida - subida anterior. Sin divisiones: se hacen al leer.
+static bool IRAM_ATTR alCapturar(mcpwm_unit_t, mcpwm_capture_channel_id_t,
+                                 const cap_event_data_t *evento, void *) {
+  uint32_t t = evento->cap_value;
+  if (evento->cap_edge == MCPWM_NEG_EDGE) {
+    bajada = t;
+    hayBajada = haySubida;
+    return false;
+  }
+
+  if (haySubida && hayBajada) {
+    uint32_t periodo = t - subidaAnterior;
+    uint32_t alto = bajada - subidaAnterior;
+    if (periodo < PERIODO_MIN_TICKS || periodo > PERIODO_MAX_TICKS || alto >= periodo) {
+      descartadas.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      secuencia.fetch_add(1, std::memory_order_acq_rel);
+      ticksAlto.store(alto, std::memory_order_relaxed);
+      ticksPeriodo.store(periodo, std::memory_order_relaxed);
+      tiempoUs.store(micros(), std::memory_order_relaxed);
+      tramas.fetch_add(1, std::memory_order_relaxed);
+      secuencia.fetch_add(1, std::memory_order_release);
+    }
+  } else if (haySubida) {
+    // Dos subidas seguidas: se perdió la bajada
+    descartadas.fetch_add(1, std::memory_order_relaxed);
+  }
+  subidaAnterior = t;
+  haySubida = true;
+  hayBajada = false;
+  return false;
+}
+
+bool iniciarCapturaPwm(uint8_t pin) {
+  pinMode(pin, INPUT);
+  if (mcpwm_gpio_init(MCPWM_UNIT_0, MCPWM_CAP_0, pin) != ESP_OK) {
+    return false;
+  }
+  mcpwm_capture_config_t config = {};
+  config.cap_edge = MCPWM_BOTH_EDGE;
+  config.cap_prescale = 1;
+  config.capture_cb = alCapturar;
+  config.user_data = NULL;
+  return mcpwm_capture_enable_channel(MCPWM_UNIT_0, MCPWM_SELECT_CAP0, &config) == ESP_OK;
+}
+
+LecturaPwm leerCapturaPwm() {
+  LecturaPwm lectura;
+  uint32_t s1, s2, alto, periodo;
+  do {
+    s1 = secuencia.load(std::memory_order_acquire);
+    alto = ticksAlto.load(std::memory_order_relaxed);
+    periodo = ticksPeriodo.load(std::memory_order_relaxed);
+    lectura.tiempoUs = tiempoUs.load(std::memory_order_relaxed);
+    lectura.tramas = tramas.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s2 = secuencia.load(std::memory_order_relaxed);
+  } while ((s1 & 1) || s1 != s2);
+  lectura.angulo = anguloDesdePwm(alto, periodo);
+  lectura.descartadas = descartadas.load(std::memory_order_relaxed);
+  return lectura;
+}
+
+#endif // ADQUISICION_PWM
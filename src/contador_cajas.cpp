@@ -0,0 +1,134 @@
+#include "contador_cajas.h"
+
+void iniciarFiltroRebote(FiltroRebote &filtro, bool alto) {
+  filtro.altoDesdeUs = 0;
+  filtro.alto = alto;
+  filtro.armado = alto;
+}
+
+FlancoCaja IRAM_ATTR filtrarFlancoCaja(FiltroRebote &filtro, bool alto, uint32_t ahoraUs, uint32_t debounceUs) {
+  if (alto) {
+    // Cualquier subida reinicia la espera, también la de un rebote
+    filtro.alto = true;
+    filtro.armado = false;
+    filtro.altoDesdeUs = ahoraUs;
+    return FLANCO_SUBIDA;
+  }
+  bool esCaja = filtro.alto && (filtro.armado || ahoraUs - filtro.altoDesdeUs >= debounceUs);
+  filtro.alto = false;
+  filtro.armado = false;
+  return esCaja ? FLANCO_CAJA : FLANCO_REBOTE;
+}
+
+#ifndef CONTADOR_CAJAS_PCNT
+
+#include <atomic>
+
+static_assert((CONTADOR_EVENTOS_MAX & (CONTADOR_EVENTOS_MAX - 1)) == 0,
+              "CONTADOR_EVENTOS_MAX debe ser potencia de 2");
+
+// Estado compartido con la ISR. La secuencia es impar mientras la ISR
+// escribe, los lectores reintentan si la ven cambiar (seqlock).
+static std::atomic<uint32_t> secuencia(0);
+static std::atomic<uint32_t> conteo(0);
+static std::atomic<uint32_t> conteoAlto(0);
+static std::atomic<uint32_t> ultimoEventoUs(0);
+static std::atomic<uint32_t> rechazados(0);
+static std::atomic<uint32_t> debounce(CONTADOR_DEBOUNCE_US);
+static uint32_t eventos[CONTADOR_EVENTOS_MAX];
+static FiltroRebote filtro;   // Solo de la ISR
+static uint8_t pinCajas = 0;
+
+static void IRAM_ATTR isrFlancoCaja() {
+  uint32_t ahora = micros();
+  bool alto = digitalRead(pinCajas) == HIGH;
+
+  FlancoCaja flanco = filtrarFlancoCaja(filtro, alto, ahora, debounce.load(std::memory_order_relaxed));
+  if (flanco == FLANCO_REBOTE) {
+    rechazados.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (flanco != FLANCO_CAJA) {
+    return;
+  }
+
+  uint32_t n = conteo.load(std::memory_order_relaxed);
+  secuencia.fetch_add(1, std::memory_order_acq_rel);
+  eventos[n & (CONTADOR_EVENTOS_MAX - 1)] = ahora;
+  ultimoEventoUs.store(ahora, std::memory_order_relaxed);
+  conteo.store(n + 1, std::memory_order_relaxed);
+  if (n + 1 == 0) {
+    conteoAlto.fetch_add(1, std::memory_order_relaxed);
+  }
+  secuencia.fetch_add(1, std::memory_order_release);
+}
+
+void iniciarContadorCajas(uint8_t pin, uint32_t debounceUs) {
+  debounce.store(debounceUs);
+  pinCajas = pin;
+  pinMode(pin, INPUT);
+  iniciarFiltroRebote(filtro, digitalRead(pin) == HIGH);
+  attachInterrupt(digitalPinToInterrupt(pin), isrFlancoCaja, CHANGE);
+}
+
+void configurarDebounceCajas(uint32_t debounceUs) {
+  debounce.store(debounceUs, std::memory_order_relaxed);
+}
+
+uint32_t leerConteoCajas() {
+  return conteo.load(std::memory_order_acquire);
+}
+
+uint64_t leerConteoCajas64() {
+  uint32_t s1, s2, alto, bajo;
+  do {
+    s1 = secuencia.load(std::memory_order_acquire);
+    alto = conteoAlto.load(std::memory_order_relaxed);
+    bajo = conteo.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s2 = secuencia.load(std::memory_order_relaxed);
+  } while ((s1 & 1) || s1 != s2);
+  return ((uint64_t)alto << 32) | bajo;
+}
+
+InstantaneaCajas leerInstantaneaCajas() {
+  InstantaneaCajas foto;
+  uint32_t s1, s2;
+  do {
+    s1 = secuencia.load(std::memory_order_acquire);
+    foto.conteo = conteo.load(std::memory_order_relaxed);
+    foto.ultimoEventoUs = ultimoEventoUs.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s2 = secuencia.load(std::memory_order_relaxed);
+  } while ((s1 & 1) || s1 != s2);
+  foto.rechazados = rechazados.load(std::memory_order_relaxed);
+  return foto;
+}
+
+size_t leerEventosCajas(uint32_t &cursor, uint32_t *destino, size_t maximo) {
+  size_t copiados = 0;
+  uint32_t s1, s2;
+  do {
+    s1 = secuencia.load(std::memory_order_acquire);
+    uint32_t total = conteo.load(std::memory_order_relaxed);
+    uint32_t desde = cursor;
+
+    // El anillo ya sobrescribió los eventos más viejos
+    if (total - desde > CONTADOR_EVENTOS_MAX) {
+      desde = total - CONTADOR_EVENTOS_MAX;
+    }
+
+    copiados = 0;
+    while (desde + copiados != total && copiados < maximo) {
+      destino[copiados] = eventos[(desde + copiados) & (CONTADOR_EVENTOS_MAX - 1)];
+      copiados++;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s2 = secuencia.load(std::memory_order_relaxed);
+    if (!(s1 & 1) && s1 == s2) {
+      cursor = desde + copiados;
+    }
+  } while ((s1 & 1) || s1 != s2);
+  return copiados;
+}
+
+#endif // CONTADOR_CAJAS_PCNT
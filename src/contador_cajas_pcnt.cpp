@@ -0,0 +1,104 @@
+#include "contador_cajas.h"
+
+#ifdef CONTADOR_CAJAS_PCNT
+
+#include <driver/pcnt.h>
+
+// Unidad PCNT reservada para el E18-D80NK
+#define PCNT_UNIDAD PCNT_UNIT_0
+// Al llegar a este valor el contador hardware vuelve a 0 e interrumpe
+#define PCNT_LIMITE 30000
+// El filtro de glitches cuenta ciclos de APB (80 MHz), máximo 1023
+#define PCNT_FILTRO_MAX 1023
+
+static portMUX_TYPE muxPcnt = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint64_t desbordes = 0;
+static uint64_t ultimoLeido = 0;
+
+static void IRAM_ATTR isrDesbordePcnt(void *) {
+  uint32_t estado = 0;
+  pcnt_get_event_status(PCNT_UNIDAD, &estado);
+  if (estado & PCNT_EVT_H_LIM) {
+    portENTER_CRITICAL_ISR(&muxPcnt);
+    desbordes += PCNT_LIMITE;
+    portEXIT_CRITICAL_ISR(&muxPcnt);
+  }
+}
+
+static uint16_t ticksFiltro(uint32_t debounceUs) {
+  uint32_t ticks = debounceUs * 80;
+  return ticks > PCNT_FILTRO_MAX ? PCNT_FILTRO_MAX : ticks;
+}
+
+void iniciarContadorCajas(uint8_t pin, uint32_t debounceUs) {
+  pinMode(pin, INPUT);
+
+  pcnt_config_t config = {};
+  config.pulse_gpio_num = pin;
+  config.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+  config.channel = PCNT_CHANNEL_0;
+  config.unit = PCNT_UNIDAD;
+  config.pos_mode = PCNT_COUNT_DIS;   // LIBRE: no cuenta
+  config.neg_mode = PCNT_COUNT_INC;   // OBSTACULO: una caja
+  config.lctrl_mode = PCNT_MODE_KEEP;
+  config.hctrl_mode = PCNT_MODE_KEEP;
+  config.counter_h_lim = PCNT_LIMITE;
+  config.counter_l_lim = 0;
+  pcnt_unit_config(&config);
+
+  // El filtro solo cubre glitches de pocos microsegundos; el rebote
+  // mecánico largo no se puede filtrar en hardware.
+  pcnt_set_filter_value(PCNT_UNIDAD, ticksFiltro(debounceUs));
+  pcnt_filter_enable(PCNT_UNIDAD);
+
+  pcnt_event_enable(PCNT_UNIDAD, PCNT_EVT_H_LIM);
+  pcnt_counter_pause(PCNT_UNIDAD);
+  pcnt_counter_clear(PCNT_UNIDAD);
+
+  pcnt_isr_service_install(0);
+  pcnt_isr_handler_add(PCNT_UNIDAD, isrDesbordePcnt, NULL);
+  pcnt_intr_enable(PCNT_UNIDAD);
+  pcnt_counter_resume(PCNT_UNIDAD);
+}
+
+void configurarDebounceCajas(uint32_t debounceUs) {
+  pcnt_set_filter_value(PCNT_UNIDAD, ticksFiltro(debounceUs));
+}
+
+uint64_t leerConteoCajas64() {
+  int16_t contador = 0;
+
+  portENTER_CRITICAL(&muxPcnt);
+  pcnt_get_counter_value(PCNT_UNIDAD, &contador);
+  uint64_t total = desbordes + (uint16_t)contador;
+  // Entre el reinicio del hardware y la ISR el total parece retroceder
+  if (total < ultimoLeido) {
+    total = ultimoLeido;
+  }
+  ultimoLeido = total;
+  portEXIT_CRITICAL(&muxPcnt);
+
+  return total;
+}
+
+uint32_t leerConteoCajas() {
+  return (uint32_t)leerConteoCajas64();
+}
+
+InstantaneaCajas leerInstantaneaCajas() {
+  InstantaneaCajas foto;
+  foto.conteo = leerConteoCajas();
+  foto.ultimoEventoUs = 0;
+  foto.rechazados = 0;
+  return foto;
+}
+
+size_t leerEventosCajas(uint32_t &cursor, uint32_t *destino, size_t maximo) {
+  // El PCNT no registra cuándo pasó cada caja
+  (void)destino;
+  (void)maximo;
+  cursor = leerConteoCajas();
+  return 0;
+}
+
+#endif // CONTADOR_CAJAS_PCNT
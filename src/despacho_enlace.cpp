@@ -0,0 +1,124 @@
+#include "despacho_enlace.h"
+
+RespuestaEnlace clasificarRespuestaHttp(int codigo) {
+  if (codigo >= 200 && codigo < 300) {
+    return RESPUESTA_ENTREGADO;
+  }
+  // Sin respuesta, error del servidor, tiempo agotado o límite de peticiones:
+  // el mismo payload puede entrar más tarde
+  if (codigo <= 0 || codigo >= 500 || codigo == 408 || codigo == 429) {
+    return RESPUESTA_REINTENTAR;
+  }
+  return RESPUESTA_RECHAZADO;
+}
+
+DespachoEnlace::DespachoEnlace(DiarioTelemetria &diario, char *buffer, size_t capacidad,
+                               FuncionEnvio enviar, void *contexto)
+  : _diario(diario), _buffer(buffer), _capacidad(capacidad), _enviar(enviar), _contexto(contexto) {
+}
+
+uint32_t DespachoEnlace::esperaRestanteMs() const {
+  int32_t falta = (int32_t)(_proximoIntento - millis());
+  return _esperando && falta > 0 ? falta : 0;
+}
+
+bool DespachoEnlace::puedeEnviar(bool enLinea) const {
+  return enLinea && esperaRestanteMs() == 0;
+}
+
+size_t DespachoEnlace::binarioAJson(const char *datos, size_t longitud) {
+  // Se decodifica entero antes de escribir: "datos" puede ser el propio _buffer
+  uint32_t ahoraMs;
+  if (!_conversion.decodificarBinario((const uint8_t *)datos, longitud, ahoraMs)) {
+    return 0;
+  }
+  EscritorBuffer json(_buffer, _capacidad);
+  return _conversion.serializar(json, ahoraMs) ? json.longitud() : 0;
+}
+
+RespuestaEnlace DespachoEnlace::intentar(const char *datos, size_t longitud,
+                                         uint32_t arranque, uint32_t numero) {
+  // El formato se reconoce por el primer byte: el JSON siempre empieza por '{'
+  bool esJson = longitud > 0 && datos[0] == '{';
+  if (!esJson && !aceptaBinario()) {
+    longitud = binarioAJson(datos, longitud);
+    if (longitud == 0) {
+      // Mal formado o no cabe en JSON: nunca se podrá entregar
+      _rechazados.fetch_add(1, std::memory_order_relaxed);
+      return RESPUESTA_RECHAZADO;
+    }
+    datos = _buffer;
+    esJson = true;
+  }
+
+  int codigo = _enviar(_contexto, datos, longitud, arranque, numero);
+  RespuestaEnlace respuesta = clasificarRespuestaHttp(codigo);
+
+  // 415: el servidor no entiende el binario. Este lote se repite enseguida
+  // en JSON (ya sin binario, no vuelve a entrar aquí) y los próximos también.
+  if (codigo == 415 && !esJson) {
+    _binarioRechazado.store(true, std::memory_order_relaxed);
+    return intentar(datos, longitud, arranque, numero);
+  }
+
+  if (respuesta == RESPUESTA_REINTENTAR) {
+    _fallidos.fetch_add(1, std::memory_order_relaxed);
+    _proximoIntento = millis() + _esperaMs;
+    _esperando = true;
+    _esperaMs = min((uint32_t)ENLACE_ESPERA_MAX_MS, _esperaMs * 2);
+    return respuesta;
+  }
+
+  // El servidor respondió: la conexión está bien aunque rechace el payload
+  if (respuesta == RESPUESTA_ENTREGADO) {
+    _enviados.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    _rechazados.fetch_add(1, std::memory_order_relaxed);
+  }
+  _esperaMs = ENLACE_ESPERA_MIN_MS;
+  _esperando = false;
+  return respuesta;
+}
+
+void DespachoEnlace::despachar(const char *datos, size_t longitud, uint32_t numero, bool enLinea) {
+  // Para conservar el orden, si hay atrasos lo nuevo va detrás en el diario
+  if (puedeEnviar(enLinea) && !_diario.hayPendientes() &&
+      intentar(datos, longitud, _diario.arranque(), numero) != RESPUESTA_REINTENTAR) {
+    return;
+  }
+  if (!_diario.anotar(datos, longitud, numero)) {
+    registrarDescarte();
+  }
+}
+
+void DespachoEnlace::reenviarDiario(bool enLinea) {
+  if (!puedeEnviar(enLinea) || !_diario.hayPendientes()) {
+    return;
+  }
+  uint32_t arranque, numero;
+  size_t longitud = _diario.leerSiguiente(_buffer, _capacidad, arranque, numero);
+  if (longitud == 0) {
+    return;
+  }
+  // Un registro rechazado también se salta: si no, bloquearía a los demás
+  if (intentar(_buffer, longitud, arranque, numero) != RESPUESTA_REINTENTAR) {
+    _diario.confirmar();
+  }
+}
+
+void DespachoEnlace::registrarDescarte() {
+  _descartados.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool DespachoEnlace::aceptaBinario() const {
+  return !_binarioRechazado.load(std::memory_order_relaxed);
+}
+
+EstadisticasDespacho DespachoEnlace::estadisticas() const {
+  EstadisticasDespacho stats;
+  stats.enviados = _enviados.load(std::memory_order_relaxed);
+  stats.fallidos = _fallidos.load(std::memory_order_relaxed);
+  stats.rechazados = _rechazados.load(std::memory_order_relaxed);
+  stats.descartados = _descartados.load(std::memory_order_relaxed);
+  return stats;
+}
@@ -0,0 +1,283 @@
+#include "diario_telemetria.h"
+
+static const uint32_t DIARIO_MAGIA = 0x4C455444;  // "DTEL"
+static const char *DIARIO_DIR = "/diario";
+static const char *DIARIO_ARRANQUE = "/diario/arranque";
+static const char *DIARIO_CHECKPOINT = "/diario/checkpoint";
+static const char *DIARIO_CHECKPOINT_TMP = "/diario/checkpoint.tmp";
+
+static uint32_t crc32(const char *datos, size_t longitud) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < longitud; i++) {
+    crc ^= (uint8_t)datos[i];
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+// Marca el tramo en que se usa la flash
+struct TramoFlash {
+  explicit TramoFlash(AvisoFlash aviso) : aviso(aviso) {
+    if (aviso) {
+      aviso(true);
+    }
+  }
+  ~TramoFlash() {
+    if (aviso) {
+      aviso(false);
+    }
+  }
+  AvisoFlash aviso;
+};
+
+void DiarioTelemetria::avisarFlash(AvisoFlash aviso) {
+  _aviso = aviso;
+}
+
+bool DiarioTelemetria::iniciar(fs::FS &fs) {
+  TramoFlash tramo(_aviso);
+  _fs = &fs;
+  if (!fs.exists(DIARIO_DIR)) {
+    fs.mkdir(DIARIO_DIR);
+  }
+
+  // Identificador de arranque: distingue los números de lote entre reinicios
+  File f = fs.open(DIARIO_ARRANQUE, "r");
+  if (f) {
+    f.read((uint8_t *)&_arranque, sizeof(_arranque));
+    f.close();
+  }
+  _arranque++;
+  f = fs.open(DIARIO_ARRANQUE, "w");
+  if (!f) {
+    _fs = nullptr;
+    return false;
+  }
+  f.write((const uint8_t *)&_arranque, sizeof(_arranque));
+  f.close();
+
+  // Segmentos presentes
+  bool haySegmentos = false;
+  uint32_t minimo = UINT32_MAX;
+  uint32_t maximo = 0;
+  File dir = fs.open(DIARIO_DIR);
+  for (File e = dir.openNextFile(); e; e = dir.openNextFile()) {
+    const char *nombre = strrchr(e.name(), '/');
+    nombre = nombre ? nombre + 1 : e.name();
+    char *fin;
+    uint32_t n = strtoul(nombre, &fin, 10);
+    if (fin != nombre && strcmp(fin, ".seg") == 0) {
+      haySegmentos = true;
+      minimo = min(minimo, n);
+      maximo = max(maximo, n);
+    }
+  }
+  dir.close();
+
+  uint32_t checkpoint[2] = {0, 0};
+  f = fs.open(DIARIO_CHECKPOINT, "r");
+  if (f) {
+    f.read((uint8_t *)checkpoint, sizeof(checkpoint));
+    f.close();
+  }
+
+  if (!haySegmentos) {
+    _segEscritura = checkpoint[0] + 1;
+    _segLectura = _segEscritura;
+    _offLectura = 0;
+  } else {
+    // Se escribe siempre en un segmento nuevo: si el último quedó con un
+    // registro a medias por un corte de luz, no se añade nada detrás.
+    _segEscritura = maximo + 1;
+    if (checkpoint[0] < minimo || checkpoint[0] > maximo) {
+      _segLectura = minimo;
+      _offLectura = 0;
+    } else {
+      _segLectura = checkpoint[0];
+      _offLectura = checkpoint[1];
+    }
+
+    // Segmentos ya confirmados que no llegaron a borrarse
+    char ruta[32];
+    for (uint32_t s = minimo; s < _segLectura; s++) {
+      rutaSegmento(s, ruta);
+      fs.remove(ruta);
+    }
+    for (uint32_t s = _segLectura; s <= maximo; s++) {
+      _stats.bytesPendientes += tamanoSegmento(s);
+    }
+    _stats.bytesPendientes -= min(_offLectura, _stats.bytesPendientes);
+  }
+  _tamEscritura = 0;
+  _stats.arranque = _arranque;
+  _checkpointMs = millis();
+  return true;
+}
+
+void DiarioTelemetria::rutaSegmento(uint32_t segmento, char *ruta) const {
+  snprintf(ruta, 32, "%s/%08lu.seg", DIARIO_DIR, (unsigned long)segmento);
+}
+
+uint32_t DiarioTelemetria::tamanoSegmento(uint32_t segmento) const {
+  char ruta[32];
+  rutaSegmento(segmento, ruta);
+  File f = _fs->open(ruta, "r");
+  if (!f) {
+    return 0;
+  }
+  uint32_t tam = f.size();
+  f.close();
+  return tam;
+}
+
+bool DiarioTelemetria::anotar(const char *datos, size_t longitud, uint32_t numero) {
+  if (!_fs) {
+    _stats.perdidos++;
+    return false;
+  }
+  TramoFlash tramo(_aviso);
+
+  if (_tamEscritura > 0 && _tamEscritura + sizeof(Cabecera) + longitud > DIARIO_TAM_SEGMENTO) {
+    _segEscritura++;
+    _tamEscritura = 0;
+  }
+  // Sin espacio: se sacrifica lo más antiguo
+  while (_segEscritura - _segLectura >= DIARIO_MAX_SEGMENTOS) {
+    _stats.perdidos++;
+    descartarSegmentoLectura();
+  }
+
+  Cabecera c = {DIARIO_MAGIA, _arranque, numero, (uint32_t)longitud, crc32(datos, longitud)};
+  char ruta[32];
+  rutaSegmento(_segEscritura, ruta);
+  File f = _fs->open(ruta, "a");
+  if (!f) {
+    _stats.perdidos++;
+    return false;
+  }
+  size_t escritos = f.write((const uint8_t *)&c, sizeof(c));
+  escritos += f.write((const uint8_t *)datos, longitud);
+  f.close();
+
+  if (escritos != sizeof(c) + longitud) {
+    // Registro a medias: lo siguiente va a un segmento nuevo
+    _stats.perdidos++;
+    _stats.bytesPendientes += escritos;
+    _segEscritura++;
+    _tamEscritura = 0;
+    return false;
+  }
+
+  _tamEscritura += escritos;
+  _stats.bytesPendientes += escritos;
+  _stats.anotados++;
+  return true;
+}
+
+bool DiarioTelemetria::hayPendientes() const {
+  return _fs && (_segLectura < _segEscritura || _offLectura < _tamEscritura);
+}
+
+size_t DiarioTelemetria::leerSiguiente(char *destino, size_t maximo, uint32_t &arranque, uint32_t &numero) {
+  TramoFlash tramo(_aviso);
+  while (hayPendientes()) {
+    char ruta[32];
+    rutaSegmento(_segLectura, ruta);
+    File f = _fs->open(ruta, "r");
+
+    Cabecera c;
+    bool leido = f && f.seek(_offLectura) &&
+                 f.read((uint8_t *)&c, sizeof(c)) == sizeof(c) &&
+                 c.magia == DIARIO_MAGIA && c.longitud <= maximo &&
+                 f.read((uint8_t *)destino, c.longitud) == c.longitud;
+    bool finSegmento = !f || _offLectura >= f.size();
+    if (f) {
+      f.close();
+    }
+
+    if (leido && crc32(destino, c.longitud) == c.crc) {
+      arranque = c.arranque;
+      numero = c.numero;
+      _siguienteOffset = _offLectura + sizeof(c) + c.longitud;
+      return c.longitud;
+    }
+
+    // Cabecera sana con el payload dañado: se pierde solo ese registro
+    if (leido) {
+      _stats.perdidos++;
+      _siguienteOffset = _offLectura + sizeof(c) + c.longitud;
+      avanzar();
+      continue;
+    }
+
+    // Fin de segmento o registro dañado: pasar al siguiente
+    if (!finSegmento) {
+      _stats.perdidos++;
+    }
+    if (_segLectura == _segEscritura) {
+      _segEscritura++;
+      _tamEscritura = 0;
+    }
+    descartarSegmentoLectura();
+  }
+  return 0;
+}
+
+void DiarioTelemetria::confirmar() {
+  TramoFlash tramo(_aviso);
+  _stats.reenviados++;
+  avanzar();
+}
+
+void DiarioTelemetria::avanzar() {
+  uint32_t avance = _siguienteOffset - _offLectura;
+  _stats.bytesPendientes -= min(avance, _stats.bytesPendientes);
+  _offLectura = _siguienteOffset;
+  _checkpointPendiente = true;
+  guardarCheckpointSiToca();
+}
+
+void DiarioTelemetria::descartarSegmentoLectura() {
+  char ruta[32];
+  rutaSegmento(_segLectura, ruta);
+  uint32_t restante = tamanoSegmento(_segLectura);
+  restante -= min(_offLectura, restante);
+  _stats.bytesPendientes -= min(restante, _stats.bytesPendientes);
+  _fs->remove(ruta);
+
+  _segLectura++;
+  _offLectura = 0;
+  _checkpointPendiente = true;
+  guardarCheckpointSiToca();
+}
+
+void DiarioTelemetria::guardarCheckpointSiToca() {
+  if (_checkpointPendiente &&
+      (!hayPendientes() || millis() - _checkpointMs >= DIARIO_CHECKPOINT_MS)) {
+    guardarCheckpoint();
+  }
+}
+
+void DiarioTelemetria::guardarCheckpoint() {
+  _checkpointPendiente = false;
+  _checkpointMs = millis();
+  uint32_t checkpoint[2] = {_segLectura, _offLectura};
+  File f = _fs->open(DIARIO_CHECKPOINT_TMP, "w");
+  if (!f) {
+    return;
+  }
+  f.write((const uint8_t *)checkpoint, sizeof(checkpoint));
+  f.close();
+  // rename en LittleFS reemplaza el destino de forma atómica
+  _fs->rename(DIARIO_CHECKPOINT_TMP, DIARIO_CHECKPOINT);
+}
+
+uint32_t DiarioTelemetria::arranque() const {
+  return _arranque;
+}
+
+EstadisticasDiario DiarioTelemetria::estadisticas() const {
+  return _stats;
+}
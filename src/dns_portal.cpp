@@ -0,0 +1,157 @@
+#include "dns_portal.h"
+
+#include <atomic>
+#include <lwip/sockets.h>
+
+// Cabecera DNS: id(2) flags(2) qdcount(2) ancount(2) nscount(2) arcount(2)
+static const size_t TAM_CABECERA = 12;
+static const uint16_t TIPO_A = 1;
+static const uint16_t CLASE_IN = 1;
+
+static int socketDns = -1;
+static uint8_t registroA[DNS_TAM_REGISTRO_A];
+
+static std::atomic<uint32_t> consultas(0);
+static std::atomic<uint32_t> respuestasA(0);
+static std::atomic<uint32_t> respuestasVacias(0);
+static std::atomic<uint32_t> descartadas(0);
+static std::atomic<uint32_t> consultasPorSegundo(0);
+static uint32_t inicioVentanaMs = 0;
+static uint32_t consultasVentana = 0;
+
+static uint16_t leer16(const uint8_t *p) {
+  return (p[0] << 8) | p[1];
+}
+
+static void escribir16(uint8_t *p, uint16_t v) {
+  p[0] = v >> 8;
+  p[1] = v & 0xFF;
+}
+
+void prepararRegistroDns(uint8_t registro[DNS_TAM_REGISTRO_A], IPAddress ip, uint32_t ttlS) {
+  escribir16(registro, 0xC000 | TAM_CABECERA);  // Nombre: puntero a la pregunta
+  escribir16(registro + 2, TIPO_A);
+  escribir16(registro + 4, CLASE_IN);
+  escribir16(registro + 6, ttlS >> 16);
+  escribir16(registro + 8, ttlS & 0xFFFF);
+  escribir16(registro + 10, 4);
+  for (uint8_t i = 0; i < 4; i++) {
+    registro[12 + i] = ip[i];
+  }
+}
+
+size_t armarRespuestaDns(const uint8_t *consulta, size_t longitud, uint8_t *respuesta,
+                         size_t maximo, const uint8_t registro[DNS_TAM_REGISTRO_A], bool &esTipoA) {
+  esTipoA = false;
+  if (longitud < TAM_CABECERA || longitud > maximo) {
+    return 0;
+  }
+  // Solo consultas estándar (QR = 0, OPCODE = 0) con una pregunta
+  uint16_t flags = leer16(consulta + 2);
+  if ((flags & 0xF800) != 0 || leer16(consulta + 4) != 1) {
+    return 0;
+  }
+
+  // Saltar el nombre: etiquetas sin compresión terminadas en 0
+  size_t fin = TAM_CABECERA;
+  while (fin < longitud && consulta[fin] != 0) {
+    if (consulta[fin] & 0xC0) {
+      return 0;
+    }
+    fin += consulta[fin] + 1;
+  }
+  fin += 1 + 4;  // 0 final, tipo y clase
+  if (fin > longitud) {
+    return 0;
+  }
+  uint16_t tipo = leer16(consulta + fin - 4);
+  uint16_t clase = leer16(consulta + fin - 2);
+  esTipoA = tipo == TIPO_A && clase == CLASE_IN;
+
+  // Cabecera y pregunta tal cual; se descarta lo que venga detrás (EDNS)
+  size_t total = fin + (esTipoA ? DNS_TAM_REGISTRO_A : 0);
+  if (total > maximo) {
+    return 0;
+  }
+  memcpy(respuesta, consulta, fin);
+  // QR = 1, AA = 1, se conserva RD, RA = 1, RCODE = 0
+  escribir16(respuesta + 2, 0x8400 | (flags & 0x0100) | 0x0080);
+  escribir16(respuesta + 6, esTipoA ? 1 : 0);
+  escribir16(respuesta + 8, 0);
+  escribir16(respuesta + 10, 0);
+  if (esTipoA) {
+    memcpy(respuesta + fin, registro, DNS_TAM_REGISTRO_A);
+  }
+  return total;
+}
+
+bool iniciarDnsPortal(IPAddress ip, uint16_t puerto) {
+  prepararRegistroDns(registroA, ip, DNS_TTL_S);
+  if (socketDns >= 0) {
+    return true;
+  }
+
+  int s = socket(AF_INET, SOCK_DGRAM, 0);
+  if (s < 0) {
+    return false;
+  }
+  sockaddr_in direccion = {};
+  direccion.sin_family = AF_INET;
+  direccion.sin_port = htons(puerto);
+  direccion.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(s, (sockaddr *)&direccion, sizeof(direccion)) < 0) {
+    close(s);
+    return false;
+  }
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+  socketDns = s;
+  inicioVentanaMs = millis();
+  return true;
+}
+
+void atenderDnsPortal() {
+  if (socketDns < 0) {
+    return;
+  }
+  // Estáticos: solo los usa la tarea de red
+  static uint8_t consulta[DNS_TAM_MAXIMO];
+  static uint8_t respuesta[DNS_TAM_MAXIMO];
+
+  for (uint8_t n = 0; n < DNS_MAX_POR_TICK; n++) {
+    sockaddr_in origen;
+    socklen_t tamOrigen = sizeof(origen);
+    int recibidos = recvfrom(socketDns, consulta, sizeof(consulta), MSG_DONTWAIT,
+                             (sockaddr *)&origen, &tamOrigen);
+    if (recibidos <= 0) {
+      break;
+    }
+    consultas.fetch_add(1, std::memory_order_relaxed);
+    consultasVentana++;
+
+    bool esTipoA;
+    size_t longitud = armarRespuestaDns(consulta, recibidos, respuesta, sizeof(respuesta), registroA, esTipoA);
+    if (longitud == 0 ||
+        sendto(socketDns, respuesta, longitud, 0, (sockaddr *)&origen, tamOrigen) != (int)longitud) {
+      descartadas.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    (esTipoA ? respuestasA : respuestasVacias).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t ahora = millis();
+  if (ahora - inicioVentanaMs >= 1000) {
+    consultasPorSegundo.store(consultasVentana * 1000 / (ahora - inicioVentanaMs), std::memory_order_relaxed);
+    consultasVentana = 0;
+    inicioVentanaMs = ahora;
+  }
+}
+
+EstadisticasDns leerEstadisticasDns() {
+  EstadisticasDns stats;
+  stats.consultas = consultas.load(std::memory_order_relaxed);
+  stats.respuestasA = respuestasA.load(std::memory_order_relaxed);
+  stats.respuestasVacias = respuestasVacias.load(std::memory_order_relaxed);
+  stats.descartadas = descartadas.load(std::memory_order_relaxed);
+  stats.consultasPorSegundo = consultasPorSegundo.load(std::memory_order_relaxed);
+  return stats;
+}
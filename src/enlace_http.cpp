@@ -0,0 +1,174 @@
+#include "enlace_http.h"
+
+#include <atomic>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <LittleFS.h>
+#include "adquisicion.h"
+#include "despacho_enlace.h"
+#include "diario_telemetria.h"
+#include "histograma.h"
+#include "lote_telemetria.h"
+#include "metricas.h"
+
+struct SlotPayload {
+  size_t longitud;
+  uint32_t numero;
+  char datos[ENLACE_TAM_PAYLOAD];
+};
+
+// Los payloads viven en un conjunto fijo de huecos; las colas solo mueven índices
+static SlotPayload slots[ENLACE_COLA];
+static QueueHandle_t colaLibres = NULL;
+static QueueHandle_t colaPendientes = NULL;
+static const char *urlServidor = nullptr;
+static std::atomic<uint32_t> siguienteNumero(0);
+
+// Sin conexión los payloads van al diario en flash y se reenvían al volver
+static DiarioTelemetria diario;
+static char bufferReenvio[ENLACE_TAM_PAYLOAD];
+
+// Histograma de latencias: límite superior de cada cubeta en ms
+static const uint32_t LIMITES_LATENCIA_MS[] = {10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000};
+static Histograma latencias(LIMITES_LATENCIA_MS, sizeof(LIMITES_LATENCIA_MS) / sizeof(LIMITES_LATENCIA_MS[0]));
+
+static std::atomic<uint32_t> conexiones(0);
+static std::atomic<uint32_t> reutilizadas(0);
+
+// Conexión keep-alive: solo la usa la tarea del enlace
+struct ConexionHttp {
+  WiFiClient cliente;
+  HTTPClient http;
+};
+static ConexionHttp conexion;
+
+// Un POST. Devuelve el código HTTP o <= 0 si no hubo respuesta.
+static int enviarHttp(void *contexto, const char *datos, size_t longitud,
+                      uint32_t arranque, uint32_t numero) {
+  ConexionHttp &c = *(ConexionHttp *)contexto;
+  bool reutilizada = c.cliente.connected();
+
+  // Identificador para que el servidor descarte lotes repetidos
+  char idLote[24];
+  snprintf(idLote, sizeof(idLote), "%lu-%lu", (unsigned long)arranque, (unsigned long)numero);
+
+  // El formato se reconoce por el primer byte: el JSON siempre empieza por '{'
+  bool esJson = longitud > 0 && datos[0] == '{';
+
+  c.http.begin(c.cliente, urlServidor);
+  c.http.addHeader("Content-Type", esJson ? TIPO_CONTENIDO_JSON : TIPO_CONTENIDO_BINARIO);
+  c.http.addHeader("X-Lote", idLote);
+
+  uint32_t inicio = millis();
+  int codigo = c.http.POST((uint8_t *)datos, longitud);
+
+  if (codigo <= 0) {
+    Serial.print("Error en la peticion HTTP. Codigo: ");
+    Serial.println(codigo);
+    c.http.end();
+    c.cliente.stop();
+    return codigo;
+  }
+
+  // Leer el cuerpo completo para que la conexión pueda reutilizarse
+  c.http.getString();
+  latencias.registrar(millis() - inicio);
+  c.http.end();
+
+  if (reutilizada) {
+    reutilizadas.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    conexiones.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (codigo >= 300) {
+    Serial.print("Codigo de respuesta HTTP: ");
+    Serial.println(codigo);
+  }
+  return codigo;
+}
+
+static DespachoEnlace despacho(diario, bufferReenvio, sizeof(bufferReenvio), enviarHttp, &conexion);
+
+static void tareaEnlace(void *) {
+  conexion.http.setReuse(true);
+
+  for (;;) {
+    bool enLinea = WiFi.status() == WL_CONNECTED;
+
+    // Con atrasos en el diario no se espera a que lleguen payloads nuevos
+    TickType_t espera = portMAX_DELAY;
+    if (diario.hayPendientes()) {
+      uint32_t faltaMs = despacho.esperaRestanteMs();
+      espera = enLinea && faltaMs == 0 ? 0 : pdMS_TO_TICKS(faltaMs > 0 ? min(faltaMs, (uint32_t)1000) : 1000);
+    }
+
+    uint8_t indice;
+    if (xQueueReceive(colaPendientes, &indice, espera) == pdTRUE) {
+      const SlotPayload &slot = slots[indice];
+      despacho.despachar(slot.datos, slot.longitud, slot.numero, enLinea);
+      xQueueSend(colaLibres, &indice, 0);
+      continue;
+    }
+
+    // Reenvío del diario, un registro por vuelta
+    despacho.reenviarDiario(enLinea);
+  }
+}
+
+void iniciarEnlaceHttp(const char *url) {
+  urlServidor = url;
+  diario.avisarFlash(marcarOperacionFlash);
+  if (!LittleFS.begin(true) || !diario.iniciar(LittleFS)) {
+    Serial.println("Diario de telemetría no disponible");
+  }
+  colaLibres = xQueueCreate(ENLACE_COLA, sizeof(uint8_t));
+  colaPendientes = xQueueCreate(ENLACE_COLA, sizeof(uint8_t));
+  for (uint8_t i = 0; i < ENLACE_COLA; i++) {
+    xQueueSend(colaLibres, &i, 0);
+  }
+  TaskHandle_t tarea = NULL;
+  xTaskCreatePinnedToCore(tareaEnlace, "enlace", 6144, NULL, 1, &tarea, ENLACE_NUCLEO);
+  registrarTareaMetricas("enlace", tarea);
+}
+
+bool encolarPayload(const char *datos, size_t longitud) {
+  uint8_t indice;
+  if (longitud > ENLACE_TAM_PAYLOAD || xQueueReceive(colaLibres, &indice, 0) != pdTRUE) {
+    despacho.registrarDescarte();
+    return false;
+  }
+  memcpy(slots[indice].datos, datos, longitud);
+  slots[indice].longitud = longitud;
+  slots[indice].numero = siguienteNumero.fetch_add(1, std::memory_order_relaxed);
+  xQueueSend(colaPendientes, &indice, 0);
+  return true;
+}
+
+bool enlaceAceptaBinario() {
+  return despacho.aceptaBinario();
+}
+
+EstadisticasEnlace leerEstadisticasEnlace() {
+  EstadisticasDespacho despachos = despacho.estadisticas();
+  EstadisticasEnlace stats;
+  stats.enviados = despachos.enviados;
+  stats.fallidos = despachos.fallidos;
+  stats.rechazados = despachos.rechazados;
+  stats.descartados = despachos.descartados;
+  stats.conexiones = conexiones.load(std::memory_order_relaxed);
+  stats.reutilizadas = reutilizadas.load(std::memory_order_relaxed);
+  stats.latenciaP50Ms = latencias.percentil(50);
+  stats.latenciaP90Ms = latencias.percentil(90);
+  stats.latenciaP99Ms = latencias.percentil(99);
+  stats.enCola = colaPendientes ? uxQueueMessagesWaiting(colaPendientes) : 0;
+  return stats;
+}
+
+const Histograma &leerLatenciasEnlace() {
+  return latencias;
+}
+
+EstadisticasDiario leerEstadisticasDiario() {
+  // Copia sin sincronizar: solo para mostrar
+  return diario.estadisticas();
+}
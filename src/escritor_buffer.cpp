@@ -0,0 +1,148 @@
+#include "escritor_buffer.h"
+
+EscritorBuffer::EscritorBuffer(char *buffer, size_t capacidad)
+  : _buffer(buffer), _capacidad(capacidad) {
+  if (_capacidad > 0) {
+    _buffer[0] = '\0';
+  }
+}
+
+EscritorBuffer::EscritorBuffer(char *buffer, size_t capacidad, FuncionVaciado vaciado, void *contexto)
+  : EscritorBuffer(buffer, capacidad) {
+  _vaciado = vaciado;
+  _contexto = contexto;
+}
+
+EscritorBuffer &EscritorBuffer::agregar(const char *datos, size_t longitud) {
+  // Se reserva un byte para el '\0'
+  size_t libre = _capacidad > _longitud ? _capacidad - _longitud - 1 : 0;
+
+  // Con vaciado se llena la ventana, se entrega y se continúa
+  while (_vaciado && _capacidad > 1 && longitud > libre && !_desbordado) {
+    memcpy(_buffer + _longitud, datos, libre);
+    _longitud += libre;
+    datos += libre;
+    longitud -= libre;
+    if (!vaciar()) {
+      return *this;
+    }
+    libre = _capacidad - 1;
+  }
+
+  if (longitud > libre) {
+    longitud = libre;
+    _desbordado = true;
+  }
+  memcpy(_buffer + _longitud, datos, longitud);
+  _longitud += longitud;
+  if (_capacidad > 0) {
+    _buffer[_longitud] = '\0';
+  }
+  return *this;
+}
+
+EscritorBuffer &EscritorBuffer::agregar(const char *texto) {
+  return agregar(texto, strlen(texto));
+}
+
+EscritorBuffer &EscritorBuffer::agregar(char c) {
+  return agregar(&c, 1);
+}
+
+EscritorBuffer &EscritorBuffer::agregarSinSigno(uint32_t valor) {
+  char digitos[10];
+  size_t n = 0;
+  do {
+    digitos[sizeof(digitos) - 1 - n++] = '0' + valor % 10;
+    valor /= 10;
+  } while (valor > 0);
+  return agregar(digitos + sizeof(digitos) - n, n);
+}
+
+EscritorBuffer &EscritorBuffer::agregarEntero(int32_t valor) {
+  if (valor < 0) {
+    agregar('-');
+    return agregarSinSigno(-(uint32_t)valor);
+  }
+  return agregarSinSigno(valor);
+}
+
+EscritorBuffer &EscritorBuffer::agregarFijo(float valor, uint8_t decimales) {
+  if (decimales > 6) {
+    decimales = 6;
+  }
+  uint32_t escala = 1;
+  for (uint8_t i = 0; i < decimales; i++) {
+    escala *= 10;
+  }
+
+  if (isnan(valor)) {
+    return agregar("nan");
+  }
+  if (valor < 0) {
+    valor = -valor;
+    agregar('-');
+  }
+  if (isinf(valor)) {
+    return agregar("inf");
+  }
+
+  // Convertir a entero fuera de rango es indefinido: se pierden decimales
+  // hasta que quepa en 32 bits y, si ni así, se satura
+  const float tope = 4294967296.0f;
+  while (decimales > 0 && valor * escala + 0.5f >= tope) {
+    decimales--;
+    escala /= 10;
+  }
+  float redondeado = valor * escala + 0.5f;
+  uint32_t escalado = redondeado < tope ? (uint32_t)redondeado : UINT32_MAX;
+  agregarSinSigno(escalado / escala);
+  if (decimales == 0) {
+    return *this;
+  }
+
+  // Parte decimal con ceros a la izquierda
+  agregar('.');
+  uint32_t fraccion = escalado % escala;
+  for (uint32_t d = escala / 10; d > 0; d /= 10) {
+    agregar((char)('0' + (fraccion / d) % 10));
+  }
+  return *this;
+}
+
+const char *EscritorBuffer::c_str() const {
+  return _buffer;
+}
+
+size_t EscritorBuffer::longitud() const {
+  return _longitud;
+}
+
+size_t EscritorBuffer::capacidad() const {
+  return _capacidad;
+}
+
+bool EscritorBuffer::desbordado() const {
+  return _desbordado;
+}
+
+bool EscritorBuffer::vaciar() {
+  if (!_vaciado || _desbordado) {
+    return !_desbordado;
+  }
+  if (_longitud > 0 && !_vaciado(_contexto, _buffer, _longitud)) {
+    _desbordado = true;
+    return false;
+  }
+  _longitud = 0;
+  _buffer[0] = '\0';
+  return true;
+}
+
+void EscritorBuffer::reiniciar() {
+  _longitud = 0;
+  _desbordado = false;
+  if (_capacidad > 0) {
+    _buffer[0] = '\0';
+  }
+}
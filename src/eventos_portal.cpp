@@ -0,0 +1,147 @@
+#include "eventos_portal.h"
+
+#include <atomic>
+
+// Sockets de los clientes suscritos
+struct ClienteEventos {
+  int fd;
+  bool activo;
+};
+
+static ClienteEventos clientes[EVENTOS_MAX_CLIENTES];
+static std::atomic<uint8_t> totalClientes(0);
+static EstadoPortal ultimoEstado = {};
+static bool hayEstado = false;
+static uint32_t ultimoEnvioMs = 0;
+
+static const char CABECERAS_EVENTOS[] =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: text/event-stream\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n"
+  "retry: 2000\n\n";
+
+// Objeto JSON con los campos distintos de "anterior" (todos si es nullptr).
+// Devuelve false si no hay ninguno.
+static bool escribirCampos(EscritorBuffer &json, const EstadoPortal &estado,
+                           const EstadoPortal *anterior) {
+  json.agregar('{');
+  bool primero = true;
+  auto campo = [&](const char *nombre) -> EscritorBuffer & {
+    json.agregar(primero ? "\"" : ",\"").agregar(nombre).agregar("\":");
+    primero = false;
+    return json;
+  };
+
+  if (!anterior || anterior->cajas != estado.cajas) {
+    campo("cajas").agregarSinSigno(estado.cajas);
+  }
+  if (!anterior || anterior->conectado != estado.conectado) {
+    campo("conectado").agregar(estado.conectado ? "true" : "false");
+  }
+  if (estado.conectado && (!anterior || !anterior->conectado || anterior->angulo != estado.angulo)) {
+    campo("angulo").agregarSinSigno(estado.angulo);
+  }
+  if (!anterior || anterior->libre != estado.libre) {
+    campo("libre").agregar(estado.libre ? "true" : "false");
+  }
+  json.agregar('}');
+  return !primero;
+}
+
+static bool escribirEvento(EscritorBuffer &evento, const EstadoPortal &estado,
+                           const EstadoPortal *anterior) {
+  evento.agregar("data: ");
+  bool cambios = escribirCampos(evento, estado, anterior);
+  evento.agregar("\n\n");
+  return cambios && !evento.desbordado();
+}
+
+static bool enviar(httpd_handle_t servidor, int fd, const char *datos, size_t longitud) {
+  // Un cliente que no acepta el evento completo se cierra; al borrar la
+  // sesión el servidor libera su hueco con liberarCliente()
+  int enviados = httpd_socket_send(servidor, fd, datos, longitud, 0);
+  if (enviados < 0 || (size_t)enviados != longitud) {
+    httpd_sess_trigger_close(servidor, fd);
+    return false;
+  }
+  return true;
+}
+
+// Contexto de la sesión de cada suscriptor: esp_http_server lo libera al
+// cerrarla por cualquier motivo (desconexión, error de envío o purga)
+static void liberarCliente(void *contexto) {
+  ClienteEventos *cliente = (ClienteEventos *)contexto;
+  if (cliente->activo) {
+    cliente->activo = false;
+    totalClientes.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+esp_err_t aceptarClienteEventos(httpd_req_t *req, const EstadoPortal &estado) {
+  for (uint8_t i = 0; i < EVENTOS_MAX_CLIENTES; i++) {
+    if (clientes[i].activo) {
+      continue;
+    }
+    // La respuesta no termina nunca: se escribe directamente en el socket
+    int fd = httpd_req_to_sockfd(req);
+    if (!enviar(req->handle, fd, CABECERAS_EVENTOS, sizeof(CABECERAS_EVENTOS) - 1)) {
+      return ESP_FAIL;
+    }
+    clientes[i] = {fd, true};
+    totalClientes.fetch_add(1, std::memory_order_relaxed);
+    req->sess_ctx = &clientes[i];
+    req->free_ctx = liberarCliente;
+
+    char datos[96];
+    EscritorBuffer evento(datos, sizeof(datos));
+    if (escribirEvento(evento, estado, nullptr)) {
+      enviar(req->handle, fd, evento.c_str(), evento.longitud());
+    }
+    return ESP_OK;
+  }
+  httpd_resp_set_status(req, "503 Service Unavailable");
+  return httpd_resp_send(req, "Demasiados clientes", HTTPD_RESP_USE_STRLEN);
+}
+
+void publicarEventos(httpd_handle_t servidor, const EstadoPortal &estado, uint32_t ahoraMs) {
+  char datos[96];
+  EscritorBuffer evento(datos, sizeof(datos));
+  bool cambios = escribirEvento(evento, estado, hayEstado ? &ultimoEstado : nullptr);
+  ultimoEstado = estado;
+  hayEstado = true;
+
+  if (!cambios) {
+    if (ahoraMs - ultimoEnvioMs < EVENTOS_KEEPALIVE_MS) {
+      return;
+    }
+    evento.reiniciar();
+    evento.agregar(":\n\n");
+  }
+  ultimoEnvioMs = ahoraMs;
+
+  for (uint8_t i = 0; i < EVENTOS_MAX_CLIENTES; i++) {
+    if (clientes[i].activo) {
+      enviar(servidor, clientes[i].fd, evento.c_str(), evento.longitud());
+    }
+  }
+}
+
+bool esClienteEventos(int fd) {
+  for (uint8_t i = 0; i < EVENTOS_MAX_CLIENTES; i++) {
+    if (clientes[i].activo && clientes[i].fd == fd) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool serializarEstadoPortal(EscritorBuffer &json, const EstadoPortal &estado) {
+  escribirCampos(json, estado, nullptr);
+  return !json.desbordado();
+}
+
+uint8_t clientesEventos() {
+  return totalClientes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,64 @@
+#include "histograma.h"
+
+Histograma::Histograma(const uint32_t *limites, size_t cantidad)
+  : _limites(limites), _cantidad(min(cantidad, (size_t)HISTOGRAMA_MAX_CUBETAS)) {
+  for (size_t i = 0; i <= HISTOGRAMA_MAX_CUBETAS; i++) {
+    _cuentas[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void Histograma::registrar(uint32_t valor) {
+  size_t i = 0;
+  while (i < _cantidad && valor > _limites[i]) {
+    i++;
+  }
+  _cuentas[i].fetch_add(1, std::memory_order_relaxed);
+  _suma.fetch_add(valor, std::memory_order_relaxed);
+}
+
+size_t Histograma::cubetas() const {
+  return _cantidad;
+}
+
+uint32_t Histograma::limite(size_t indice) const {
+  return indice < _cantidad ? _limites[indice] : UINT32_MAX;
+}
+
+uint32_t Histograma::cuenta(size_t indice) const {
+  return indice <= _cantidad ? _cuentas[indice].load(std::memory_order_relaxed) : 0;
+}
+
+uint32_t Histograma::total() const {
+  uint32_t total = 0;
+  for (size_t i = 0; i <= _cantidad; i++) {
+    total += _cuentas[i].load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+uint64_t Histograma::suma() const {
+  return _suma.load(std::memory_order_relaxed);
+}
+
+uint32_t Histograma::percentil(uint32_t p) const {
+  // Copia para que total y acumulado salgan de los mismos valores
+  uint32_t cuentas[HISTOGRAMA_MAX_CUBETAS + 1];
+  uint32_t total = 0;
+  for (size_t i = 0; i <= _cantidad; i++) {
+    cuentas[i] = _cuentas[i].load(std::memory_order_relaxed);
+    total += cuentas[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  uint32_t objetivo = (total * p + 99) / 100;
+  uint32_t acumulado = 0;
+  for (size_t i = 0; i <= _cantidad; i++) {
+    acumulado += cuentas[i];
+    if (acumulado >= objetivo) {
+      return limite(i);
+    }
+  }
+  return UINT32_MAX;
+}
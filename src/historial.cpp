@@ -0,0 +1,223 @@
+#include "historial.h"
+
+// Cuentas por vuelta del AS5600
+static const int32_t VUELTA = 4096;
+
+// Mínimo, máximo y suma de una serie dentro del periodo en curso
+struct Acumulado {
+  int32_t min;
+  int32_t max;
+  int64_t suma;
+};
+
+// Para la media del ángulo: la posición desenrollada respecto a la primera
+// muestra del periodo, tomando entre dos muestras el camino más corto. Con la
+// media de las cuentas en bruto, 4090 y 6 darían 2048 en lugar de 0.
+struct Desenrollado {
+  int32_t base;
+  int32_t anterior;
+  int32_t posicion;
+  int64_t suma;
+};
+
+class NivelHistorial {
+public:
+  NivelHistorial(PuntoHistorial *puntos, size_t capacidad, uint32_t periodoS)
+    : _puntos(puntos), _capacidad(capacidad), _periodoS(periodoS) {}
+
+  void agregar(uint32_t periodo, int32_t cajas, int16_t angulo, int16_t rpm, SemaphoreHandle_t candado) {
+    if (_muestras > 0 && periodo != _periodoActual) {
+      cerrar(periodo, candado);
+    }
+    if (_muestras == 0) {
+      _periodoActual = periodo;
+      iniciarAcumulado(_cajas, cajas);
+      iniciarAcumulado(_angulo, angulo);
+      iniciarAcumulado(_rpm, rpm);
+      _posicion = {angulo, angulo, 0, 0};
+    } else {
+      sumar(_cajas, cajas);
+      sumar(_angulo, angulo);
+      sumar(_rpm, rpm);
+      desenrollar(_posicion, angulo);
+    }
+    _muestras++;
+  }
+
+  // Copia el punto con número de orden "orden". Falso si ya se sobrescribió.
+  bool leer(uint32_t orden, PuntoHistorial &punto) const {
+    if (orden >= _total || _total - orden > _capacidad) {
+      return false;
+    }
+    punto = _puntos[orden % _capacidad];
+    return true;
+  }
+
+  uint32_t total() const { return _total; }
+  size_t capacidad() const { return _capacidad; }
+  uint32_t periodoS() const { return _periodoS; }
+  // Periodo siguiente al último punto guardado
+  uint32_t finPeriodo() const { return _finPeriodo; }
+
+private:
+  static void iniciarAcumulado(Acumulado &a, int32_t v) {
+    a.min = v;
+    a.max = v;
+    a.suma = v;
+  }
+
+  static void sumar(Acumulado &a, int32_t v) {
+    if (v < a.min) a.min = v;
+    if (v > a.max) a.max = v;
+    a.suma += v;
+  }
+
+  static void desenrollar(Desenrollado &d, int32_t v) {
+    int32_t paso = v - d.anterior;
+    if (paso > VUELTA / 2) {
+      paso -= VUELTA;
+    } else if (paso < -VUELTA / 2) {
+      paso += VUELTA;
+    }
+    d.anterior = v;
+    d.posicion += paso;
+    d.suma += d.posicion;
+  }
+
+  int16_t mediaAngulo() const {
+    int32_t media = (_posicion.base + _posicion.suma / (int32_t)_muestras) % VUELTA;
+    return media < 0 ? media + VUELTA : media;
+  }
+
+  void guardar(const PuntoHistorial &punto) {
+    _puntos[_total % _capacidad] = punto;
+    _total++;
+  }
+
+  void cerrar(uint32_t periodoNuevo, SemaphoreHandle_t candado) {
+    PuntoHistorial punto;
+    punto.cajasMin = _cajas.min;
+    punto.cajasMax = _cajas.max;
+    punto.cajasMedia = _cajas.suma / _muestras;
+    punto.anguloMin = _angulo.min;
+    punto.anguloMax = _angulo.max;
+    punto.anguloMedia = mediaAngulo();
+    punto.rpmMin = _rpm.min;
+    punto.rpmMax = _rpm.max;
+    punto.rpmMedia = _rpm.suma / _muestras;
+
+    // Periodos sin muestras (tarea detenida) quedan como puntos vacíos,
+    // como mucho un anillo entero
+    PuntoHistorial vacio = {};
+    vacio.anguloMin = -1;
+    uint32_t huecos = periodoNuevo - _periodoActual - 1;
+    if (huecos > _capacidad) {
+      huecos = _capacidad;
+    }
+
+    xSemaphoreTake(candado, portMAX_DELAY);
+    guardar(punto);
+    for (uint32_t i = 0; i < huecos; i++) {
+      guardar(vacio);
+    }
+    _finPeriodo = periodoNuevo;
+    xSemaphoreGive(candado);
+    _muestras = 0;
+  }
+
+  PuntoHistorial *_puntos;
+  size_t _capacidad;
+  uint32_t _periodoS;
+  uint32_t _total = 0;
+  uint32_t _finPeriodo = 0;
+  uint32_t _periodoActual = 0;
+  uint32_t _muestras = 0;
+  Acumulado _cajas = {};
+  Acumulado _angulo = {};
+  Acumulado _rpm = {};
+  Desenrollado _posicion = {};
+};
+
+static PuntoHistorial puntosSegundo[HISTORIAL_PUNTOS_SEGUNDO];
+static PuntoHistorial puntosMinuto[HISTORIAL_PUNTOS_MINUTO];
+static PuntoHistorial puntosCuarto[HISTORIAL_PUNTOS_CUARTO];
+
+static NivelHistorial niveles[HISTORIAL_NIVELES] = {
+  NivelHistorial(puntosSegundo, HISTORIAL_PUNTOS_SEGUNDO, 1),
+  NivelHistorial(puntosMinuto, HISTORIAL_PUNTOS_MINUTO, 60),
+  NivelHistorial(puntosCuarto, HISTORIAL_PUNTOS_CUARTO, 900),
+};
+
+// Protege solo los anillos y durante la copia de unos pocos puntos
+static SemaphoreHandle_t candado = NULL;
+
+void iniciarHistorial() {
+  if (!candado) {
+    candado = xSemaphoreCreateMutex();
+  }
+}
+
+void agregarHistorial(uint32_t ahoraMs, uint32_t cajas, uint16_t angulo, float rpm) {
+  if (!candado) {
+    return;
+  }
+  int16_t rpmAcotadas = constrain(rpm, -32767.0f, 32767.0f);
+  uint32_t ahoraS = ahoraMs / 1000;
+  for (uint8_t i = 0; i < HISTORIAL_NIVELES; i++) {
+    niveles[i].agregar(ahoraS / niveles[i].periodoS(), cajas, angulo, rpmAcotadas, candado);
+  }
+}
+
+uint32_t periodoHistorialS(uint8_t nivel) {
+  return nivel < HISTORIAL_NIVELES ? niveles[nivel].periodoS() : 0;
+}
+
+bool escribirHistorial(EscritorBuffer &json, uint8_t nivel, uint32_t ahoraMs) {
+  if (nivel >= HISTORIAL_NIVELES || !candado) {
+    return false;
+  }
+  const NivelHistorial &n = niveles[nivel];
+
+  xSemaphoreTake(candado, portMAX_DELAY);
+  uint32_t hasta = n.total();
+  uint32_t finS = n.finPeriodo() * n.periodoS();
+  xSemaphoreGive(candado);
+  uint32_t desde = hasta > n.capacidad() ? hasta - n.capacidad() : 0;
+
+  json.agregar("{\"periodo\":").agregarSinSigno(n.periodoS());
+  json.agregar(",\"fin\":").agregarSinSigno(finS);
+  json.agregar(",\"ahora\":").agregarSinSigno(ahoraMs / 1000);
+  json.agregar(",\"p\":[");
+
+  // Se copia por tandas para no retener el candado mientras se envía
+  const uint32_t TANDA = 16;
+  PuntoHistorial tanda[TANDA];
+  for (uint32_t orden = desde; orden < hasta; orden += TANDA) {
+    uint32_t cantidad = min(TANDA, hasta - orden);
+    bool validos[TANDA];
+    xSemaphoreTake(candado, portMAX_DELAY);
+    for (uint32_t i = 0; i < cantidad; i++) {
+      validos[i] = n.leer(orden + i, tanda[i]);
+    }
+    xSemaphoreGive(candado);
+
+    for (uint32_t i = 0; i < cantidad; i++) {
+      if (orden + i > desde) {
+        json.agregar(',');
+      }
+      // Sobrescrito durante la consulta o sin muestras: hueco
+      const PuntoHistorial &p = tanda[i];
+      if (!validos[i] || p.anguloMin < 0) {
+        json.agregar("null");
+        continue;
+      }
+      json.agregar('[').agregarEntero(p.cajasMin).agregar(',').agregarEntero(p.cajasMax);
+      json.agregar(',').agregarEntero(p.cajasMedia).agregar(',').agregarEntero(p.anguloMin);
+      json.agregar(',').agregarEntero(p.anguloMax).agregar(',').agregarEntero(p.anguloMedia);
+      json.agregar(',').agregarEntero(p.rpmMin).agregar(',').agregarEntero(p.rpmMax);
+      json.agregar(',').agregarEntero(p.rpmMedia).agregar(']');
+    }
+  }
+  json.agregar("]}");
+  return !json.desbordado();
+}
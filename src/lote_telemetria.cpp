@@ -0,0 +1,203 @@
+#include "lote_telemetria.h"
+
+// Escritor de varints con control de espacio
+struct EscritorVarint {
+  uint8_t *p;
+  uint8_t *fin;
+  bool desbordado;
+
+  void byte(uint8_t b) {
+    if (p == fin) {
+      desbordado = true;
+      return;
+    }
+    *p++ = b;
+  }
+
+  void sinSigno(uint32_t v) {
+    while (v >= 0x80) {
+      byte((v & 0x7F) | 0x80);
+      v >>= 7;
+    }
+    byte(v);
+  }
+
+  void conSigno(int32_t v) {
+    sinSigno(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+  }
+};
+
+// Lector de varints; cualquier lectura fuera del buffer marca error
+struct LectorVarint {
+  const uint8_t *p;
+  const uint8_t *fin;
+  bool error;
+
+  uint8_t byte() {
+    if (p == fin) {
+      error = true;
+      return 0;
+    }
+    return *p++;
+  }
+
+  uint32_t sinSigno() {
+    uint32_t v = 0;
+    for (uint8_t desplazamiento = 0; desplazamiento < 35; desplazamiento += 7) {
+      uint8_t b = byte();
+      v |= (uint32_t)(b & 0x7F) << desplazamiento;
+      if (!(b & 0x80)) {
+        return v;
+      }
+    }
+    error = true;   // Más de 5 bytes: no es un uint32
+    return 0;
+  }
+
+  int32_t conSigno() {
+    uint32_t v = sinSigno();
+    return (int32_t)((v >> 1) ^ (0 - (v & 1)));
+  }
+};
+
+bool LoteTelemetria::agregar(const Muestra &muestra) {
+  // micros() desborda cada 71 min: se pasa a la base de millis() por diferencia
+  uint32_t tiempoMs = millis() - (micros() - muestra.tiempoUs) / 1000;
+  if (_cantidad > 0 && tiempoMs - _ultimoPuntoMs < LOTE_INTERVALO_MS) {
+    return true;
+  }
+  _ultimoPuntoMs = tiempoMs;
+
+  if (_cantidad == LOTE_MAX_PUNTOS) {
+    _perdidos++;
+    return false;
+  }
+
+  PuntoTelemetria &p = _puntos[_cantidad++];
+  p.tiempoMs = tiempoMs;
+  p.conteo = muestra.conteo;
+  p.angulo = muestra.conectado ? muestra.angulo : 0;
+  return true;
+}
+
+bool LoteTelemetria::listoParaEnviar(uint32_t ahoraMs) const {
+  if (_cantidad == 0) {
+    return false;
+  }
+  return _cantidad == LOTE_MAX_PUNTOS || ahoraMs - _puntos[0].tiempoMs >= LOTE_MAX_EDAD_MS;
+}
+
+void LoteTelemetria::vaciar() {
+  _cantidad = 0;
+}
+
+bool LoteTelemetria::serializar(EscritorBuffer &json, uint32_t ahoraMs) const {
+  uint32_t t0 = _cantidad > 0 ? _puntos[0].tiempoMs : ahoraMs;
+  json.agregar("{\"t0\":").agregarSinSigno(t0);
+  json.agregar(",\"ahora\":").agregarSinSigno(ahoraMs);
+
+  json.agregar(",\"t\":[");
+  for (size_t i = 0; i < _cantidad; i++) {
+    if (i > 0) json.agregar(',');
+    json.agregarSinSigno(_puntos[i].tiempoMs - t0);
+  }
+  json.agregar("],\"angulo\":[");
+  for (size_t i = 0; i < _cantidad; i++) {
+    if (i > 0) json.agregar(',');
+    json.agregarSinSigno(_puntos[i].angulo);
+  }
+  json.agregar("],\"conteo_cajas\":[");
+  for (size_t i = 0; i < _cantidad; i++) {
+    if (i > 0) json.agregar(',');
+    json.agregarSinSigno(_puntos[i].conteo);
+  }
+  json.agregar("]}");
+  return !json.desbordado();
+}
+
+size_t LoteTelemetria::codificarBinario(uint8_t *destino, size_t maximo, uint32_t ahoraMs) const {
+  EscritorVarint w = {destino, destino + maximo, false};
+  uint32_t t0 = _cantidad > 0 ? _puntos[0].tiempoMs : ahoraMs;
+
+  w.byte(LOTE_VERSION_BINARIO);
+  w.sinSigno(_cantidad);
+  w.sinSigno(t0);
+  w.sinSigno(ahoraMs - t0);
+  w.sinSigno(LOTE_INTERVALO_MS);
+
+  uint32_t anterior = t0 - LOTE_INTERVALO_MS;
+  for (size_t i = 0; i < _cantidad; i++) {
+    w.conSigno((int32_t)(_puntos[i].tiempoMs - anterior - LOTE_INTERVALO_MS));
+    anterior = _puntos[i].tiempoMs;
+  }
+
+  int32_t anguloAnterior = 0;
+  for (size_t i = 0; i < _cantidad; i++) {
+    int32_t delta = (int32_t)_puntos[i].angulo - anguloAnterior;
+    // El camino más corto alrededor del círculo
+    if (delta > 2047) delta -= 4096;
+    else if (delta < -2048) delta += 4096;
+    w.conSigno(delta);
+    anguloAnterior = _puntos[i].angulo;
+  }
+
+  uint32_t conteoAnterior = 0;
+  for (size_t i = 0; i < _cantidad; i++) {
+    w.conSigno((int32_t)(_puntos[i].conteo - conteoAnterior));
+    conteoAnterior = _puntos[i].conteo;
+  }
+
+  return w.desbordado ? 0 : w.p - destino;
+}
+
+bool LoteTelemetria::decodificarBinario(const uint8_t *origen, size_t longitud, uint32_t &ahoraMs) {
+  LectorVarint r = {origen, origen + longitud, false};
+  _cantidad = 0;
+
+  if (r.byte() != LOTE_VERSION_BINARIO) {
+    return false;
+  }
+  uint32_t n = r.sinSigno();
+  uint32_t t0 = r.sinSigno();
+  ahoraMs = t0 + r.sinSigno();
+  uint32_t intervalo = r.sinSigno();
+  if (r.error || n > LOTE_MAX_PUNTOS) {
+    return false;
+  }
+
+  uint32_t anterior = t0 - intervalo;
+  for (uint32_t i = 0; i < n; i++) {
+    anterior += intervalo + r.conSigno();
+    _puntos[i].tiempoMs = anterior;
+  }
+  int32_t angulo = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    angulo = (angulo + r.conSigno()) & 0x0FFF;
+    _puntos[i].angulo = angulo;
+  }
+  uint32_t conteo = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    conteo += r.conSigno();
+    _puntos[i].conteo = conteo;
+  }
+
+  // Ni bytes de menos ni de sobra
+  if (r.error || r.p != r.fin) {
+    return false;
+  }
+  _cantidad = n;
+  _ultimoPuntoMs = n > 0 ? _puntos[n - 1].tiempoMs : 0;
+  return true;
+}
+
+size_t LoteTelemetria::cantidad() const {
+  return _cantidad;
+}
+
+const PuntoTelemetria &LoteTelemetria::punto(size_t indice) const {
+  return _puntos[indice];
+}
+
+uint32_t LoteTelemetria::perdidos() const {
+  return _perdidos;
+}
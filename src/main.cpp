@@ -3,11 +3,25 @@
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
-#include <WebServer.h>
-#include <DNSServer.h>
 #include <Wire.h>
 #include "AS5600.h"
+#include "contador_cajas.h"
+#include "adquisicion.h"
+#ifdef ADQUISICION_PWM
+#include "captura_pwm.h"
+#endif
+#ifdef ADQUISICION_ADC
+#include "adc_as5600.h"
+#endif
+#include "lote_telemetria.h"
+#include "enlace_http.h"
+#include "escritor_buffer.h"
+#include "eventos_portal.h"
+#include "servidor_portal.h"
+#include "dns_portal.h"
+#include "planificador.h"
+#include "metricas.h"
+#include "historial.h"
 
 // Declaración de variables
 const int E18D80NK_PIN = 26;
@@ -15,12 +29,27 @@ const int AS5600_SDA = 21;
 const int AS5600_SCL = 22;
 bool modeBleActivo = false;
 
-volatile unsigned int conteoCajas = 0;
-int estadoAnterior = HIGH;
-int estadoActual = LOW;
-unsigned ultimoTiempoLectura = 0;
-const unsigned long intervaloLectura = 500;
-int ultimoAnguloAS5600=0;
+const unsigned long intervaloMuestras = 20;
+const unsigned long intervaloHttp = 200;  // Revisión del lote; se envía por tamaño o edad
+const unsigned long intervaloBLE = 5000;
+const unsigned long intervaloHistorial = 100;  // Muestras por punto de 1 s: 10
+LoteTelemetria loteTelemetria;
+uint32_t puntosEncolados = 0;
+uint32_t bytesEncolados = 0;
+
+// Tareas cooperativas de la tarea de red (núcleo 0)
+Planificador planificador;
+const uint8_t RED_NUCLEO = 0;
+
+// Configuración WiFi por Bluetooth paso a paso
+enum EstadoWiFi { WIFI_INACTIVO, WIFI_ESPERA_SSID, WIFI_ESPERA_PASS, WIFI_CONECTANDO };
+EstadoWiFi estadoWiFi = WIFI_INACTIVO;
+String ssidWiFi = "";
+String passWiFi = "";
+String lineaBT = "";
+unsigned long ultimoCaracterBT = 0;
+unsigned long inicioConexionWiFi = 0;
+unsigned long ultimoPuntoWiFi = 0;
 
 // Access point
 const char* AP_SSID = "ESP32_AP";
@@ -38,9 +67,6 @@ BluetoothSerial SerialBT;
 BLECharacteristic *pCharacteristic;
 BLECharacteristic *pCharacteristic2;
 
-// portal cautivo
-WebServer server(80);
-DNSServer dnsServer;
 AS5600 as5600;
 
 // Portal cautivo
@@ -55,10 +81,18 @@ void leerAS5600();
 void conectarWiFi();
 void activarModoBLE();
 void iniciarPortalCautivo();
-void handleRoot();
-void handleNotFound();
 void flushBluetoothInput();
 void conectarHttp();
+bool leerLineaBT(String &destino);
+void mostrarEstadisticasTareas();
+void tareaRed(void *parametro);
+void tareaMuestras();
+void tareaMenu();
+void tareaPortal();
+void tareaBLE();
+void tareaHttp();
+void tareaHistorial();
+void cambiarModoBLE();
 
 
 // Setup
@@ -66,122 +100,166 @@ void setup() {
   Serial.begin(9600);
   SerialBT.begin("ESP32_Bluetooth");
   
-  pinMode(E18D80NK_PIN, INPUT);
   Wire.begin(AS5600_SDA, AS5600_SCL);
+  Wire.setClock(400000);  // Necesario para muestrear el AS5600 a 1 kHz
   delay(100);
   
   as5600.begin(4);
   as5600.setDirection(AS5600_CLOCK_WISE);
   delay(100);
+
+  // AS5600 y contador de cajas en su propio núcleo
+  iniciarAdquisicion(as5600, E18D80NK_PIN);
+
+  // Envío al servidor en segundo plano con conexión persistente
+  iniciarEnlaceHttp(serverUrl);
   
+  // Presupuestos en microsegundos; se informan los desbordes con la opción 6
+  planificador.agregarPeriodica("muestras", tareaMuestras, intervaloMuestras, 2000);
+  planificador.agregarPeriodica("menu", tareaMenu, 20, 5000);
+  planificador.agregarPeriodica("portal", tareaPortal, 5, 20000);
+  planificador.agregarPeriodica("ble", tareaBLE, intervaloBLE, 20000);
+  planificador.agregarPeriodica("http", tareaHttp, intervaloHttp, 5000);
+  iniciarHistorial();
+  planificador.agregarPeriodica("historial", tareaHistorial, intervaloHistorial, 1000);
+
   Serial.println("Sistema iniciado");
   SerialBT.println("¡Bienvenido! Conectado al ESP32 por Bluetooth");
   mostrarMenu();
+
+  // Red, BLE, portal y menú en el otro núcleo
+  TaskHandle_t tarea = NULL;
+  xTaskCreatePinnedToCore(tareaRed, "red", 8192, NULL, 1, &tarea, RED_NUCLEO);
+  registrarTareaMetricas("red", tarea);
 }
 
 // Loop
 void loop() {
-  if (!modeBleActivo) {
-    if (SerialBT.available()) {
-      char opcion = SerialBT.read();
-      
-      switch (opcion) {
-        case '1':
-          SerialBT.println(ultimoAnguloAS5600);
-          break;
-        case '2':
-          estadoActual = digitalRead(E18D80NK_PIN);
-          if (estadoActual == LOW) { 
-            SerialBT.println("OBSTACULO");
-          } else {
-            SerialBT.println("LIBRE");
-          }
-          SerialBT.print("Cajas totales: ");
-          SerialBT.println(conteoCajas);
-          break;
-        case '3':
-          conectarWiFi();
-          delay(1000);
-          delay(1000);
-          break;
-        case '4':
-          iniciarPortalCautivo();
-          break;
-        case '5':
-          SerialBT.println("Cambiando a modo BLE. Te desconectarás.");
-          delay(1000);
-          activarModoBLE();
-          modeBleActivo = true;
-          break;
-        default:
-          if (opcion != '\n' && opcion != '\r') {
-            SerialBT.println("Opción inválida. Elige 1 a 4.");
-          }
-          break;
-      }
-      
-      if (opcion != '\n' && opcion != '\r') {
-        delay(300);
-        mostrarMenu();
-      }
+  // Todo el trabajo lo hacen las tareas de adquisición y de red
+  vTaskDelete(NULL);
+}
+
+// Tareas
+void tareaRed(void *parametro) {
+  for (;;) {
+    uint32_t inicio = micros();
+    if (planificador.ejecutar()) {
+      registrarVueltaRed(micros() - inicio);
+    } else {
+      vTaskDelay(1);
     }
-  } else {
-      Serial.println("Modo BLE activado");
-
-      int cajasTotales = conteoCajas;
-      String valueString = String(cajasTotales);
-      
-      int angulo = 0;
-      if (as5600.isConnected()) {
-        angulo = as5600.readAngle();
+  }
+}
+
+void tareaMuestras() {
+  // Vaciar la cola de adquisición hacia el lote
+  Muestra m;
+  while (extraerMuestra(m)) {
+    loteTelemetria.agregar(m);
+  }
+}
+
+void tareaMenu() {
+  if (modeBleActivo) {
+    return;
+  }
+
+  // Configuración WiFi en curso: la entrada es el SSID o la contraseña
+  if (estadoWiFi != WIFI_INACTIVO) {
+    conectarWiFi();
+    return;
+  }
+
+  if (!SerialBT.available()) {
+    return;
+  }
+
+  char opcion = SerialBT.read();
+  
+  switch (opcion) {
+    case '1':
+      leerAS5600();
+      break;
+    case '2':
+      leerE18D80NK();
+      break;
+    case '3':
+      conectarWiFi();
+      break;
+    case '4':
+      iniciarPortalCautivo();
+      break;
+    case '5':
+      SerialBT.println("Cambiando a modo BLE. Te desconectarás.");
+      planificador.programarUnaVez("cambio_ble", cambiarModoBLE, 1000, 200000);
+      break;
+    case '6':
+      mostrarEstadisticasTareas();
+      break;
+    default:
+      if (opcion != '\n' && opcion != '\r') {
+        SerialBT.println("Opción inválida. Elige 1 a 6.");
       }
-      String valueString2 = String(angulo);
-
-      pCharacteristic->setValue(valueString.c_str());
-      pCharacteristic->notify();
-      pCharacteristic2->setValue(valueString2.c_str());
-      pCharacteristic2->notify();
-
-      Serial.println("Valores BLE actualizado");
-      Serial.print("Cajas totales: ");
-      Serial.println(cajasTotales);
-      Serial.print("Ángulo: ");
-      Serial.println(angulo);
-      delay(5000);
+      break;
   }
   
+  // El menú de WiFi se vuelve a mostrar al terminar la conexión
+  if (opcion != '\n' && opcion != '\r' && estadoWiFi == WIFI_INACTIVO) {
+    planificador.programarUnaVez("menu_mostrar", mostrarMenu, 300, 20000);
+  }
+}
 
+void tareaPortal() {
   if (WiFi.getMode() == WIFI_AP) {
-    dnsServer.processNextRequest();  // Procesar DNS para portal cautivo
-    server.handleClient();
+    atenderDnsPortal();  // Procesar DNS para portal cautivo
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    conectarHttp();
+void tareaBLE() {
+  if (!modeBleActivo) {
+    return;
   }
 
-   // Actualización periódica de sensores
-  if (millis() - ultimoTiempoLectura >= intervaloLectura) {
-    ultimoTiempoLectura = millis();
+  Serial.println("Modo BLE activado");
 
-    // Sensor E18
-    estadoActual = digitalRead(E18D80NK_PIN);
-    if (estadoAnterior == HIGH && estadoActual == LOW) {
-      conteoCajas++;
-    }
-    estadoAnterior = estadoActual;
+  InstantaneaSensores sensores = leerInstantaneaSensores();
+  int cajasTotales = sensores.conteo;
+  char valor[12];
+  EscritorBuffer valueString(valor, sizeof(valor));
+  valueString.agregarEntero(cajasTotales);
+  
+  int angulo = sensores.conectado ? sensores.angulo : 0;
+  char valor2[12];
+  EscritorBuffer valueString2(valor2, sizeof(valor2));
+  valueString2.agregarEntero(angulo);
+
+  pCharacteristic->setValue(valueString.c_str());
+  pCharacteristic->notify();
+  pCharacteristic2->setValue(valueString2.c_str());
+  pCharacteristic2->notify();
+
+  Serial.println("Valores BLE actualizado");
+  Serial.print("Cajas totales: ");
+  Serial.println(cajasTotales);
+  Serial.print("Ángulo: ");
+  Serial.println(angulo);
+}
 
-    // Sensor AS5600
-    if (as5600.isConnected()) {
-      ultimoAnguloAS5600 = as5600.readAngle();
-    }
+void tareaHttp() {
+  // Sin Wi-Fi también se cierra el lote: el enlace lo guarda en el diario
+  if (loteTelemetria.listoParaEnviar(millis())) {
+    conectarHttp();
   }
+}
 
-  // --- Portal cautivo activo ---
-  if (WiFi.getMode() == WIFI_AP) {
-    dnsServer.processNextRequest();
-    server.handleClient();
-  }
+void tareaHistorial() {
+  InstantaneaSensores sensores = leerInstantaneaSensores();
+  agregarHistorial(millis(), sensores.conteo, sensores.angulo, sensores.velocidadRpm);
+}
+
+void cambiarModoBLE() {
+  activarModoBLE();
+  modeBleActivo = true;
 }
 
 // Funciones
@@ -192,89 +270,261 @@ void mostrarMenu() {
   SerialBT.println("3. Conectar a WiFi");
   SerialBT.println("4. Iniciar portal cautivo");
   SerialBT.println("5. Cambiar a modo BLE");
-  SerialBT.println("Elige una opción (1-5):");
+  SerialBT.println("6. Estadísticas de tareas");
+  SerialBT.println("Elige una opción (1-6):");
 }
 
 void leerE18D80NK() {
   int estadoActual = digitalRead(E18D80NK_PIN);
+  InstantaneaCajas cajas = leerInstantaneaCajas();
   
-  if (estadoAnterior == HIGH && estadoActual == LOW) {
-    conteoCajas++;
-    SerialBT.print("Caja detectada. Total: ");
-    SerialBT.println(conteoCajas);
-  }
-  
-  estadoAnterior = estadoActual;
+  SerialBT.print("Cajas totales: ");
+  SerialBT.println(cajas.conteo);
+#ifndef CONTADOR_CAJAS_PCNT
+  // El PCNT no guarda el instante de cada caja
+  SerialBT.print("Última caja hace (ms): ");
+  SerialBT.println((micros() - cajas.ultimoEventoUs) / 1000);
+  SerialBT.print("Rebotes descartados: ");
+  SerialBT.println(cajas.rechazados);
+#endif
   SerialBT.print("Estado sensor: ");
   SerialBT.println(estadoActual == HIGH ? "LIBRE" : "OBSTACULO");
 }
 
 void leerAS5600() {
-  if (as5600.isConnected()) {
-    int angulo = as5600.readAngle();
-    int raw = as5600.rawAngle();
-    
+  // Instantánea de la tarea de adquisición: ninguna lectura I2C aquí
+  InstantaneaSensores sensores = leerInstantaneaSensores();
+  if (sensores.conectado) {
     SerialBT.print("Ángulo: ");
-    SerialBT.print(angulo);
+    SerialBT.print(sensores.angulo);
     SerialBT.print(" | Valor RAW: ");
-    SerialBT.println(raw);
+    SerialBT.println(sensores.anguloRaw);
+    SerialBT.print("Velocidad (RPM): ");
+    SerialBT.println(sensores.velocidadRpm, 1);
+    SerialBT.print("Imán: ");
+    const char *iman[] = {"no detectado", "correcto", "débil", "demasiado fuerte"};
+    SerialBT.println(iman[sensores.iman]);
   } else {
     SerialBT.println("Error: Sensor AS5600 no detectado");
   }
+  SerialBT.print("Antigüedad (us): ");
+  SerialBT.println(antiguedadInstantaneaUs(sensores));
 }
 
+// Avanza un paso de la configuración WiFi cada vez que se llama
 void conectarWiFi() {
-  String ssid = "";
-  String password = "";
+  switch (estadoWiFi) {
+    case WIFI_INACTIVO:
+      ssidWiFi = "";
+      passWiFi = "";
+      lineaBT = "";
+
+      // Limpiar buffer antes de empezar
+      flushBluetoothInput();
+
+      SerialBT.println("Ingresa SSID de la red WiFi:"); 
+      estadoWiFi = WIFI_ESPERA_SSID;
+      break;
+
+    case WIFI_ESPERA_SSID:
+      if (leerLineaBT(ssidWiFi)) {
+        SerialBT.print("SSID recibido: ");
+        SerialBT.println(ssidWiFi);
+        SerialBT.println("Ingresa la contraseña de la red:");
+        estadoWiFi = WIFI_ESPERA_PASS;
+      }
+      break;
 
-  // Limpiar buffer antes de empezar
-  flushBluetoothInput();
-  
-  SerialBT.println("Ingresa SSID de la red WiFi:"); 
-  while (ssid == "") {
-    if (SerialBT.available()) {
-      ssid = SerialBT.readString();
-      ssid.trim();
-    }
-    delay(100);
+    case WIFI_ESPERA_PASS:
+      if (!leerLineaBT(passWiFi)) {
+        break;
+      }
+      SerialBT.print("Contraseña recibida: ");
+      SerialBT.println(passWiFi);
+
+      // Validar que ambos campos no estén vacíos
+      if (ssidWiFi.length() == 0 || passWiFi.length() == 0) {
+        SerialBT.println("Error: SSID y contraseña no pueden estar vacíos.");
+        estadoWiFi = WIFI_INACTIVO;
+        planificador.programarUnaVez("menu_mostrar", mostrarMenu, 300, 20000);
+        break;
+      }
+
+      SerialBT.println("Conectando a WiFi...");
+      WiFi.begin(ssidWiFi.c_str(), passWiFi.c_str());
+      inicioConexionWiFi = millis();
+      ultimoPuntoWiFi = inicioConexionWiFi;
+      estadoWiFi = WIFI_CONECTANDO;
+      break;
+
+    case WIFI_CONECTANDO:
+      if (WiFi.status() == WL_CONNECTED) { 
+        SerialBT.println("\nConectado a WiFi con éxito!");
+        SerialBT.print("IP: ");
+        SerialBT.println(WiFi.localIP()); 
+        // El portal y /metrics también quedan accesibles en la red local
+        iniciarServidorPortal(E18D80NK_PIN);
+      } else if (millis() - inicioConexionWiFi >= 15000) {
+        SerialBT.println("\nNo se pudo conectar. Verifica SSID/contraseña."); 
+      } else {
+        if (millis() - ultimoPuntoWiFi >= 500) {
+          ultimoPuntoWiFi = millis();
+          SerialBT.print("."); 
+        }
+        break;
+      }
+      estadoWiFi = WIFI_INACTIVO;
+      planificador.programarUnaVez("menu_mostrar", mostrarMenu, 300, 20000);
+      break;
   }
-  SerialBT.print("SSID recibido: ");
-  SerialBT.println(ssid);
-  
-  SerialBT.println("Ingresa la contraseña de la red:");
-  while (password == "") {
-    if (SerialBT.available()) {
-      password = SerialBT.readString();
-      password.trim();
+}
+
+// Como readString() pero sin bloquear: la línea termina con un salto de
+// línea o tras un segundo sin recibir caracteres.
+bool leerLineaBT(String &destino) {
+  bool finLinea = false;
+  while (SerialBT.available()) {
+    char c = SerialBT.read();
+    ultimoCaracterBT = millis();
+    if (c == '\n' || c == '\r') {
+      finLinea = true;
+      break;
     }
-    delay(100);
+    lineaBT += c;
   }
-  SerialBT.print("Contraseña recibida: ");
-  SerialBT.println(password);
-  
-  // Validar que ambos campos no estén vacíos
-  if (ssid.length() == 0 || password.length() == 0) {
-    SerialBT.println("Error: SSID y contraseña no pueden estar vacíos.");
-    return;
+
+  if (!finLinea && (lineaBT.length() == 0 || millis() - ultimoCaracterBT < 1000)) {
+    return false;
   }
-  
-  SerialBT.println("Conectando a WiFi...");
-  
-  WiFi.begin(ssid, password);
-  unsigned long startAttemptTime = millis();
 
-  while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 15000) {
-    delay(500); 
-    SerialBT.print("."); 
-  } 
-  
-  if (WiFi.status() == WL_CONNECTED) { 
-    SerialBT.println("\nConectado a WiFi con éxito!");
-    SerialBT.print("IP: ");
-    SerialBT.println(WiFi.localIP()); 
-  } else {
-    SerialBT.println("\nNo se pudo conectar. Verifica SSID/contraseña."); 
-  } 
+  lineaBT.trim();
+  if (lineaBT.length() == 0) {
+    return false;
+  }
+  destino = lineaBT;
+  lineaBT = "";
+  return true;
+}
+
+void mostrarEstadisticasTareas() {
+  SerialBT.println("\n--- TAREAS ---");
+  SerialBT.println("nombre: ejecuciones / desbordes / max us / retraso max ms");
+  for (uint8_t i = 0; i < planificador.cantidadTareas(); i++) {
+    EstadisticasTarea stats = planificador.estadisticas(i);
+    SerialBT.print(planificador.nombreTarea(i));
+    SerialBT.print(": ");
+    SerialBT.print(stats.ejecuciones);
+    SerialBT.print(" / ");
+    SerialBT.print(stats.desbordes);
+    SerialBT.print(" / ");
+    SerialBT.print(stats.duracionMaxUs);
+    SerialBT.print(" / ");
+    SerialBT.println(stats.retrasoMaxMs);
+  }
+
+  EstadisticasJitter jitter = leerJitterAdquisicion();
+  SerialBT.println("--- ADQUISICION ---");
+  SerialBT.print("Muestras: ");
+  SerialBT.println(jitter.muestras);
+  SerialBT.print("Jitter medio / max (us): ");
+  SerialBT.print(jitter.jitterMedioUs);
+  SerialBT.print(" / ");
+  SerialBT.println(jitter.jitterMaxUs);
+  SerialBT.print("Descartadas / tardías / errores I2C: ");
+  SerialBT.print(jitter.descartadas);
+  SerialBT.print(" / ");
+  SerialBT.print(jitter.tardias);
+  SerialBT.print(" / ");
+  SerialBT.println(jitter.erroresI2C);
+  SerialBT.print("Tardías con el diario en flash: ");
+  SerialBT.println(jitter.tardiasFlash);
+
+  InstantaneaSensores sensores = leerInstantaneaSensores();
+  SerialBT.print("Vueltas: ");
+  SerialBT.print(sensores.revoluciones);
+  SerialBT.print(" | Posición: ");
+  SerialBT.println(sensores.posicion);
+  SerialBT.print("Instantánea n.º / antigüedad (us): ");
+  SerialBT.print(sensores.secuencia);
+  SerialBT.print(" / ");
+  SerialBT.println(antiguedadInstantaneaUs(sensores));
+#ifdef ADQUISICION_PWM
+  LecturaPwm pwm = leerCapturaPwm();
+  SerialBT.print("Tramas PWM válidas / descartadas: ");
+  SerialBT.print(pwm.tramas);
+  SerialBT.print(" / ");
+  SerialBT.println(pwm.descartadas);
+#endif
+#ifdef ADQUISICION_ADC
+  EstadisticasAdc adc = leerEstadisticasAdc();
+  SerialBT.print("Conversiones / muestras ADC: ");
+  SerialBT.print(adc.conversiones);
+  SerialBT.print(" / ");
+  SerialBT.println(adc.muestras);
+  SerialBT.print("Bloques con paso de vuelta / descartadas: ");
+  SerialBT.print(adc.bloquesVuelta);
+  SerialBT.print(" / ");
+  SerialBT.println(adc.descartadas);
+  SerialBT.print("Lectura cruda: ");
+  SerialBT.println(adc.ultimoCrudo);
+#endif
+
+  EstadisticasEnlace enlace = leerEstadisticasEnlace();
+  SerialBT.println("--- ENLACE HTTP ---");
+  SerialBT.print("Enviados / fallidos / rechazados / descartados: ");
+  SerialBT.print(enlace.enviados);
+  SerialBT.print(" / ");
+  SerialBT.print(enlace.fallidos);
+  SerialBT.print(" / ");
+  SerialBT.print(enlace.rechazados);
+  SerialBT.print(" / ");
+  SerialBT.println(enlace.descartados);
+  SerialBT.print("Conexiones nuevas / reutilizadas: ");
+  SerialBT.print(enlace.conexiones);
+  SerialBT.print(" / ");
+  SerialBT.println(enlace.reutilizadas);
+  SerialBT.print("Latencia p50 / p90 / p99 (ms): ");
+  SerialBT.print(enlace.latenciaP50Ms);
+  SerialBT.print(" / ");
+  SerialBT.print(enlace.latenciaP90Ms);
+  SerialBT.print(" / ");
+  SerialBT.println(enlace.latenciaP99Ms);
+  SerialBT.print("En cola: ");
+  SerialBT.println(enlace.enCola);
+  SerialBT.print("Formato: ");
+#ifdef TELEMETRIA_BINARIO
+  SerialBT.println(enlaceAceptaBinario() ? "binario" : "JSON (binario rechazado)");
+#else
+  SerialBT.println("JSON");
+#endif
+  SerialBT.print("Bytes por punto: ");
+  SerialBT.println(puntosEncolados > 0 ? (float)bytesEncolados / puntosEncolados : 0.0f, 2);
+
+  EstadisticasDiario diario = leerEstadisticasDiario();
+  SerialBT.print("Diario anotados / reenviados / perdidos: ");
+  SerialBT.print(diario.anotados);
+  SerialBT.print(" / ");
+  SerialBT.print(diario.reenviados);
+  SerialBT.print(" / ");
+  SerialBT.println(diario.perdidos);
+  SerialBT.print("Diario pendiente (bytes): ");
+  SerialBT.println(diario.bytesPendientes);
+  SerialBT.print("Clientes del portal: ");
+  SerialBT.println(clientesEventos());
+  uint32_t sondas = 0;
+  for (size_t i = 0; i < cantidadSondasPortal(); i++) {
+    sondas += aciertosSondaPortal(i);
+  }
+  SerialBT.print("Sondas de portal cautivo: ");
+  SerialBT.println(sondas);
+  EstadisticasDns dns = leerEstadisticasDns();
+  SerialBT.print("DNS consultas / por segundo / descartadas: ");
+  SerialBT.print(dns.consultas);
+  SerialBT.print(" / ");
+  SerialBT.print(dns.consultasPorSegundo);
+  SerialBT.print(" / ");
+  SerialBT.println(dns.descartadas);
+  reiniciarJitterAdquisicion();
 }
 
 void activarModoBLE() {
@@ -313,63 +563,6 @@ void activarModoBLE() {
   Serial.println("Dispositivo anunciándose por BLE.");
 }
 
-void handleRoot() {
-  String html = "<!DOCTYPE html><html><head>";
-  html += "<meta charset='UTF-8'>";
-  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
-  html += "<title>ESP32 - Sistema de Sensores</title>";
-  html += "<style>";
-  html += "body { font-family: Arial, sans-serif; margin: 0; padding: 20px; background: #f0f0f0; }";
-  html += ".container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 0 10px rgba(0,0,0,0.1); }";
-  html += "h1 { color: #333; text-align: center; }";
-  html += ".sensor-data { background: #e9ecef; padding: 15px; margin: 10px 0; border-radius: 5px; }";
-  html += ".refresh-btn { background: #007bff; color: white; padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; margin: 10px 0; }";
-  html += ".refresh-btn:hover { background: #0056b3; }";
-  html += "</style>";
-  html += "<script>";
-  html += "function autoRefresh() { setTimeout(function(){ location.reload(); }, 2000); }";
-  html += "</script>";
-  html += "</head><body onload='autoRefresh()'>";
-  html += "<div class='container'>";
-  html += "<h1>ESP32 - Sistema de Sensores</h1>";
-  
-  html += "<div class='sensor-data'>";
-  html += "<h3>Contador de Cajas</h3>";
-  html += "<p><strong>Total detectado: " + String(conteoCajas) + "</strong></p>";
-  html += "</div>";
-  
-  html += "<div class='sensor-data'>";
-  html += "<h3>Sensor AS5600 (Magnético)</h3>";
-  if (as5600.isConnected()) {
-    int angulo = as5600.readAngle();
-    float grados = angulo * 0.087890625;
-    html += "<p>Ángulo: <strong>" + String(angulo) + "</strong> (RAW)</p>";
-    html += "<p>Grados: <strong>" + String(grados, 1) + "°</strong></p>";
-    html += "<p>Estado: <span style='color: green;'>Conectado</span></p>";
-  } else {
-    html += "<p>Estado: <span style='color: red;'>No conectado</span></p>";
-  }
-  html += "</div>";
-  
-  html += "<div class='sensor-data'>";
-  html += "<h3>Sensor E18-D80NK (Proximidad)</h3>";
-  int estadoActual = digitalRead(E18D80NK_PIN);
-  html += "<p>Estado: <strong>" + String(estadoActual == HIGH ? "LIBRE" : "OBSTÁCULO DETECTADO") + "</strong></p>";
-  html += "<p>Color: <span style='color: " + String(estadoActual == HIGH ? "green" : "red") + ";'>●</span></p>";
-  html += "</div>";
-  
-  html += "<button class='refresh-btn' onclick='location.reload()'>Actualizar</button>";
-  html += "<p style='text-align: center; color: #666; font-size: 12px;'>Actualización automática cada 2 segundos</p>";
-  html += "</div></body></html>";
-  
-  server.send(200, "text/html", html);
-}
-
-void handleNotFound() {
-  // Rediriger todas las peticiones a la página principal
-  handleRoot();
-}
-
 void iniciarPortalCautivo() {
   SerialBT.println("Iniciando portal cautivo...");
   
@@ -384,17 +577,17 @@ void iniciarPortalCautivo() {
     SerialBT.println(WiFi.softAPIP());
     
     // Configurar servidor DNS para portal cautivo
-    dnsServer.start(DNS_PORT, "*", apIP);
-    
-    // Configurar rutas del servidor web
-    server.on("/", handleRoot);
-    server.on("/index.html", handleRoot);
-    server.on("/generate_204", handleRoot);  // Android
-    server.on("/fwlink", handleRoot);        // Microsoft
-    server.onNotFound(handleNotFound);       // Capturar todas las demás peticiones
+    if (!iniciarDnsPortal(apIP, DNS_PORT)) {
+      SerialBT.println("Error al iniciar el DNS del portal");
+    }
     
-    server.begin();
-    SerialBT.println("Servidor web iniciado");
+    // El servidor web atiende en su propia tarea; las sondas de cada
+    // sistema se redirigen al portal y cualquier otra ruta muestra la página
+    if (iniciarServidorPortal(E18D80NK_PIN)) {
+      SerialBT.println("Servidor web iniciado");
+    } else {
+      SerialBT.println("Error al iniciar el servidor web");
+    }
     SerialBT.println("Conéctate a la red WiFi 'ESP32_AP'");
     SerialBT.println("El portal se abrirá automáticamente");
     SerialBT.println("O visita: http://192.168.4.1");
@@ -407,55 +600,38 @@ void flushBluetoothInput() {
   while (SerialBT.available()) {
     SerialBT.read();
   }
-  delay(50);
 }
 
 void conectarHttp() {
-  // Solo intentar enviar datos si estamos conectados a Wi-Fi
-  if (WiFi.status() == WL_CONNECTED) {
-
-    // Crear un objeto HTTPClient
-    HTTPClient http;
-
-    // Especificar el endpoint del servidor
-    http.begin(serverUrl);
-
-    // Anadir una cabecera para indicar que enviaremos datos en formato JSON
-    http.addHeader("Content-Type", "application/json");
-
-    // Leer datos
-    int cajasTotales = conteoCajas;
-      String valueString = String(cajasTotales);
-      
-      int angulo = 0;
-      if (as5600.isConnected()) {
-        angulo = as5600.readAngle();
-      }
-      String valueString2 = String(angulo);
-
-    // 2. Crear el cuerpo (payload) de la peticion en formato JSON
-    String jsonPayload = "{\"angulo\":" + String(angulo) + ",\"conteo_cajas\":" + String(cajasTotales) + "}";
-
-    // 3. Enviar la peticion POST y obtener el codigo de respuesta
-    int httpResponseCode = http.POST(jsonPayload);
-
-    // 4. Verificar la respuesta del servidor
-    if (httpResponseCode > 0) {
-      String response = http.getString();
-      Serial.print("Codigo de respuesta HTTP: ");
-      Serial.println(httpResponseCode);
-      Serial.print("Respuesta del servidor: ");
-      Serial.println(response);
-    } else {
-      Serial.print("Error en la peticion HTTP. Codigo: ");
-      Serial.println(httpResponseCode);
+  // Un solo buffer estático para el payload, sin usar el heap
+  static char payload[ENLACE_TAM_PAYLOAD];
+  size_t puntos = loteTelemetria.cantidad();
+  size_t longitud = 0;
+
+#ifdef TELEMETRIA_BINARIO
+  if (enlaceAceptaBinario()) {
+    longitud = loteTelemetria.codificarBinario((uint8_t *)payload, sizeof(payload), millis());
+  } else
+#endif
+  {
+    // Crear el cuerpo (payload) con todos los puntos del lote en formato JSON
+    EscritorBuffer json(payload, sizeof(payload));
+    if (loteTelemetria.serializar(json, millis())) {
+      longitud = json.longitud();
     }
+  }
 
-    // Liberar los recursos
-    http.end();
-  } else {
-    Serial.println("Error en la conexion WI-FI");
+  // Un lote que no cabe nunca cabrá: se descarta para no bloquear los siguientes
+  if (longitud == 0) {
+    Serial.println("Lote demasiado grande, descartado");
+    loteTelemetria.vaciar();
+    return;
   }
 
-  delay(10000);
-}
\ No newline at end of file
+  // Lo envía la tarea del enlace; si la cola está llena se reintenta luego
+  if (encolarPayload(payload, longitud)) {
+    puntosEncolados += puntos;
+    bytesEncolados += longitud;
+    loteTelemetria.vaciar();
+  }
+}
@@ -0,0 +1,143 @@
+#include "metricas.h"
+
+#include <atomic>
+#include <WiFi.h>
+#include "adquisicion.h"
+#include "enlace_http.h"
+#include "dns_portal.h"
+#include "histograma.h"
+#include "servidor_portal.h"
+
+struct TareaMetricas {
+  const char *nombre;
+  TaskHandle_t tarea;
+};
+
+static TareaMetricas tareas[METRICAS_MAX_TAREAS];
+static std::atomic<uint8_t> cantidadTareas(0);
+
+static const uint32_t LIMITES_VUELTA_US[] = {50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000};
+static Histograma vueltasRed(LIMITES_VUELTA_US, sizeof(LIMITES_VUELTA_US) / sizeof(LIMITES_VUELTA_US[0]));
+
+void registrarTareaMetricas(const char *nombre, TaskHandle_t tarea) {
+  if (!tarea) {
+    return;
+  }
+  uint8_t i = cantidadTareas.load(std::memory_order_relaxed);
+  if (i >= METRICAS_MAX_TAREAS) {
+    return;
+  }
+  tareas[i].nombre = nombre;
+  tareas[i].tarea = tarea;
+  cantidadTareas.store(i + 1, std::memory_order_release);
+}
+
+void registrarVueltaRed(uint32_t duracionUs) {
+  vueltasRed.registrar(duracionUs);
+}
+
+static void tipo(EscritorBuffer &texto, const char *nombre, const char *clase) {
+  texto.agregar("# TYPE ").agregar(nombre).agregar(' ').agregar(clase).agregar('\n');
+}
+
+static void valor(EscritorBuffer &texto, const char *nombre, uint32_t v) {
+  texto.agregar(nombre).agregar(' ').agregarSinSigno(v).agregar('\n');
+}
+
+static void valorEtiqueta(EscritorBuffer &texto, const char *nombre, const char *etiqueta,
+                          const char *valorEtiqueta, uint32_t v) {
+  texto.agregar(nombre).agregar('{').agregar(etiqueta).agregar("=\"").agregar(valorEtiqueta);
+  texto.agregar("\"} ").agregarSinSigno(v).agregar('\n');
+}
+
+// cantidad / porSegundo en segundos con decimales exactos, sin coma flotante
+static void segundos(EscritorBuffer &texto, uint64_t cantidad, uint32_t porSegundo) {
+  texto.agregarSinSigno(cantidad / porSegundo).agregar('.');
+  uint32_t resto = cantidad % porSegundo;
+  for (uint32_t d = porSegundo / 10; d > 0; d /= 10) {
+    texto.agregar((char)('0' + (resto / d) % 10));
+  }
+}
+
+static void histograma(EscritorBuffer &texto, const char *nombre, const Histograma &h, uint32_t porSegundo) {
+  tipo(texto, nombre, "histogram");
+  uint32_t acumulado = 0;
+  for (size_t i = 0; i <= h.cubetas(); i++) {
+    acumulado += h.cuenta(i);
+    texto.agregar(nombre).agregar("_bucket{le=\"");
+    if (i < h.cubetas()) {
+      segundos(texto, h.limite(i), porSegundo);
+    } else {
+      texto.agregar("+Inf");
+    }
+    texto.agregar("\"} ").agregarSinSigno(acumulado).agregar('\n');
+  }
+  texto.agregar(nombre).agregar("_sum ");
+  segundos(texto, h.suma(), porSegundo);
+  texto.agregar('\n');
+  texto.agregar(nombre).agregar("_count ").agregarSinSigno(acumulado).agregar('\n');
+}
+
+bool escribirMetricas(EscritorBuffer &texto) {
+  tipo(texto, "esp32_tiempo_activo_segundos", "gauge");
+  valor(texto, "esp32_tiempo_activo_segundos", millis() / 1000);
+
+  histograma(texto, "esp32_vuelta_red_segundos", vueltasRed, 1000000);
+
+  ContadoresI2C i2c = leerContadoresI2C();
+  tipo(texto, "esp32_i2c_transacciones_total", "counter");
+  valor(texto, "esp32_i2c_transacciones_total", i2c.transacciones);
+  tipo(texto, "esp32_i2c_errores_total", "counter");
+  valor(texto, "esp32_i2c_errores_total", i2c.errores);
+
+  EstadisticasJitter jitter = leerJitterAdquisicion();
+  tipo(texto, "esp32_muestras_descartadas_total", "counter");
+  valor(texto, "esp32_muestras_descartadas_total", jitter.descartadas);
+
+  histograma(texto, "esp32_enlace_latencia_segundos", leerLatenciasEnlace(), 1000);
+  EstadisticasEnlace enlace = leerEstadisticasEnlace();
+  tipo(texto, "esp32_enlace_envios_total", "counter");
+  valorEtiqueta(texto, "esp32_enlace_envios_total", "resultado", "enviado", enlace.enviados);
+  valorEtiqueta(texto, "esp32_enlace_envios_total", "resultado", "fallido", enlace.fallidos);
+  valorEtiqueta(texto, "esp32_enlace_envios_total", "resultado", "rechazado", enlace.rechazados);
+  valorEtiqueta(texto, "esp32_enlace_envios_total", "resultado", "descartado", enlace.descartados);
+
+  EstadisticasDiario diario = leerEstadisticasDiario();
+  tipo(texto, "esp32_cola_ocupacion", "gauge");
+  valorEtiqueta(texto, "esp32_cola_ocupacion", "cola", "muestras", muestrasPendientes());
+  valorEtiqueta(texto, "esp32_cola_ocupacion", "cola", "enlace", enlace.enCola);
+  tipo(texto, "esp32_diario_pendiente_bytes", "gauge");
+  valor(texto, "esp32_diario_pendiente_bytes", diario.bytesPendientes);
+
+  tipo(texto, "esp32_heap_libre_bytes", "gauge");
+  valor(texto, "esp32_heap_libre_bytes", ESP.getFreeHeap());
+  tipo(texto, "esp32_heap_libre_min_bytes", "gauge");
+  valor(texto, "esp32_heap_libre_min_bytes", ESP.getMinFreeHeap());
+  tipo(texto, "esp32_heap_bloque_max_bytes", "gauge");
+  valor(texto, "esp32_heap_bloque_max_bytes", ESP.getMaxAllocHeap());
+
+  // En el ESP32 la marca de agua de la pila ya viene en bytes
+  tipo(texto, "esp32_pila_libre_min_bytes", "gauge");
+  uint8_t n = cantidadTareas.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++) {
+    valorEtiqueta(texto, "esp32_pila_libre_min_bytes", "tarea", tareas[i].nombre,
+                  uxTaskGetStackHighWaterMark(tareas[i].tarea));
+  }
+
+  tipo(texto, "esp32_portal_sondas_total", "counter");
+  for (size_t i = 0; i < cantidadSondasPortal(); i++) {
+    valorEtiqueta(texto, "esp32_portal_sondas_total", "ruta", rutaSondaPortal(i), aciertosSondaPortal(i));
+  }
+
+  EstadisticasDns dns = leerEstadisticasDns();
+  tipo(texto, "esp32_dns_consultas_total", "counter");
+  valorEtiqueta(texto, "esp32_dns_consultas_total", "resultado", "a", dns.respuestasA);
+  valorEtiqueta(texto, "esp32_dns_consultas_total", "resultado", "vacia", dns.respuestasVacias);
+  valorEtiqueta(texto, "esp32_dns_consultas_total", "resultado", "descartada", dns.descartadas);
+
+  if (WiFi.status() == WL_CONNECTED) {
+    tipo(texto, "esp32_wifi_rssi_dbm", "gauge");
+    texto.agregar("esp32_wifi_rssi_dbm ").agregarEntero(WiFi.RSSI()).agregar('\n');
+  }
+  return !texto.desbordado();
+}
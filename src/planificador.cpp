@@ -0,0 +1,116 @@
+#include "planificador.h"
+
+Planificador::Planificador(FuenteReloj relojMs, FuenteReloj relojUs)
+  : _relojMs(relojMs), _relojUs(relojUs) {
+}
+
+int Planificador::reservar(const char *nombre, FuncionTarea funcion, uint32_t periodoMs,
+                           uint32_t retardoMs, uint32_t presupuestoUs) {
+  // Reutilizar huecos de tareas de una sola vez ya terminadas o canceladas,
+  // salvo el de la que se está ejecutando
+  uint8_t i = 0;
+  while (i < _cantidad && (_tareas[i].activa || i == _enCurso)) {
+    i++;
+  }
+  if (i == PLANIFICADOR_MAX_TAREAS) {
+    return -1;
+  }
+  if (i == _cantidad) {
+    _cantidad++;
+  }
+
+  Tarea &t = _tareas[i];
+  t.nombre = nombre;
+  t.funcion = funcion;
+  t.periodoMs = periodoMs;
+  t.presupuestoUs = presupuestoUs;
+  t.plazoMs = _relojMs() + retardoMs;
+  t.activa = true;
+  t.stats = EstadisticasTarea();
+  return i;
+}
+
+int Planificador::agregarPeriodica(const char *nombre, FuncionTarea funcion,
+                                   uint32_t periodoMs, uint32_t presupuestoUs) {
+  return reservar(nombre, funcion, periodoMs, 0, presupuestoUs);
+}
+
+int Planificador::programarUnaVez(const char *nombre, FuncionTarea funcion,
+                                  uint32_t retardoMs, uint32_t presupuestoUs) {
+  return reservar(nombre, funcion, 0, retardoMs, presupuestoUs);
+}
+
+void Planificador::cancelar(int id) {
+  if (id >= 0 && id < _cantidad) {
+    _tareas[id].activa = false;
+  }
+}
+
+bool Planificador::ejecutar() {
+  uint32_t ahora = _relojMs();
+
+  // Plazo vencido más antiguo (comparación con signo por el desborde de millis)
+  int elegida = -1;
+  int32_t mayorRetraso = -1;
+  for (uint8_t i = 0; i < _cantidad; i++) {
+    const Tarea &t = _tareas[i];
+    int32_t retraso = (int32_t)(ahora - t.plazoMs);
+    if (t.activa && retraso >= 0 && retraso > mayorRetraso) {
+      mayorRetraso = retraso;
+      elegida = i;
+    }
+  }
+  if (elegida < 0) {
+    return false;
+  }
+
+  Tarea &t = _tareas[elegida];
+  if ((uint32_t)mayorRetraso > t.stats.retrasoMaxMs) {
+    t.stats.retrasoMaxMs = mayorRetraso;
+  }
+
+  // Avanzar el plazo antes de ejecutar: la tarea puede cancelarse a sí misma
+  if (t.periodoMs == 0) {
+    t.activa = false;
+  } else {
+    t.plazoMs += t.periodoMs;
+    // Si se quedó más de un periodo atrás, no intentar recuperar ejecuciones
+    if ((int32_t)(ahora - t.plazoMs) >= 0) {
+      t.plazoMs = ahora + t.periodoMs;
+    }
+  }
+
+  // La tarea puede programar otras: "t" sigue siendo suya hasta el final
+  _enCurso = elegida;
+  uint32_t inicio = _relojUs();
+  t.funcion();
+  uint32_t duracion = _relojUs() - inicio;
+  _enCurso = -1;
+
+  t.stats.ejecuciones++;
+  if (duracion > t.stats.duracionMaxUs) {
+    t.stats.duracionMaxUs = duracion;
+  }
+  if (duracion > t.presupuestoUs) {
+    t.stats.desbordes++;
+  }
+  return true;
+}
+
+uint8_t Planificador::cantidadTareas() const {
+  return _cantidad;
+}
+
+const char *Planificador::nombreTarea(uint8_t indice) const {
+  return indice < _cantidad ? _tareas[indice].nombre : "";
+}
+
+EstadisticasTarea Planificador::estadisticas(uint8_t indice) const {
+  return indice < _cantidad ? _tareas[indice].stats : EstadisticasTarea();
+}
+
+void Planificador::reiniciarEstadisticas() {
+  for (uint8_t i = 0; i < _cantidad; i++) {
+    _tareas[i].stats = EstadisticasTarea();
+  }
+}
@@ -0,0 +1,266 @@
+#include "servidor_portal.h"
+
+#include <atomic>
+#include <esp_http_server.h>
+#include "adquisicion.h"
+#include "eventos_portal.h"
+#include "historial.h"
+#include "metricas.h"
+#include "recursos_portal.h"
+
+static httpd_handle_t servidor = NULL;
+static TimerHandle_t temporizadorEventos = NULL;
+static uint8_t pinE18 = 0;
+static const RecursoPortal *paginaPrincipal = nullptr;
+
+// Respuesta fija para cada sonda. Con una redirección el sistema detecta
+// el portal y lo abre; la respuesta "esperada" le diría que hay Internet.
+struct SondaPortal {
+  const char *ruta;
+  const char *estado;
+  const char *ubicacion;   // nullptr: sin redirección
+};
+
+static const SondaPortal SONDAS[] = {
+  {"/generate_204", "302 Found", PORTAL_URL},                 // Android
+  {"/gen_204", "302 Found", PORTAL_URL},                      // Android
+  {"/hotspot-detect.html", "302 Found", PORTAL_URL},          // iOS / macOS
+  {"/library/test/success.html", "302 Found", PORTAL_URL},    // iOS antiguo
+  {"/connecttest.txt", "302 Found", PORTAL_URL},              // Windows 10+
+  {"/ncsi.txt", "302 Found", PORTAL_URL},                     // Windows 7/8
+  {"/redirect", "302 Found", PORTAL_URL},                     // Windows
+  {"/fwlink", "302 Found", PORTAL_URL},                       // Microsoft
+  {"/canonical.html", "302 Found", PORTAL_URL},               // Firefox
+  {"/success.txt", "302 Found", PORTAL_URL},                  // Firefox
+  {"/kindle-wifi/wifistub.html", "302 Found", PORTAL_URL},    // Kindle
+  {"/favicon.ico", "204 No Content", nullptr},                // Navegadores
+};
+static const size_t CANTIDAD_SONDAS = sizeof(SONDAS) / sizeof(SONDAS[0]);
+static std::atomic<uint32_t> aciertosSondas[CANTIDAD_SONDAS];
+
+static EstadoPortal leerEstadoPortal() {
+  InstantaneaSensores sensores = leerInstantaneaSensores();
+  EstadoPortal estado;
+  estado.cajas = sensores.conteo;
+  estado.angulo = sensores.angulo;
+  estado.conectado = sensores.conectado;
+  estado.libre = digitalRead(pinE18) == HIGH;
+  return estado;
+}
+
+static esp_err_t enviarRecurso(httpd_req_t *req, const RecursoPortal &recurso) {
+  httpd_resp_set_hdr(req, "Cache-Control", recurso.inmutable ? "public, max-age=31536000, immutable" : "no-cache");
+  httpd_resp_set_hdr(req, "ETag", recurso.etag);
+
+  char etag[16];
+  if (httpd_req_get_hdr_value_str(req, "If-None-Match", etag, sizeof(etag)) == ESP_OK &&
+      strcmp(etag, recurso.etag) == 0) {
+    httpd_resp_set_status(req, "304 Not Modified");
+    return httpd_resp_send(req, NULL, 0);
+  }
+  httpd_resp_set_type(req, recurso.tipo);
+  httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+  return httpd_resp_send(req, (const char *)recurso.datos, recurso.longitud);
+}
+
+static esp_err_t manejarRecurso(httpd_req_t *req) {
+  return enviarRecurso(req, *(const RecursoPortal *)req->user_ctx);
+}
+
+// Cualquier otra ruta lleva a la página
+static esp_err_t manejarPortal(httpd_req_t *req) {
+  if (!paginaPrincipal) {
+    return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Portal no compilado");
+  }
+  return enviarRecurso(req, *paginaPrincipal);
+}
+
+static esp_err_t manejarSonda(httpd_req_t *req) {
+  size_t indice = (size_t)req->user_ctx;
+  const SondaPortal &sonda = SONDAS[indice];
+  aciertosSondas[indice].fetch_add(1, std::memory_order_relaxed);
+
+  httpd_resp_set_status(req, sonda.estado);
+  if (sonda.ubicacion) {
+    httpd_resp_set_hdr(req, "Location", sonda.ubicacion);
+  }
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, NULL, 0);
+}
+
+static esp_err_t manejarDatos(httpd_req_t *req) {
+  char datos[96];
+  EscritorBuffer json(datos, sizeof(datos));
+  serializarEstadoPortal(json, leerEstadoPortal());
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  return httpd_resp_send(req, json.c_str(), json.longitud());
+}
+
+static bool enviarFragmento(void *req, const char *datos, size_t longitud) {
+  return httpd_resp_send_chunk((httpd_req_t *)req, datos, longitud) == ESP_OK;
+}
+
+static esp_err_t manejarMetricas(httpd_req_t *req) {
+  // Respuesta por fragmentos (chunked): el primer byte sale en cuanto se
+  // llena el buffer y la memoria no crece con el número de métricas
+  char fragmento[PORTAL_TAM_FRAGMENTO];
+  EscritorBuffer metricas(fragmento, sizeof(fragmento), enviarFragmento, req);
+  httpd_resp_set_type(req, "text/plain; version=0.0.4");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  escribirMetricas(metricas);
+  if (!metricas.vaciar()) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// /history?nivel=0|1|2 (1 s, 1 min, 15 min)
+static esp_err_t manejarHistorial(httpd_req_t *req) {
+  char consulta[32];
+  char valor[4];
+  uint8_t nivel = 0;
+  if (httpd_req_get_url_query_str(req, consulta, sizeof(consulta)) == ESP_OK &&
+      httpd_query_key_value(consulta, "nivel", valor, sizeof(valor)) == ESP_OK) {
+    nivel = atoi(valor);
+  }
+  if (periodoHistorialS(nivel) == 0) {
+    httpd_resp_set_status(req, "400 Bad Request");
+    return httpd_resp_send(req, "Nivel no valido", HTTPD_RESP_USE_STRLEN);
+  }
+
+  char fragmento[PORTAL_TAM_FRAGMENTO];
+  EscritorBuffer json(fragmento, sizeof(fragmento), enviarFragmento, req);
+  httpd_resp_set_type(req, "application/json");
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  escribirHistorial(json, nivel, millis());
+  if (!json.vaciar()) {
+    return ESP_FAIL;
+  }
+  return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t manejarEventos(httpd_req_t *req) {
+  return aceptarClienteEventos(req, leerEstadoPortal());
+}
+
+static void publicarEnServidor(void *) {
+  publicarEventos(servidor, leerEstadoPortal(), millis());
+}
+
+// Los sockets solo se tocan desde la tarea del servidor: el temporizador
+// encola la publicación en lugar de hacerla
+static void alVencerEventos(TimerHandle_t) {
+  if (clientesEventos() > 0) {
+    httpd_queue_work(servidor, publicarEnServidor, NULL);
+  }
+}
+
+// Sesiones abiertas, de la más antigua a la más nueva. Solo las usa la
+// tarea del servidor (open_fn y close_fn).
+struct SesionPortal {
+  int fd;
+  bool cerrando;
+};
+static SesionPortal sesiones[PORTAL_MAX_CONEXIONES];
+static uint8_t cantidadSesiones = 0;
+
+// Si hay más de PORTAL_CONEXIONES_HTTP peticiones normales abiertas se cierra
+// la más antigua; los suscriptores de /eventos no cuentan ni se cierran
+static esp_err_t alAbrirSocket(httpd_handle_t hd, int fd) {
+  if (cantidadSesiones < PORTAL_MAX_CONEXIONES) {
+    sesiones[cantidadSesiones++] = {fd, false};
+  }
+  uint8_t normales = 0;
+  SesionPortal *masAntigua = nullptr;
+  for (uint8_t i = 0; i < cantidadSesiones; i++) {
+    if (sesiones[i].cerrando || esClienteEventos(sesiones[i].fd)) {
+      continue;
+    }
+    if (!masAntigua) {
+      masAntigua = &sesiones[i];
+    }
+    normales++;
+  }
+  if (normales > PORTAL_CONEXIONES_HTTP && masAntigua->fd != fd) {
+    masAntigua->cerrando = true;
+    httpd_sess_trigger_close(hd, masAntigua->fd);
+  }
+  return ESP_OK;
+}
+
+static void alCerrarSocket(httpd_handle_t, int fd) {
+  for (uint8_t i = 0; i < cantidadSesiones; i++) {
+    if (sesiones[i].fd == fd) {
+      memmove(&sesiones[i], &sesiones[i + 1], (cantidadSesiones - i - 1) * sizeof(sesiones[0]));
+      cantidadSesiones--;
+      break;
+    }
+  }
+  close(fd);
+}
+
+static void registrar(const char *ruta, esp_err_t (*manejador)(httpd_req_t *), void *contexto = NULL) {
+  httpd_uri_t uri = {};
+  uri.uri = ruta;
+  uri.method = HTTP_GET;
+  uri.handler = manejador;
+  uri.user_ctx = contexto;
+  httpd_register_uri_handler(servidor, &uri);
+}
+
+bool iniciarServidorPortal(uint8_t pinProximidad) {
+  if (servidor) {
+    return true;
+  }
+  pinE18 = pinProximidad;
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.core_id = PORTAL_NUCLEO;
+  config.task_priority = PORTAL_PRIORIDAD;
+  config.max_open_sockets = PORTAL_MAX_CONEXIONES;
+  config.max_uri_handlers = CANTIDAD_RECURSOS_PORTAL + CANTIDAD_SONDAS + 5;
+  config.lru_purge_enable = false;  // Se purga en alAbrirSocket, sin tocar /eventos
+  config.open_fn = alAbrirSocket;
+  config.close_fn = alCerrarSocket;
+  config.uri_match_fn = httpd_uri_match_wildcard;
+
+  if (httpd_start(&servidor, &config) != ESP_OK) {
+    servidor = NULL;
+    return false;
+  }
+  registrarTareaMetricas("httpd", xTaskGetHandle("httpd"));
+
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    const RecursoPortal &recurso = RECURSOS_PORTAL[i];
+    registrar(recurso.ruta, manejarRecurso, (void *)&recurso);
+    if (strcmp(recurso.ruta, "/") == 0) {
+      paginaPrincipal = &recurso;
+    }
+  }
+  for (size_t i = 0; i < CANTIDAD_SONDAS; i++) {
+    registrar(SONDAS[i].ruta, manejarSonda, (void *)i);
+  }
+  registrar("/eventos", manejarEventos);
+  registrar("/datos", manejarDatos);
+  registrar("/metrics", manejarMetricas);
+  registrar("/history", manejarHistorial);
+  // El comodín va el último: las rutas se prueban en orden de registro
+  registrar("/*", manejarPortal);
+
+  temporizadorEventos = xTimerCreate("eventos", pdMS_TO_TICKS(EVENTOS_PERIODO_MS), pdTRUE, NULL, alVencerEventos);
+  xTimerStart(temporizadorEventos, 0);
+  return true;
+}
+
+size_t cantidadSondasPortal() {
+  return CANTIDAD_SONDAS;
+}
+
+const char *rutaSondaPortal(size_t indice) {
+  return indice < CANTIDAD_SONDAS ? SONDAS[indice].ruta : "";
+}
+
+uint32_t aciertosSondaPortal(size_t indice) {
+  return indice < CANTIDAD_SONDAS ? aciertosSondas[indice].load(std::memory_order_relaxed) : 0;
+}
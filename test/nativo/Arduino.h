@@ -0,0 +1,44 @@
+#pragma once
+
+// Sustituto mínimo de Arduino.h para las pruebas en el PC (pio test -e native).
+// Solo declara lo que usan los módulos que se compilan allí; el reloj es
+// virtual y lo avanza cada prueba.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#define IRAM_ATTR
+#define PROGMEM
+typedef const char *PGM_P;
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define CHANGE 3
+#define PI 3.1415926535897932384626433832795
+
+#define constrain(v, bajo, alto) ((v) < (bajo) ? (bajo) : ((v) > (alto) ? (alto) : (v)))
+
+inline uint32_t relojPruebaUs = 0;
+inline int nivelPinPrueba = HIGH;
+
+inline uint32_t micros() { return relojPruebaUs; }
+inline uint32_t millis() { return relojPruebaUs / 1000; }
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return nivelPinPrueba; }
+inline int digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+
+// FreeRTOS: en las pruebas hay una sola tarea y el candado no hace nada
+typedef void *SemaphoreHandle_t;
+#define portMAX_DELAY 0xFFFFFFFF
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { static int candado; return &candado; }
+inline int xSemaphoreTake(SemaphoreHandle_t, uint32_t) { return 1; }
+inline int xSemaphoreGive(SemaphoreHandle_t) { return 1; }
@@ -0,0 +1,164 @@
+#pragma once
+
+// Sustituto de fs::FS para las pruebas en el PC: archivos reales bajo una
+// carpeta temporal, con la misma interfaz que usa el diario sobre LittleFS.
+
+#include <dirent.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <memory>
+#include <string>
+
+namespace fs {
+
+class File {
+public:
+  File() {}
+
+  explicit operator bool() const { return _impl && (_impl->archivo || _impl->carpeta); }
+
+  size_t read(uint8_t *destino, size_t longitud) {
+    return _impl && _impl->archivo ? fread(destino, 1, longitud, _impl->archivo) : 0;
+  }
+
+  size_t write(const uint8_t *datos, size_t longitud) {
+    if (!_impl || !_impl->archivo) {
+      return 0;
+    }
+    // Simula una flash llena: solo caben "cupoEscritura" bytes más
+    if (_impl->cupo && longitud > *_impl->cupo) {
+      longitud = *_impl->cupo;
+    }
+    size_t escritos = fwrite(datos, 1, longitud, _impl->archivo);
+    if (_impl->cupo) {
+      *_impl->cupo -= escritos;
+    }
+    return escritos;
+  }
+
+  bool seek(uint32_t posicion) {
+    return _impl && _impl->archivo && fseek(_impl->archivo, posicion, SEEK_SET) == 0;
+  }
+
+  size_t size() const {
+    struct stat st;
+    return _impl && stat(_impl->ruta.c_str(), &st) == 0 ? st.st_size : 0;
+  }
+
+  const char *name() const {
+    return _impl ? _impl->nombre.c_str() : "";
+  }
+
+  File openNextFile() {
+    File f;
+    if (!_impl || !_impl->carpeta) {
+      return f;
+    }
+    for (dirent *e = readdir(_impl->carpeta); e; e = readdir(_impl->carpeta)) {
+      if (e->d_name[0] == '.') {
+        continue;
+      }
+      f.abrir(_impl->ruta + "/" + e->d_name, "r", _impl->cupo);
+      return f;
+    }
+    return f;
+  }
+
+  void close() { _impl.reset(); }
+
+  void abrir(const std::string &ruta, const char *modo, size_t *cupo) {
+    auto impl = std::make_shared<Impl>();
+    impl->ruta = ruta;
+    impl->nombre = ruta.substr(ruta.rfind('/') + 1);
+    impl->cupo = cupo;
+    struct stat st;
+    if (stat(ruta.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      impl->carpeta = opendir(ruta.c_str());
+    } else {
+      impl->archivo = fopen(ruta.c_str(), modo[0] == 'r' ? "rb" : modo[0] == 'a' ? "ab" : "wb");
+    }
+    _impl = impl;
+  }
+
+private:
+  struct Impl {
+    std::string ruta;
+    std::string nombre;
+    FILE *archivo = nullptr;
+    DIR *carpeta = nullptr;
+    size_t *cupo = nullptr;
+    ~Impl() {
+      if (archivo) fclose(archivo);
+      if (carpeta) closedir(carpeta);
+    }
+  };
+  std::shared_ptr<Impl> _impl;
+};
+
+class FS {
+public:
+  // Cada FS es una carpeta temporal nueva, que se borra al destruirlo
+  FS() {
+    char plantilla[] = "/tmp/flash_XXXXXX";
+    _raiz = mkdtemp(plantilla);
+  }
+
+  ~FS() { borrar(_raiz); }
+
+  const std::string &raiz() const { return _raiz; }
+
+  File open(const char *ruta, const char *modo = "r") {
+    File f;
+    f.abrir(_raiz + ruta, modo, _hayCupo ? &_cupo : nullptr);
+    return f;
+  }
+
+  bool exists(const char *ruta) {
+    struct stat st;
+    return stat((_raiz + ruta).c_str(), &st) == 0;
+  }
+
+  bool mkdir(const char *ruta) { return ::mkdir((_raiz + ruta).c_str(), 0755) == 0; }
+  bool remove(const char *ruta) { return ::remove((_raiz + ruta).c_str()) == 0; }
+  bool rename(const char *desde, const char *hasta) {
+    return ::rename((_raiz + desde).c_str(), (_raiz + hasta).c_str()) == 0;
+  }
+
+  // Para simular la flash llena; sin llamarla no hay límite
+  void limitarEscritura(size_t bytes) {
+    _hayCupo = true;
+    _cupo = bytes;
+  }
+
+private:
+  static void borrar(const std::string &ruta) {
+    DIR *d = opendir(ruta.c_str());
+    if (!d) {
+      return;
+    }
+    for (dirent *e = readdir(d); e; e = readdir(d)) {
+      if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) {
+        continue;
+      }
+      std::string hijo = ruta + "/" + e->d_name;
+      struct stat st;
+      if (stat(hijo.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        borrar(hijo);
+      } else {
+        unlink(hijo.c_str());
+      }
+    }
+    closedir(d);
+    rmdir(ruta.c_str());
+  }
+
+  std::string _raiz;
+  bool _hayCupo = false;
+  size_t _cupo = 0;
+};
+
+}  // namespace fs
+
+using fs::File;
@@ -0,0 +1,15 @@
+#pragma once
+
+// Sustituto de IPAddress para las pruebas en el PC: solo los cuatro bytes
+
+#include <Arduino.h>
+
+class IPAddress {
+public:
+  IPAddress() : _bytes{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+  uint8_t operator[](int i) const { return _bytes[i]; }
+
+private:
+  uint8_t _bytes[4];
+};
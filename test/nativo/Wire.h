@@ -0,0 +1,5 @@
+#pragma once
+
+// Solo lo que necesita AS5600.h para declarar la clase; en el PC no se usa el bus
+class TwoWire {};
+extern TwoWire Wire;
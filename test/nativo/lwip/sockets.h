@@ -0,0 +1,9 @@
+#pragma once
+
+// En el PC los sockets de lwIP son los de POSIX, con la misma API BSD
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
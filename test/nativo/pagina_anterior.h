@@ -0,0 +1,206 @@
+#pragma once
+
+// La página del portal tal como la generaba handleRoot() antes del escritor
+// y de los recursos comprimidos, para comparar contra ella en las pruebas.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <utility>
+
+// Copia fiel del String de arduino-esp32 2.x en lo que importa aquí: hasta 10
+// caracteres dentro del objeto, fuera de eso un buffer redondeado a 16 bytes
+// que crece con realloc (aquí reservar, copiar y liberar, el peor caso) en
+// cada += que no cabe. Las sumas crean un temporal como StringSumHelper.
+// Asignar o reemplazar nunca encoge el buffer, igual que en el original.
+class CadenaArduino {
+public:
+  CadenaArduino() {}
+  CadenaArduino(const char *texto) {
+    concat(texto, strlen(texto));
+  }
+  explicit CadenaArduino(uint32_t valor) {
+    char texto[12];
+    snprintf(texto, sizeof(texto), "%u", (unsigned)valor);
+    concat(texto, strlen(texto));
+  }
+  CadenaArduino(float valor, int decimales) {
+    char texto[24];
+    snprintf(texto, sizeof(texto), "%.*f", decimales, valor);
+    concat(texto, strlen(texto));
+  }
+  CadenaArduino(const CadenaArduino &otra) {
+    concat(otra.c_str(), otra._longitud);
+  }
+  CadenaArduino(CadenaArduino &&otra) noexcept
+    : _heap(otra._heap), _capacidad(otra._capacidad), _longitud(otra._longitud) {
+    memcpy(_sso, otra._sso, sizeof(_sso));
+    otra._heap = nullptr;
+    otra._longitud = 0;
+  }
+  ~CadenaArduino() {
+    delete[] _heap;
+  }
+
+  CadenaArduino &operator=(const char *texto) {
+    _longitud = 0;
+    return concat(texto, strlen(texto));
+  }
+  CadenaArduino &operator=(const CadenaArduino &otra) {
+    if (this != &otra) {
+      _longitud = 0;
+      concat(otra.c_str(), otra._longitud);
+    }
+    return *this;
+  }
+  CadenaArduino &operator=(CadenaArduino &&otra) noexcept {
+    if (this != &otra) {
+      delete[] _heap;
+      _heap = otra._heap;
+      _capacidad = otra._capacidad;
+      _longitud = otra._longitud;
+      memcpy(_sso, otra._sso, sizeof(_sso));
+      otra._heap = nullptr;
+      otra._longitud = 0;
+    }
+    return *this;
+  }
+
+  // Como String::replace(): crece una sola vez si hace falta y sustituye
+  // sobre el mismo buffer
+  void replace(const char *buscar, const char *poner) {
+    size_t nb = strlen(buscar);
+    size_t np = strlen(poner);
+    size_t veces = 0;
+    for (const char *p = c_str(); (p = strstr(p, buscar)); p += nb) {
+      veces++;
+    }
+    if (veces == 0) {
+      return;
+    }
+    size_t total = _longitud + veces * np - veces * nb;
+    char *resultado = (char *)malloc(total + 1);   // Auxiliar, fuera de la cuenta del heap
+    char *d = resultado;
+    const char *origen = c_str();
+    for (const char *p; (p = strstr(origen, buscar)); origen = p + nb) {
+      memcpy(d, origen, p - origen);
+      d += p - origen;
+      memcpy(d, poner, np);
+      d += np;
+    }
+    strcpy(d, origen);
+    _longitud = 0;
+    concat(resultado, total);
+    free(resultado);
+  }
+  void replace(const char *buscar, const CadenaArduino &poner) {
+    replace(buscar, poner.c_str());
+  }
+
+  CadenaArduino &operator+=(const char *texto) {
+    return concat(texto, strlen(texto));
+  }
+  CadenaArduino &operator+=(const CadenaArduino &otra) {
+    return concat(otra.c_str(), otra._longitud);
+  }
+  const char *c_str() const {
+    return _heap ? _heap : _sso;
+  }
+  size_t length() const {
+    return _longitud;
+  }
+
+private:
+  static const size_t TAM_SSO = 11;
+
+  CadenaArduino &concat(const char *texto, size_t n) {
+    size_t total = _longitud + n;
+    if (total >= TAM_SSO && total + 1 > _capacidad) {
+      size_t nueva = (total + 16) & ~(size_t)0xF;
+      char *buffer = new char[nueva];
+      memcpy(buffer, c_str(), _longitud);
+      delete[] _heap;
+      _heap = buffer;
+      _capacidad = nueva;
+    }
+    char *destino = _heap ? _heap : _sso;
+    memcpy(destino + _longitud, texto, n);
+    _longitud = total;
+    destino[_longitud] = '\0';
+    return *this;
+  }
+
+  char _sso[TAM_SSO] = {};
+  char *_heap = nullptr;
+  size_t _capacidad = 0;
+  size_t _longitud = 0;
+};
+
+inline CadenaArduino operator+(const char *a, const CadenaArduino &b) {
+  CadenaArduino suma(a);
+  suma += b;
+  return suma;
+}
+
+inline CadenaArduino operator+(CadenaArduino &&a, const char *b) {
+  a += b;
+  return std::move(a);
+}
+
+struct Lectura {
+  uint32_t cajas;
+  uint32_t angulo;
+  bool conectado;
+  bool libre;
+};
+
+static const Lectura LECTURA = {1234, 2048, true, false};
+
+// handleRoot() tal como estaba antes del escritor
+inline CadenaArduino paginaConString(const Lectura &l) {
+  CadenaArduino html = "<!DOCTYPE html><html><head>";
+  html += "<meta charset='UTF-8'>";
+  html += "<meta name='viewport' content='width=device-width, initial-scale=1'>";
+  html += "<title>ESP32 - Sistema de Sensores</title>";
+  html += "<style>";
+  html += "body { font-family: Arial, sans-serif; margin: 0; padding: 20px; background: #f0f0f0; }";
+  html += ".container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 0 10px rgba(0,0,0,0.1); }";
+  html += "h1 { color: #333; text-align: center; }";
+  html += ".sensor-data { background: #e9ecef; padding: 15px; margin: 10px 0; border-radius: 5px; }";
+  html += ".refresh-btn { background: #007bff; color: white; padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; margin: 10px 0; }";
+  html += ".refresh-btn:hover { background: #0056b3; }";
+  html += "</style>";
+  html += "<script>";
+  html += "function autoRefresh() { setTimeout(function(){ location.reload(); }, 2000); }";
+  html += "</script>";
+  html += "</head><body onload='autoRefresh()'>";
+  html += "<div class='container'>";
+  html += "<h1>ESP32 - Sistema de Sensores</h1>";
+
+  html += "<div class='sensor-data'>";
+  html += "<h3>Contador de Cajas</h3>";
+  html += "<p><strong>Total detectado: " + CadenaArduino(l.cajas) + "</strong></p>";
+  html += "</div>";
+
+  html += "<div class='sensor-data'>";
+  html += "<h3>Sensor AS5600 (Magnético)</h3>";
+  if (l.conectado) {
+    float grados = l.angulo * 0.087890625;
+    html += "<p>Ángulo: <strong>" + CadenaArduino(l.angulo) + "</strong> (RAW)</p>";
+    html += "<p>Grados: <strong>" + CadenaArduino(grados, 1) + "°</strong></p>";
+    html += "<p>Estado: <span style='color: green;'>Conectado</span></p>";
+  } else {
+    html += "<p>Estado: <span style='color: red;'>No conectado</span></p>";
+  }
+  html += "</div>";
+
+  html += "<div class='sensor-data'>";
+  html += "<h3>Sensor E18-D80NK (Proximidad)</h3>";
+  html += "<p>Estado: <strong>" + CadenaArduino(l.libre ? "LIBRE" : "OBSTÁCULO DETECTADO") + "</strong></p>";
+  html += "<p>Color: <span style='color: " + CadenaArduino(l.libre ? "green" : "red") + ";'>●</span></p>";
+  html += "</div>";
+
+  html += "<button class='refresh-btn' onclick='location.reload()'>Actualizar</button>";
+  html += "<p style='text-align: center; color: #666; font-size: 12px;'>Actualización automática cada 2 segundos</p>";
+  html += "</div></body></html>";
+  return html;
+}
@@ -0,0 +1,146 @@
+#include <unity.h>
+#include <stdio.h>
+#include "adc_as5600.h"
+
+// Lectura cruda ideal del ADC para un ángulo: recta entre los dos puntos de
+// la calibración, redondeada a cuentas enteras
+static uint16_t crudoIdeal(uint16_t angulo, const CalibracionAdc &c) {
+  double crudo = c.crudoCero + angulo * ((double)c.crudoFondo - c.crudoCero) / 4095.0;
+  return (uint16_t)(crudo + 0.5);
+}
+
+// Error máximo de anguloDesdeAdc() en los 4096 ángulos
+static int barrido(const CalibracionAdc &c) {
+  int errorMaximo = 0;
+  for (uint32_t angulo = 0; angulo < 4096; angulo++) {
+    int error = abs((int)anguloDesdeAdc(crudoIdeal(angulo, c), c) - (int)angulo);
+    errorMaximo = max(errorMaximo, error);
+  }
+  return errorMaximo;
+}
+
+static void informar(const char *nombre, int errorMaximo) {
+  char mensaje[80];
+  snprintf(mensaje, sizeof(mensaje), "%s: error máximo %d LSB", nombre, errorMaximo);
+  TEST_MESSAGE(mensaje);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_calibracion_nominal() {
+  CalibracionAdc c90 = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90);
+  TEST_ASSERT_EQUAL(410, c90.crudoCero);
+  TEST_ASSERT_EQUAL(3686, c90.crudoFondo);
+  CalibracionAdc c100 = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_100);
+  TEST_ASSERT_EQUAL(0, c100.crudoCero);
+  TEST_ASSERT_EQUAL(4095, c100.crudoFondo);
+}
+
+// 0-100 %: una cuenta del ADC por cuenta de ángulo, sin error
+static void test_barrido_modo_100() {
+  int error = barrido(calibracionNominalAdc(AS5600_OUTMODE_ANALOG_100));
+  informar("0-100 %", error);
+  TEST_ASSERT_EQUAL(0, error);
+}
+
+// 10-90 % y calibraciones de placa: hay menos cuentas del ADC que ángulos,
+// así que la cuantización cuesta como mucho 1 LSB
+static void test_barrido_modo_90_y_calibrado() {
+  int error = barrido(calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90));
+  informar("10-90 %", error);
+  TEST_ASSERT_LESS_OR_EQUAL(1, error);
+
+  CalibracionAdc placa = {420, 3650};
+  error = barrido(placa);
+  informar("Placa 420-3650", error);
+  TEST_ASSERT_LESS_OR_EQUAL(1, error);
+
+  CalibracionAdc invertida = {3686, 410};
+  error = barrido(invertida);
+  informar("Invertida 3686-410", error);
+  TEST_ASSERT_LESS_OR_EQUAL(1, error);
+}
+
+static void test_fuera_de_rango() {
+  CalibracionAdc c = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90);
+  TEST_ASSERT_EQUAL(0, anguloDesdeAdc(0, c));
+  TEST_ASSERT_EQUAL(0, anguloDesdeAdc(409, c));
+  TEST_ASSERT_EQUAL(4095, anguloDesdeAdc(3700, c));
+  TEST_ASSERT_EQUAL(4095, anguloDesdeAdc(4095, c));
+
+  CalibracionAdc invertida = {3686, 410};
+  TEST_ASSERT_EQUAL(0, anguloDesdeAdc(4000, invertida));
+  TEST_ASSERT_EQUAL(4095, anguloDesdeAdc(100, invertida));
+
+  // Calibración degenerada: sin rango no hay ángulo
+  CalibracionAdc plana = {2000, 2000};
+  TEST_ASSERT_EQUAL(0, anguloDesdeAdc(2000, plana));
+  TEST_ASSERT_EQUAL(0, anguloDesdeAdc(3000, plana));
+}
+
+// Un bloque con ruido simétrico da la media: el mismo ángulo que sin ruido
+static void test_bloque_con_ruido() {
+  CalibracionAdc c = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90);
+  uint16_t bloque[ADC_AS5600_DECIMACION];
+  for (uint32_t angulo = 100; angulo < 4000; angulo += 37) {
+    uint16_t crudo = crudoIdeal(angulo, c);
+    for (size_t i = 0; i < ADC_AS5600_DECIMACION; i++) {
+      bloque[i] = crudo + ((int)(i % 5) - 2) * 6;
+    }
+    bool cruza;
+    uint16_t media = decimarBloqueAdc(bloque, ADC_AS5600_DECIMACION, c, cruza);
+    TEST_ASSERT_FALSE(cruza);
+    TEST_ASSERT_EQUAL(crudo, media);
+    TEST_ASSERT_INT_WITHIN(1, angulo, anguloDesdeAdc(media, c));
+  }
+}
+
+// Si el bloque cruza el paso de 4095 a 0 la media sería un ángulo falso
+// del otro lado: se toma la última lectura
+static void test_bloque_cruza_vuelta() {
+  CalibracionAdc c = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90);
+  uint16_t bloque[ADC_AS5600_DECIMACION];
+  for (size_t i = 0; i < ADC_AS5600_DECIMACION; i++) {
+    bloque[i] = crudoIdeal(i < 12 ? 4080 + i : i - 12, c);
+  }
+  bool cruza;
+  uint16_t crudo = decimarBloqueAdc(bloque, ADC_AS5600_DECIMACION, c, cruza);
+  TEST_ASSERT_TRUE(cruza);
+  TEST_ASSERT_EQUAL(bloque[ADC_AS5600_DECIMACION - 1], crudo);
+  TEST_ASSERT_INT_WITHIN(1, 7, anguloDesdeAdc(crudo, c));
+
+  // Con la escala invertida el salto va al revés y también se detecta
+  CalibracionAdc invertida = {3686, 410};
+  for (size_t i = 0; i < ADC_AS5600_DECIMACION; i++) {
+    bloque[i] = crudoIdeal(i < 12 ? 4080 + i : i - 12, invertida);
+  }
+  decimarBloqueAdc(bloque, ADC_AS5600_DECIMACION, invertida, cruza);
+  TEST_ASSERT_TRUE(cruza);
+
+  // Un giro rápido sin cruzar no es una vuelta
+  for (size_t i = 0; i < ADC_AS5600_DECIMACION; i++) {
+    bloque[i] = crudoIdeal(1000 + i * 40, c);
+  }
+  decimarBloqueAdc(bloque, ADC_AS5600_DECIMACION, c, cruza);
+  TEST_ASSERT_FALSE(cruza);
+}
+
+static void test_bloque_vacio() {
+  CalibracionAdc c = calibracionNominalAdc(AS5600_OUTMODE_ANALOG_90);
+  bool cruza = true;
+  TEST_ASSERT_EQUAL(0, decimarBloqueAdc(nullptr, 0, c, cruza));
+  TEST_ASSERT_FALSE(cruza);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_calibracion_nominal);
+  RUN_TEST(test_barrido_modo_100);
+  RUN_TEST(test_barrido_modo_90_y_calibrado);
+  RUN_TEST(test_fuera_de_rango);
+  RUN_TEST(test_bloque_con_ruido);
+  RUN_TEST(test_bloque_cruza_vuelta);
+  RUN_TEST(test_bloque_vacio);
+  return UNITY_END();
+}
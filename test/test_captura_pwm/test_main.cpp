@@ -0,0 +1,91 @@
+#include <unity.h>
+#include <stdio.h>
+#include "captura_pwm.h"
+
+// Capturas sintéticas: la unidad de captura cuenta con el reloj APB
+// (80 MHz) y el oscilador del AS5600 puede ir un 10 % por encima o por
+// debajo de 920 Hz
+static const double TICKS_POR_S = 80e6;
+static const double FRECUENCIA_NOMINAL_HZ = 920;
+
+struct Captura {
+  uint32_t alto;
+  uint32_t periodo;
+};
+
+// Trama del ángulo dado con el oscilador a "factor" de su frecuencia y los
+// flancos cuantizados a ticks enteros, desplazados "ruido" ticks
+static Captura trama(uint16_t angulo, double factor, int ruidoAlto = 0, int ruidoPeriodo = 0) {
+  double ticksPorBit = TICKS_POR_S / (FRECUENCIA_NOMINAL_HZ * factor * CAPTURA_PWM_BITS_TRAMA);
+  Captura c;
+  c.alto = (uint32_t)((CAPTURA_PWM_BITS_CABECERA + angulo) * ticksPorBit + 0.5) + ruidoAlto;
+  c.periodo = (uint32_t)(CAPTURA_PWM_BITS_TRAMA * ticksPorBit + 0.5) + ruidoPeriodo;
+  return c;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Todos los ángulos, con el oscilador lento, nominal y rápido: error 0
+static void test_barrido_sin_error() {
+  const double factores[] = {0.9, 0.95, 1.0, 1.05, 1.1};
+  for (double factor : factores) {
+    int errorMaximo = 0;
+    for (uint32_t angulo = 0; angulo < 4096; angulo++) {
+      Captura c = trama(angulo, factor);
+      int error = abs((int)anguloDesdePwm(c.alto, c.periodo) - (int)angulo);
+      errorMaximo = max(errorMaximo, error);
+    }
+    char mensaje[64];
+    snprintf(mensaje, sizeof(mensaje), "Reloj x%.2f: error máximo %d LSB", factor, errorMaximo);
+    TEST_MESSAGE(mensaje);
+    TEST_ASSERT_EQUAL(0, errorMaximo);
+  }
+}
+
+// Un tick de error en cada flanco (captura asíncrona) tampoco cambia el
+// resultado: un bit son 18 ticks o más
+static void test_barrido_con_un_tick_de_ruido() {
+  const double factores[] = {0.9, 1.1};
+  for (double factor : factores) {
+    for (uint32_t angulo = 0; angulo < 4096; angulo++) {
+      for (int ruidoAlto = -1; ruidoAlto <= 1; ruidoAlto++) {
+        for (int ruidoPeriodo = -1; ruidoPeriodo <= 1; ruidoPeriodo++) {
+          if (angulo == 0 && ruidoAlto < 0) {
+            continue;
+          }
+          Captura c = trama(angulo, factor, ruidoAlto, ruidoPeriodo);
+          TEST_ASSERT_EQUAL(angulo, anguloDesdePwm(c.alto, c.periodo));
+        }
+      }
+    }
+  }
+}
+
+// El margen de periodos aceptados cubre el ±10 % del oscilador
+static void test_margen_de_periodo() {
+  double periodoLentoUs = 1e6 / (FRECUENCIA_NOMINAL_HZ * 0.9);
+  double periodoRapidoUs = 1e6 / (FRECUENCIA_NOMINAL_HZ * 1.1);
+  TEST_ASSERT_TRUE(periodoLentoUs < CAPTURA_PWM_PERIODO_MAX_US);
+  TEST_ASSERT_TRUE(periodoRapidoUs > CAPTURA_PWM_PERIODO_MIN_US);
+}
+
+static void test_tramas_imposibles() {
+  TEST_ASSERT_EQUAL(0, anguloDesdePwm(100, 0));
+  TEST_ASSERT_EQUAL(0, anguloDesdePwm(0, 86957));
+  // Más tiempo en alto que el periodo: flancos perdidos
+  TEST_ASSERT_EQUAL(0, anguloDesdePwm(90000, 86957));
+  // Alto durante más que cabecera + 4095: se satura
+  TEST_ASSERT_EQUAL(4095, anguloDesdePwm(86957, 86957));
+  // Alto menor que la cabecera
+  TEST_ASSERT_EQUAL(0, anguloDesdePwm(1000, 86957));
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_barrido_sin_error);
+  RUN_TEST(test_barrido_con_un_tick_de_ruido);
+  RUN_TEST(test_margen_de_periodo);
+  RUN_TEST(test_tramas_imposibles);
+  return UNITY_END();
+}
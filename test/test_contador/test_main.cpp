@@ -0,0 +1,180 @@
+#include <unity.h>
+#include <stdio.h>
+#include <vector>
+#include "contador_cajas.h"
+
+static const uint32_t DEBOUNCE = 5000;
+
+struct Flanco {
+  uint32_t tiempoUs;
+  bool alto;
+};
+
+struct Resultado {
+  uint32_t cajas;
+  uint32_t rebotes;
+};
+
+// Pasa un tren de flancos por el filtro como lo haría la ISR
+static Resultado contar(const Flanco *flancos, size_t cantidad, bool altoInicial = true) {
+  FiltroRebote filtro;
+  iniciarFiltroRebote(filtro, altoInicial);
+  Resultado r = {0, 0};
+  for (size_t i = 0; i < cantidad; i++) {
+    FlancoCaja f = filtrarFlancoCaja(filtro, flancos[i].alto, flancos[i].tiempoUs, DEBOUNCE);
+    if (f == FLANCO_CAJA) r.cajas++;
+    if (f == FLANCO_REBOTE) r.rebotes++;
+  }
+  return r;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_cajas_limpias() {
+  const Flanco tren[] = {
+    {1000000, false}, {1200000, true},
+    {2000000, false}, {2200000, true},
+    {3000000, false}, {3200000, true},
+  };
+  Resultado r = contar(tren, 6);
+  TEST_ASSERT_EQUAL(3, r.cajas);
+  TEST_ASSERT_EQUAL(0, r.rebotes);
+}
+
+void test_rebote_al_entrar() {
+  const Flanco tren[] = {
+    {1000000, false}, {1000050, true}, {1000100, false}, {1000150, true}, {1000200, false},
+    {1200000, true},
+  };
+  Resultado r = contar(tren, 6);
+  TEST_ASSERT_EQUAL(1, r.cajas);
+  TEST_ASSERT_EQUAL(2, r.rebotes);
+}
+
+// La caja tapa el sensor 20 ms: el rebote al soltar llega más de una
+// ventana después de la caja contada y no debe contar como otra
+void test_rebote_al_salir_fuera_de_la_ventana() {
+  const Flanco tren[] = {
+    {0, false},
+    {20000, true}, {20100, false}, {20200, true}, {20300, false}, {20400, true},
+    {100000, false}, {120000, true},
+  };
+  Resultado r = contar(tren, 8);
+  TEST_ASSERT_EQUAL(2, r.cajas);
+  TEST_ASSERT_EQUAL(2, r.rebotes);
+}
+
+void test_hueco_menor_que_la_ventana() {
+  const Flanco tren[] = {
+    {0, false}, {20000, true}, {24999, false}, {40000, true}, {45000, false},
+  };
+  Resultado r = contar(tren, 5);
+  TEST_ASSERT_EQUAL(2, r.cajas);
+  TEST_ASSERT_EQUAL(1, r.rebotes);
+}
+
+void test_arranque_con_la_linea_tapada() {
+  // Sin haber visto la línea libre, la primera bajada no cuenta
+  const Flanco tren[] = {
+    {100, false}, {200, true}, {300, false}, {10000, true}, {16000, false},
+  };
+  Resultado r = contar(tren, 5, false);
+  TEST_ASSERT_EQUAL(1, r.cajas);
+  TEST_ASSERT_EQUAL(2, r.rebotes);
+}
+
+void test_subida_perdida() {
+  // Dos bajadas seguidas: la línea no se vio libre entre ellas
+  const Flanco tren[] = {
+    {0, false}, {50000, false},
+  };
+  Resultado r = contar(tren, 2);
+  TEST_ASSERT_EQUAL(1, r.cajas);
+  TEST_ASSERT_EQUAL(1, r.rebotes);
+}
+
+void test_desborde_de_micros() {
+  const Flanco tren[] = {
+    {0xFFFFF000, false}, {0xFFFFF100, true}, {0x00001000, false},
+  };
+  Resultado r = contar(tren, 3);
+  TEST_ASSERT_EQUAL(2, r.cajas);
+  TEST_ASSERT_EQUAL(0, r.rebotes);
+}
+
+// Tren de cajas a ritmo constante: cada caja tapa el sensor medio periodo
+// y rebota al entrar y al salir (dos idas y vueltas, REBOTE_US en total).
+// Empieza cerca del desborde de micros() para cruzarlo.
+static const uint32_t REBOTE_US = 400;
+
+static std::vector<Flanco> trenDeCajas(uint32_t periodoUs, uint32_t cajas) {
+  std::vector<Flanco> tren;
+  uint32_t t = 0xFFF00000;
+  for (uint32_t i = 0; i < cajas; i++) {
+    uint32_t salida = t + periodoUs / 2;
+    for (uint32_t k = 0; k < 5; k++) {
+      tren.push_back({t + k * REBOTE_US / 4, k % 2 == 1});
+    }
+    for (uint32_t k = 0; k < 5; k++) {
+      tren.push_back({salida + k * REBOTE_US / 4, k % 2 == 0});
+    }
+    t += periodoUs;
+  }
+  return tren;
+}
+
+// La línea queda libre periodo/2 - REBOTE_US entre cajas: todas cuentan
+// mientras eso no baje de la ventana de rebote
+static uint32_t periodoMinimoUs() {
+  return 2 * (DEBOUNCE + REBOTE_US);
+}
+
+void test_barrido_de_ritmos() {
+  const uint32_t CAJAS = 500;
+  const uint32_t periodos[] = {1000000, 200000, 50000, 20000, 12000,
+                               periodoMinimoUs() + 2, periodoMinimoUs()};
+  for (uint32_t periodo : periodos) {
+    std::vector<Flanco> tren = trenDeCajas(periodo, CAJAS);
+    Resultado r = contar(tren.data(), tren.size());
+    char mensaje[96];
+    snprintf(mensaje, sizeof(mensaje), "%.2f cajas/s: %u de %u, %u rebotes",
+             1e6 / periodo, (unsigned)r.cajas, (unsigned)CAJAS, (unsigned)r.rebotes);
+    TEST_MESSAGE(mensaje);
+    TEST_ASSERT_EQUAL(CAJAS, r.cajas);
+    // Cuatro bajadas de rebote por caja: dos al entrar y dos al salir
+    TEST_ASSERT_EQUAL(4 * CAJAS, r.rebotes);
+  }
+}
+
+// Justo por encima del límite la línea no llega a estar libre toda la
+// ventana: una caja no se distingue de un rebote y se descarta, nunca se
+// cuenta de más. Solo cuenta la primera (el filtro arranca armado).
+void test_barrido_pasado_el_limite() {
+  const uint32_t CAJAS = 500;
+  const uint32_t periodos[] = {periodoMinimoUs() - 2, periodoMinimoUs() - 200};
+  for (uint32_t periodo : periodos) {
+    std::vector<Flanco> tren = trenDeCajas(periodo, CAJAS);
+    Resultado r = contar(tren.data(), tren.size());
+    char mensaje[96];
+    snprintf(mensaje, sizeof(mensaje), "%.2f cajas/s: %u de %u, %u rebotes",
+             1e6 / periodo, (unsigned)r.cajas, (unsigned)CAJAS, (unsigned)r.rebotes);
+    TEST_MESSAGE(mensaje);
+    TEST_ASSERT_EQUAL(1, r.cajas);
+    TEST_ASSERT_EQUAL(5 * CAJAS - 1, r.rebotes);
+  }
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_cajas_limpias);
+  RUN_TEST(test_rebote_al_entrar);
+  RUN_TEST(test_rebote_al_salir_fuera_de_la_ventana);
+  RUN_TEST(test_hueco_menor_que_la_ventana);
+  RUN_TEST(test_arranque_con_la_linea_tapada);
+  RUN_TEST(test_subida_perdida);
+  RUN_TEST(test_desborde_de_micros);
+  RUN_TEST(test_barrido_de_ritmos);
+  RUN_TEST(test_barrido_pasado_el_limite);
+  return UNITY_END();
+}
@@ -0,0 +1,347 @@
+#include <unity.h>
+#include <FS.h>
+#include <string>
+#include <vector>
+#include "enlace_http.h"
+
+// Servidor simulado: contesta con los códigos programados (200 al acabarse)
+// y guarda lo que recibe
+struct ServidorSimulado {
+  std::vector<int> codigos;
+  size_t siguiente = 0;
+  std::vector<uint32_t> recibidos;
+  std::vector<std::string> cuerpos;
+};
+
+static int enviarSimulado(void *contexto, const char *datos, size_t longitud,
+                          uint32_t, uint32_t numero) {
+  ServidorSimulado &s = *(ServidorSimulado *)contexto;
+  int codigo = s.siguiente < s.codigos.size() ? s.codigos[s.siguiente++] : 200;
+  s.recibidos.push_back(numero);
+  s.cuerpos.push_back(std::string(datos, longitud));
+  return codigo;
+}
+
+static char buffer[ENLACE_TAM_PAYLOAD];
+
+// Servidor antiguo: solo entiende JSON
+static int servidorSoloJson(void *contexto, const char *datos, size_t longitud,
+                            uint32_t arranque, uint32_t numero) {
+  enviarSimulado(contexto, datos, longitud, arranque, numero);
+  return datos[0] == '{' ? 200 : 415;
+}
+
+// Lote binario de "puntos" puntos; deja en "json" el mismo lote en JSON
+static size_t loteBinario(uint32_t puntos, uint32_t primerConteo, char *destino, std::string &json) {
+  static LoteTelemetria lote;
+  lote.vaciar();
+  for (uint32_t i = 0; i < puntos; i++) {
+    Muestra m = {};
+    m.tiempoUs = micros();
+    m.angulo = (i * 100) % 4096;
+    m.conteo = primerConteo + i;
+    m.conectado = true;
+    lote.agregar(m);
+    relojPruebaUs += LOTE_INTERVALO_MS * 1000;
+  }
+  static char texto[ENLACE_TAM_PAYLOAD];
+  EscritorBuffer escritor(texto, sizeof(texto));
+  lote.serializar(escritor, millis());
+  json = escritor.c_str();
+  return lote.codificarBinario((uint8_t *)destino, ENLACE_TAM_PAYLOAD, millis());
+}
+
+void setUp() {
+  relojPruebaUs = 0;
+}
+
+void tearDown() {}
+
+static void avanzarMs(uint32_t ms) {
+  relojPruebaUs += ms * 1000;
+}
+
+static void despacharTexto(DespachoEnlace &d, uint32_t numero, bool enLinea) {
+  char texto[32];
+  snprintf(texto, sizeof(texto), "{\"lote\":%lu}", (unsigned long)numero);
+  d.despachar(texto, strlen(texto), numero, enLinea);
+}
+
+// Vacía el diario como lo hace la tarea del enlace
+static void reenviarTodo(DespachoEnlace &d, DiarioTelemetria &diario) {
+  for (int vueltas = 0; diario.hayPendientes() && vueltas < 1000; vueltas++) {
+    d.reenviarDiario(true);
+    avanzarMs(100);
+  }
+}
+
+void test_clasificacion_de_respuestas() {
+  TEST_ASSERT_EQUAL(RESPUESTA_ENTREGADO, clasificarRespuestaHttp(200));
+  TEST_ASSERT_EQUAL(RESPUESTA_ENTREGADO, clasificarRespuestaHttp(204));
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(-1));   // Sin conexión
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(-11));  // Tiempo agotado
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(500));
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(503));
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(408));
+  TEST_ASSERT_EQUAL(RESPUESTA_REINTENTAR, clasificarRespuestaHttp(429));
+  TEST_ASSERT_EQUAL(RESPUESTA_RECHAZADO, clasificarRespuestaHttp(400));
+  TEST_ASSERT_EQUAL(RESPUESTA_RECHAZADO, clasificarRespuestaHttp(404));
+  TEST_ASSERT_EQUAL(RESPUESTA_RECHAZADO, clasificarRespuestaHttp(413));
+  // Un 3xx no se sigue: tampoco es una entrega
+  TEST_ASSERT_EQUAL(RESPUESTA_RECHAZADO, clasificarRespuestaHttp(301));
+}
+
+void test_reenvio_con_503_no_confirma() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+
+  // Sin red todo va al diario
+  for (uint32_t n = 0; n < 3; n++) {
+    despacharTexto(d, n, false);
+  }
+  TEST_ASSERT_EQUAL(0, servidor.recibidos.size());
+  TEST_ASSERT_EQUAL(3, diario.estadisticas().anotados);
+
+  servidor.codigos = {503};
+  d.reenviarDiario(true);
+  TEST_ASSERT_EQUAL(1, d.estadisticas().fallidos);
+  TEST_ASSERT_EQUAL(0, d.estadisticas().enviados);
+  TEST_ASSERT_EQUAL(0, diario.estadisticas().reenviados);
+  TEST_ASSERT_EQUAL(ENLACE_ESPERA_MIN_MS, d.esperaRestanteMs());
+
+  // Durante la espera no se intenta nada
+  d.reenviarDiario(true);
+  TEST_ASSERT_EQUAL(1, servidor.recibidos.size());
+
+  avanzarMs(ENLACE_ESPERA_MIN_MS);
+  reenviarTodo(d, diario);
+  // El registro del 503 se repite y el orden se conserva
+  std::vector<uint32_t> esperados = {0, 0, 1, 2};
+  TEST_ASSERT_TRUE(servidor.recibidos == esperados);
+  TEST_ASSERT_EQUAL(3, d.estadisticas().enviados);
+  TEST_ASSERT_EQUAL(3, diario.estadisticas().reenviados);
+}
+
+void test_espera_exponencial() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  servidor.codigos = {500, 500, 500, 500, 500, 500, 500, 500, 500, 500, 500};
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+  despacharTexto(d, 0, false);
+
+  uint32_t espera = ENLACE_ESPERA_MIN_MS;
+  for (size_t i = 0; i < servidor.codigos.size(); i++) {
+    d.reenviarDiario(true);
+    TEST_ASSERT_EQUAL(espera, d.esperaRestanteMs());
+    avanzarMs(espera);
+    espera = min((uint32_t)ENLACE_ESPERA_MAX_MS, espera * 2);
+  }
+  TEST_ASSERT_EQUAL(ENLACE_ESPERA_MAX_MS, espera);
+
+  // La primera respuesta buena vuelve a la espera mínima
+  d.reenviarDiario(true);
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+  TEST_ASSERT_EQUAL(0, d.esperaRestanteMs());
+}
+
+void test_reenvio_rechazado_no_bloquea_el_diario() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+  for (uint32_t n = 0; n < 3; n++) {
+    despacharTexto(d, n, false);
+  }
+
+  servidor.codigos = {200, 400};
+  reenviarTodo(d, diario);
+  std::vector<uint32_t> esperados = {0, 1, 2};
+  TEST_ASSERT_TRUE(servidor.recibidos == esperados);
+  EstadisticasDespacho stats = d.estadisticas();
+  TEST_ASSERT_EQUAL(2, stats.enviados);
+  TEST_ASSERT_EQUAL(1, stats.rechazados);
+  TEST_ASSERT_EQUAL(0, stats.fallidos);
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+void test_reenvio_tras_reinicio() {
+  fs::FS flash;
+  {
+    DiarioTelemetria diario;
+    diario.iniciar(flash);
+    ServidorSimulado servidor;
+    DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+    for (uint32_t n = 0; n < 4; n++) {
+      despacharTexto(d, n, false);
+    }
+    servidor.codigos = {200, 503};
+    // Ya toca guardar el checkpoint tras el 0
+    avanzarMs(DIARIO_CHECKPOINT_MS);
+    d.reenviarDiario(true);
+    d.reenviarDiario(true);
+  }
+
+  // Tras el corte sigue por el 1, que el servidor no aceptó
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+  reenviarTodo(d, diario);
+  std::vector<uint32_t> esperados = {1, 2, 3};
+  TEST_ASSERT_TRUE(servidor.recibidos == esperados);
+}
+
+void test_envio_directo_con_500_va_al_diario() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  servidor.codigos = {500};
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+
+  despacharTexto(d, 0, true);
+  TEST_ASSERT_EQUAL(1, servidor.recibidos.size());
+  EstadisticasDespacho stats = d.estadisticas();
+  TEST_ASSERT_EQUAL(0, stats.enviados);
+  TEST_ASSERT_EQUAL(1, stats.fallidos);
+  TEST_ASSERT_EQUAL(1, diario.estadisticas().anotados);
+  TEST_ASSERT_TRUE(diario.hayPendientes());
+
+  // El payload anotado es el mismo y se entrega al reintentar
+  char leido[64];
+  uint32_t arranque, numero;
+  size_t longitud = diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+  TEST_ASSERT_EQUAL(servidor.cuerpos[0].size(), longitud);
+  TEST_ASSERT_EQUAL_MEMORY(servidor.cuerpos[0].data(), leido, longitud);
+  TEST_ASSERT_EQUAL(0, numero);
+
+  avanzarMs(ENLACE_ESPERA_MIN_MS);
+  reenviarTodo(d, diario);
+  TEST_ASSERT_EQUAL(1, d.estadisticas().enviados);
+  TEST_ASSERT_EQUAL_STRING(servidor.cuerpos[0].c_str(), servidor.cuerpos[1].c_str());
+}
+
+void test_envio_directo_entregado_o_rechazado() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  servidor.codigos = {200, 422, 201};
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+
+  for (uint32_t n = 0; n < 3; n++) {
+    despacharTexto(d, n, true);
+  }
+  EstadisticasDespacho stats = d.estadisticas();
+  TEST_ASSERT_EQUAL(2, stats.enviados);
+  TEST_ASSERT_EQUAL(1, stats.rechazados);
+  TEST_ASSERT_EQUAL(0, stats.fallidos);
+  // Un 4xx no se reintenta: no pasa por el diario
+  TEST_ASSERT_EQUAL(0, diario.estadisticas().anotados);
+}
+
+void test_tras_un_fallo_lo_nuevo_espera_en_el_diario() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  servidor.codigos = {503};
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+
+  despacharTexto(d, 0, true);
+  // Con atrasos, lo nuevo no se adelanta aunque haya red
+  avanzarMs(ENLACE_ESPERA_MIN_MS);
+  despacharTexto(d, 1, true);
+  despacharTexto(d, 2, true);
+  TEST_ASSERT_EQUAL(1, servidor.recibidos.size());
+  TEST_ASSERT_EQUAL(3, diario.estadisticas().anotados);
+
+  reenviarTodo(d, diario);
+  std::vector<uint32_t> esperados = {0, 0, 1, 2};
+  TEST_ASSERT_TRUE(servidor.recibidos == esperados);
+}
+
+void test_415_repite_el_lote_en_json() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  DespachoEnlace d(diario, buffer, sizeof(buffer), servidorSoloJson, &servidor);
+
+  static char binario[ENLACE_TAM_PAYLOAD];
+  std::string json;
+  size_t bytes = loteBinario(10, 0, binario, json);
+  TEST_ASSERT_TRUE(d.aceptaBinario());
+  d.despachar(binario, bytes, 0, true);
+
+  // El mismo lote se entrega en JSON en el acto y no se pierde
+  TEST_ASSERT_FALSE(d.aceptaBinario());
+  TEST_ASSERT_EQUAL(2, servidor.recibidos.size());
+  TEST_ASSERT_EQUAL_STRING(json.c_str(), servidor.cuerpos[1].c_str());
+  EstadisticasDespacho stats = d.estadisticas();
+  TEST_ASSERT_EQUAL(1, stats.enviados);
+  TEST_ASSERT_EQUAL(0, stats.rechazados);
+  TEST_ASSERT_EQUAL(0, stats.fallidos);
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+void test_binarios_del_diario_se_reenvian_en_json() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  DespachoEnlace d(diario, buffer, sizeof(buffer), servidorSoloJson, &servidor);
+
+  // Sin red se anotan tres lotes binarios
+  static char binario[ENLACE_TAM_PAYLOAD];
+  std::string json[3];
+  for (uint32_t n = 0; n < 3; n++) {
+    size_t bytes = loteBinario(5, n * 5, binario, json[n]);
+    d.despachar(binario, bytes, n, false);
+  }
+
+  reenviarTodo(d, diario);
+  // El primero se rechaza en binario y se repite; el resto ya va en JSON
+  TEST_ASSERT_EQUAL(4, servidor.cuerpos.size());
+  TEST_ASSERT_NOT_EQUAL('{', servidor.cuerpos[0][0]);
+  for (uint32_t n = 0; n < 3; n++) {
+    TEST_ASSERT_EQUAL_STRING(json[n].c_str(), servidor.cuerpos[n + 1].c_str());
+  }
+  TEST_ASSERT_EQUAL(3, d.estadisticas().enviados);
+  TEST_ASSERT_EQUAL(3, diario.estadisticas().reenviados);
+}
+
+void test_415_a_un_json_se_rechaza() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  ServidorSimulado servidor;
+  servidor.codigos = {415};
+  DespachoEnlace d(diario, buffer, sizeof(buffer), enviarSimulado, &servidor);
+  despacharTexto(d, 0, true);
+  TEST_ASSERT_EQUAL(1, d.estadisticas().rechazados);
+  TEST_ASSERT_TRUE(d.aceptaBinario());
+  TEST_ASSERT_EQUAL(1, servidor.recibidos.size());
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clasificacion_de_respuestas);
+  RUN_TEST(test_reenvio_con_503_no_confirma);
+  RUN_TEST(test_espera_exponencial);
+  RUN_TEST(test_reenvio_rechazado_no_bloquea_el_diario);
+  RUN_TEST(test_reenvio_tras_reinicio);
+  RUN_TEST(test_envio_directo_con_500_va_al_diario);
+  RUN_TEST(test_envio_directo_entregado_o_rechazado);
+  RUN_TEST(test_tras_un_fallo_lo_nuevo_espera_en_el_diario);
+  RUN_TEST(test_415_repite_el_lote_en_json);
+  RUN_TEST(test_binarios_del_diario_se_reenvian_en_json);
+  RUN_TEST(test_415_a_un_json_se_rechaza);
+  return UNITY_END();
+}
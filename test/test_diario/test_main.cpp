@@ -0,0 +1,287 @@
+#include <unity.h>
+#include <FS.h>
+#include "diario_telemetria.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void payload(uint32_t numero, char *texto, size_t maximo) {
+  snprintf(texto, maximo, "{\"lote\":%lu}", (unsigned long)numero);
+}
+
+static void anotarVarios(DiarioTelemetria &diario, uint32_t desde, uint32_t hasta) {
+  char texto[32];
+  for (uint32_t n = desde; n < hasta; n++) {
+    payload(n, texto, sizeof(texto));
+    TEST_ASSERT_TRUE(diario.anotar(texto, strlen(texto), n));
+  }
+}
+
+// Reenvía hasta "cuantos" registros comprobando el orden y el contenido.
+// Devuelve el número del siguiente esperado.
+static uint32_t reenviar(DiarioTelemetria &diario, uint32_t esperado, uint32_t cuantos) {
+  char leido[64];
+  char texto[32];
+  for (uint32_t i = 0; i < cuantos; i++) {
+    uint32_t arranque, numero;
+    size_t longitud = diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+    if (longitud == 0) {
+      break;
+    }
+    payload(esperado, texto, sizeof(texto));
+    TEST_ASSERT_EQUAL(esperado, numero);
+    TEST_ASSERT_EQUAL(strlen(texto), longitud);
+    TEST_ASSERT_EQUAL_MEMORY(texto, leido, longitud);
+    diario.confirmar();
+    esperado++;
+  }
+  return esperado;
+}
+
+void test_anotar_y_reenviar_en_orden() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  TEST_ASSERT_TRUE(diario.iniciar(flash));
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+
+  anotarVarios(diario, 0, 50);
+  TEST_ASSERT_TRUE(diario.hayPendientes());
+  TEST_ASSERT_EQUAL(50, reenviar(diario, 0, 100));
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+
+  EstadisticasDiario stats = diario.estadisticas();
+  TEST_ASSERT_EQUAL(50, stats.anotados);
+  TEST_ASSERT_EQUAL(50, stats.reenviados);
+  TEST_ASSERT_EQUAL(0, stats.perdidos);
+  TEST_ASSERT_EQUAL(0, stats.bytesPendientes);
+}
+
+void test_leer_sin_confirmar_repite_el_registro() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  anotarVarios(diario, 7, 9);
+
+  char leido[64];
+  uint32_t arranque, numero;
+  diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+  TEST_ASSERT_EQUAL(7, numero);
+  TEST_ASSERT_EQUAL(diario.arranque(), arranque);
+  // El envío falló: sin confirmar se vuelve a leer el mismo
+  diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+  TEST_ASSERT_EQUAL(7, numero);
+}
+
+void test_reinicio_sigue_desde_el_checkpoint() {
+  fs::FS flash;
+  uint32_t primerArranque;
+  {
+    DiarioTelemetria diario;
+    diario.iniciar(flash);
+    primerArranque = diario.arranque();
+    anotarVarios(diario, 0, 30);
+    TEST_ASSERT_EQUAL(11, reenviar(diario, 0, 11));
+    // El checkpoint del duodécimo ya toca guardarlo
+    relojPruebaUs += DIARIO_CHECKPOINT_MS * 1000;
+    TEST_ASSERT_EQUAL(12, reenviar(diario, 11, 1));
+    // Corte de luz: el objeto desaparece sin más
+  }
+
+  DiarioTelemetria diario;
+  TEST_ASSERT_TRUE(diario.iniciar(flash));
+  TEST_ASSERT_EQUAL(primerArranque + 1, diario.arranque());
+  TEST_ASSERT_TRUE(diario.hayPendientes());
+  TEST_ASSERT_TRUE(diario.estadisticas().bytesPendientes > 0);
+
+  // Sin huecos ni duplicados: sigue justo tras el último confirmado
+  anotarVarios(diario, 30, 40);
+  TEST_ASSERT_EQUAL(40, reenviar(diario, 12, 100));
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+  TEST_ASSERT_EQUAL(0, diario.estadisticas().bytesPendientes);
+}
+
+void test_checkpoint_espaciado() {
+  fs::FS flash;
+  {
+    DiarioTelemetria diario;
+    diario.iniciar(flash);
+    anotarVarios(diario, 0, 30);
+    relojPruebaUs += DIARIO_CHECKPOINT_MS * 1000;
+    TEST_ASSERT_EQUAL(5, reenviar(diario, 0, 5));
+    // Dentro del mismo intervalo la confirmación queda solo en RAM
+    TEST_ASSERT_EQUAL(20, reenviar(diario, 5, 15));
+  }
+
+  // Tras el corte se repiten los confirmados desde el último checkpoint
+  // (el servidor los reconoce por X-Lote), sin huecos
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  TEST_ASSERT_EQUAL(30, reenviar(diario, 1, 100));
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+void test_diario_vacio_guarda_el_checkpoint() {
+  fs::FS flash;
+  {
+    DiarioTelemetria diario;
+    diario.iniciar(flash);
+    anotarVarios(diario, 0, 10);
+    TEST_ASSERT_EQUAL(10, reenviar(diario, 0, 100));
+  }
+  // Nada que repetir
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  TEST_ASSERT_EQUAL(10, reenviar(diario, 10, 100));
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+static int avisosAbiertos = 0;
+static int operacionesFlash = 0;
+
+static void contarAviso(bool enCurso) {
+  avisosAbiertos += enCurso ? 1 : -1;
+  TEST_ASSERT_TRUE(avisosAbiertos == 0 || avisosAbiertos == 1);
+  operacionesFlash += enCurso;
+}
+
+void test_aviso_de_cada_operacion_en_flash() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.avisarFlash(contarAviso);
+  diario.iniciar(flash);
+  anotarVarios(diario, 0, 3);
+  TEST_ASSERT_EQUAL(4, operacionesFlash);
+  // Leer y confirmar: dos operaciones por registro
+  reenviar(diario, 0, 3);
+  TEST_ASSERT_EQUAL(10, operacionesFlash);
+  TEST_ASSERT_EQUAL(0, avisosAbiertos);
+}
+
+void test_payload_danado_se_salta_solo_ese_registro() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  anotarVarios(diario, 0, 3);
+
+  // Un byte del payload del segundo registro cambia en la flash
+  char ruta[64];
+  snprintf(ruta, sizeof(ruta), "%s/diario/%08lu.seg", flash.raiz().c_str(), 1UL);
+  FILE *f = fopen(ruta, "r+b");
+  TEST_ASSERT_NOT_NULL(f);
+  size_t tamRegistro = 20 + strlen("{\"lote\":0}");
+  fseek(f, tamRegistro + 20 + 3, SEEK_SET);
+  fputc('X', f);
+  fclose(f);
+
+  char leido[64];
+  uint32_t arranque, numero;
+  diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+  TEST_ASSERT_EQUAL(0, numero);
+  diario.confirmar();
+  diario.leerSiguiente(leido, sizeof(leido), arranque, numero);
+  TEST_ASSERT_EQUAL(2, numero);
+  diario.confirmar();
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+  TEST_ASSERT_EQUAL(1, diario.estadisticas().perdidos);
+  TEST_ASSERT_EQUAL(2, diario.estadisticas().reenviados);
+}
+
+void test_registro_a_medias_tras_un_corte() {
+  fs::FS flash;
+  {
+    DiarioTelemetria diario;
+    diario.iniciar(flash);
+    anotarVarios(diario, 0, 3);
+  }
+  // El corte dejó el último registro sin terminar
+  char ruta[64];
+  snprintf(ruta, sizeof(ruta), "%s/diario/%08lu.seg", flash.raiz().c_str(), 1UL);
+  struct stat st;
+  stat(ruta, &st);
+  TEST_ASSERT_EQUAL(0, truncate(ruta, st.st_size - 4));
+
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  anotarVarios(diario, 3, 5);
+  // Lo nuevo va a otro segmento: se pierde solo el registro cortado
+  char leido[64];
+  uint32_t arranque, numero;
+  uint32_t esperados[] = {0, 1, 3, 4};
+  for (uint32_t e : esperados) {
+    TEST_ASSERT_TRUE(diario.leerSiguiente(leido, sizeof(leido), arranque, numero) > 0);
+    TEST_ASSERT_EQUAL(e, numero);
+    diario.confirmar();
+  }
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+void test_sin_espacio_se_pierde_lo_mas_antiguo() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+
+  // Registros de ~1 KB: unos 16 por segmento
+  static char grande[1000];
+  memset(grande, 'x', sizeof(grande));
+  grande[0] = '{';
+  uint32_t total = DIARIO_MAX_SEGMENTOS * 16 + 40;
+  for (uint32_t n = 0; n < total; n++) {
+    TEST_ASSERT_TRUE(diario.anotar(grande, sizeof(grande), n));
+  }
+  EstadisticasDiario stats = diario.estadisticas();
+  TEST_ASSERT_TRUE(stats.perdidos > 0);
+  TEST_ASSERT_TRUE(stats.bytesPendientes <= (uint32_t)DIARIO_MAX_SEGMENTOS * DIARIO_TAM_SEGMENTO);
+
+  // Queda una cola contigua que termina en el último anotado
+  static char leido[1024];
+  uint32_t arranque, numero, anterior = 0, leidos = 0;
+  while (diario.leerSiguiente(leido, sizeof(leido), arranque, numero) > 0) {
+    if (leidos > 0) {
+      TEST_ASSERT_EQUAL(anterior + 1, numero);
+    }
+    anterior = numero;
+    leidos++;
+    diario.confirmar();
+  }
+  TEST_ASSERT_EQUAL(total - 1, anterior);
+  TEST_ASSERT_TRUE(leidos < total);
+}
+
+void test_flash_llena() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  anotarVarios(diario, 0, 2);
+
+  // Solo caben 10 bytes más: el registro queda a medias y se informa
+  flash.limitarEscritura(10);
+  TEST_ASSERT_FALSE(diario.anotar("{\"lote\":2}", 10, 2));
+  TEST_ASSERT_EQUAL(1, diario.estadisticas().perdidos);
+
+  flash.limitarEscritura(1 << 20);
+  anotarVarios(diario, 3, 4);
+  char leido[64];
+  uint32_t arranque, numero;
+  uint32_t esperados[] = {0, 1, 3};
+  for (uint32_t e : esperados) {
+    TEST_ASSERT_TRUE(diario.leerSiguiente(leido, sizeof(leido), arranque, numero) > 0);
+    TEST_ASSERT_EQUAL(e, numero);
+    diario.confirmar();
+  }
+  TEST_ASSERT_FALSE(diario.hayPendientes());
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_anotar_y_reenviar_en_orden);
+  RUN_TEST(test_leer_sin_confirmar_repite_el_registro);
+  RUN_TEST(test_reinicio_sigue_desde_el_checkpoint);
+  RUN_TEST(test_checkpoint_espaciado);
+  RUN_TEST(test_diario_vacio_guarda_el_checkpoint);
+  RUN_TEST(test_aviso_de_cada_operacion_en_flash);
+  RUN_TEST(test_payload_danado_se_salta_solo_ese_registro);
+  RUN_TEST(test_registro_a_medias_tras_un_corte);
+  RUN_TEST(test_sin_espacio_se_pierde_lo_mas_antiguo);
+  RUN_TEST(test_flash_llena);
+  return UNITY_END();
+}
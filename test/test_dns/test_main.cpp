@@ -0,0 +1,264 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <lwip/sockets.h>
+#include "dns_portal.h"
+
+static const IPAddress IP_PORTAL(192, 168, 4, 1);
+static const uint16_t TIPO_A = 1;
+static const uint16_t TIPO_AAAA = 28;
+
+static uint8_t registro[DNS_TAM_REGISTRO_A];
+
+// Consulta estándar con RD y una pregunta; con "edns" añade un registro OPT
+static size_t armarConsulta(uint8_t *p, uint16_t id, const char *nombre, uint16_t tipo, bool edns = false) {
+  const uint8_t cabecera[12] = {(uint8_t)(id >> 8), (uint8_t)id, 0x01, 0x00, 0, 1, 0, 0, 0, 0, 0, (uint8_t)(edns ? 1 : 0)};
+  memcpy(p, cabecera, sizeof(cabecera));
+  size_t n = sizeof(cabecera);
+  while (*nombre) {
+    const char *punto = strchr(nombre, '.');
+    size_t etiqueta = punto ? (size_t)(punto - nombre) : strlen(nombre);
+    p[n++] = etiqueta;
+    memcpy(p + n, nombre, etiqueta);
+    n += etiqueta;
+    nombre += etiqueta + (punto ? 1 : 0);
+  }
+  p[n++] = 0;
+  p[n++] = tipo >> 8;
+  p[n++] = tipo & 0xFF;
+  p[n++] = 0;
+  p[n++] = 1;
+  if (edns) {
+    const uint8_t opt[11] = {0, 0, 41, 0x10, 0x00, 0, 0, 0, 0, 0, 0};
+    memcpy(p + n, opt, sizeof(opt));
+    n += sizeof(opt);
+  }
+  return n;
+}
+
+static uint16_t leer16(const uint8_t *p) {
+  return (p[0] << 8) | p[1];
+}
+
+void setUp() {
+  prepararRegistroDns(registro, IP_PORTAL, DNS_TTL_S);
+}
+
+void tearDown() {}
+
+static void test_registro_preparado() {
+  const uint8_t esperado[DNS_TAM_REGISTRO_A] = {0xC0, 0x0C, 0, 1, 0, 1, 0, 0, 0, DNS_TTL_S, 0, 4, 192, 168, 4, 1};
+  TEST_ASSERT_EQUAL_MEMORY(esperado, registro, sizeof(esperado));
+}
+
+static void test_consulta_a() {
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  size_t n = armarConsulta(consulta, 0xBEEF, "connectivitycheck.gstatic.com", TIPO_A);
+  bool esTipoA;
+  size_t longitud = armarRespuestaDns(consulta, n, respuesta, sizeof(respuesta), registro, esTipoA);
+
+  TEST_ASSERT_TRUE(esTipoA);
+  TEST_ASSERT_EQUAL(n + DNS_TAM_REGISTRO_A, longitud);
+  TEST_ASSERT_EQUAL(0xBEEF, leer16(respuesta));
+  TEST_ASSERT_EQUAL(0x8580, leer16(respuesta + 2));  // QR, AA, RD, RA, NOERROR
+  TEST_ASSERT_EQUAL(1, leer16(respuesta + 4));
+  TEST_ASSERT_EQUAL(1, leer16(respuesta + 6));
+  TEST_ASSERT_EQUAL(0, leer16(respuesta + 10));
+  TEST_ASSERT_EQUAL_MEMORY(consulta + 12, respuesta + 12, n - 12);
+  TEST_ASSERT_EQUAL_MEMORY(registro, respuesta + n, DNS_TAM_REGISTRO_A);
+}
+
+static void test_aaaa_sin_respuestas() {
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  size_t n = armarConsulta(consulta, 7, "captive.apple.com", TIPO_AAAA);
+  bool esTipoA = true;
+  size_t longitud = armarRespuestaDns(consulta, n, respuesta, sizeof(respuesta), registro, esTipoA);
+
+  TEST_ASSERT_FALSE(esTipoA);
+  TEST_ASSERT_EQUAL(n, longitud);
+  TEST_ASSERT_EQUAL(0x8580, leer16(respuesta + 2));
+  TEST_ASSERT_EQUAL(0, leer16(respuesta + 6));
+}
+
+static void test_edns_descartado() {
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  size_t sinEdns = armarConsulta(consulta, 1, "example.com", TIPO_A);
+  size_t n = armarConsulta(consulta, 1, "example.com", TIPO_A, true);
+  TEST_ASSERT_EQUAL(sinEdns + 11, n);
+
+  bool esTipoA;
+  size_t longitud = armarRespuestaDns(consulta, n, respuesta, sizeof(respuesta), registro, esTipoA);
+  TEST_ASSERT_TRUE(esTipoA);
+  TEST_ASSERT_EQUAL(sinEdns + DNS_TAM_REGISTRO_A, longitud);
+  TEST_ASSERT_EQUAL(0, leer16(respuesta + 10));  // Sin registros adicionales
+  TEST_ASSERT_EQUAL_MEMORY(registro, respuesta + sinEdns, DNS_TAM_REGISTRO_A);
+}
+
+static void test_mal_formadas() {
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  bool esTipoA;
+  size_t n = armarConsulta(consulta, 1, "example.com", TIPO_A);
+
+  // Más corta que la cabecera
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(consulta, 11, respuesta, sizeof(respuesta), registro, esTipoA));
+  // Pregunta cortada (sin tipo y clase completos)
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(consulta, n - 1, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // Es una respuesta (QR = 1)
+  uint8_t copia[DNS_TAM_MAXIMO];
+  memcpy(copia, consulta, n);
+  copia[2] |= 0x80;
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(copia, n, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // OPCODE distinto de consulta estándar
+  memcpy(copia, consulta, n);
+  copia[2] |= 0x10;
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(copia, n, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // Dos preguntas
+  memcpy(copia, consulta, n);
+  copia[5] = 2;
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(copia, n, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // Nombre comprimido: no se acepta en la pregunta
+  memcpy(copia, consulta, n);
+  copia[12] = 0xC0;
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(copia, n, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // Etiqueta que se sale del paquete
+  memcpy(copia, consulta, n);
+  copia[12] = 60;
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(copia, n, respuesta, sizeof(respuesta), registro, esTipoA));
+
+  // La respuesta no cabe en el destino
+  TEST_ASSERT_EQUAL(0, armarRespuestaDns(consulta, n, respuesta, n + DNS_TAM_REGISTRO_A - 1, registro, esTipoA));
+  TEST_ASSERT_EQUAL(n + DNS_TAM_REGISTRO_A,
+                    armarRespuestaDns(consulta, n, respuesta, n + DNS_TAM_REGISTRO_A, registro, esTipoA));
+}
+
+// Cliente UDP simulado contra el responder real, en localhost
+static int cliente = -1;
+static sockaddr_in servidor = {};
+
+static void conectar() {
+  if (cliente >= 0) {
+    return;
+  }
+  uint16_t puerto = 15353;
+  while (!iniciarDnsPortal(IP_PORTAL, puerto)) {
+    TEST_ASSERT_LESS_THAN(15400, ++puerto);
+  }
+  cliente = socket(AF_INET, SOCK_DGRAM, 0);
+  TEST_ASSERT_GREATER_OR_EQUAL(0, cliente);
+  timeval espera = {1, 0};
+  setsockopt(cliente, SOL_SOCKET, SO_RCVTIMEO, &espera, sizeof(espera));
+  servidor.sin_family = AF_INET;
+  servidor.sin_port = htons(puerto);
+  servidor.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+static void enviar(uint16_t id, uint16_t tipo) {
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  size_t n = armarConsulta(consulta, id, "www.msftconnecttest.com", tipo, id % 3 == 0);
+  TEST_ASSERT_EQUAL(n, sendto(cliente, consulta, n, 0, (sockaddr *)&servidor, sizeof(servidor)));
+}
+
+// Devuelve el id de la respuesta, o -1 si no llega
+static int recibir(uint16_t &respuestas) {
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  ssize_t n = recv(cliente, respuesta, sizeof(respuesta), 0);
+  if (n < 12) {
+    return -1;
+  }
+  respuestas = leer16(respuesta + 6);
+  return leer16(respuesta);
+}
+
+static void test_udp_vacia_la_cola_por_tick() {
+  conectar();
+  EstadisticasDns antes = leerEstadisticasDns();
+  const uint16_t ENVIADAS = DNS_MAX_POR_TICK + 4;
+  for (uint16_t i = 0; i < ENVIADAS; i++) {
+    enviar(i, i % 2 ? TIPO_AAAA : TIPO_A);
+  }
+  // Un paquete basura se cuenta y se descarta sin cortar la ronda
+  const uint8_t basura[5] = {1, 2, 3, 4, 5};
+  sendto(cliente, basura, sizeof(basura), 0, (sockaddr *)&servidor, sizeof(servidor));
+
+  atenderDnsPortal();
+  EstadisticasDns medio = leerEstadisticasDns();
+  TEST_ASSERT_EQUAL(DNS_MAX_POR_TICK, medio.consultas - antes.consultas);
+  atenderDnsPortal();
+
+  for (uint16_t i = 0; i < ENVIADAS; i++) {
+    uint16_t respuestas;
+    TEST_ASSERT_EQUAL(i, recibir(respuestas));
+    TEST_ASSERT_EQUAL(i % 2 ? 0 : 1, respuestas);
+  }
+  EstadisticasDns despues = leerEstadisticasDns();
+  TEST_ASSERT_EQUAL(ENVIADAS + 1, despues.consultas - antes.consultas);
+  TEST_ASSERT_EQUAL(ENVIADAS / 2, despues.respuestasA - antes.respuestasA);
+  TEST_ASSERT_EQUAL(ENVIADAS / 2, despues.respuestasVacias - antes.respuestasVacias);
+  TEST_ASSERT_EQUAL(1, despues.descartadas - antes.descartadas);
+}
+
+// Respuestas por segundo con ráfagas de DNS_MAX_POR_TICK consultas por
+// llamada. Incluye el coste del cliente y de la pila del PC: sirve para
+// comparar, no como cifra del ESP32.
+static void test_udp_respuestas_por_segundo() {
+  conectar();
+  const uint32_t RONDAS = 2000;
+  uint32_t respondidas = 0;
+  auto inicio = std::chrono::steady_clock::now();
+  for (uint32_t r = 0; r < RONDAS; r++) {
+    for (uint16_t i = 0; i < DNS_MAX_POR_TICK; i++) {
+      enviar(i, i % 4 ? TIPO_A : TIPO_AAAA);
+    }
+    atenderDnsPortal();
+    for (uint16_t i = 0; i < DNS_MAX_POR_TICK; i++) {
+      uint16_t respuestas;
+      respondidas += recibir(respuestas) == i;
+    }
+  }
+  double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+  TEST_ASSERT_EQUAL(RONDAS * DNS_MAX_POR_TICK, respondidas);
+
+  // Solo armarRespuestaDns, sin sockets
+  uint8_t consulta[DNS_TAM_MAXIMO];
+  uint8_t respuesta[DNS_TAM_MAXIMO];
+  size_t n = armarConsulta(consulta, 1, "www.msftconnecttest.com", TIPO_A, true);
+  const uint32_t VUELTAS = 1000000;
+  volatile size_t total = 0;
+  inicio = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < VUELTAS; i++) {
+    bool esTipoA;
+    consulta[1] = i;
+    total += armarRespuestaDns(consulta, n, respuesta, sizeof(respuesta), registro, esTipoA);
+  }
+  double nsArmado = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  char mensaje[128];
+  snprintf(mensaje, sizeof(mensaje), "UDP en localhost: %.0f respuestas/s; armado de la respuesta: %.1f ns",
+           respondidas / segundos, nsArmado);
+  TEST_MESSAGE(mensaje);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_registro_preparado);
+  RUN_TEST(test_consulta_a);
+  RUN_TEST(test_aaaa_sin_respuestas);
+  RUN_TEST(test_edns_descartado);
+  RUN_TEST(test_mal_formadas);
+  RUN_TEST(test_udp_vacia_la_cola_por_tick);
+  RUN_TEST(test_udp_respuestas_por_segundo);
+  int resultado = UNITY_END();
+  if (cliente >= 0) {
+    close(cliente);
+  }
+  return resultado;
+}
@@ -0,0 +1,308 @@
+#include <unity.h>
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include "escritor_buffer.h"
+#include "pagina_anterior.h"
+
+// Contabilidad del heap de todo el programa: cuántas reservas hay, cuánto
+// está vivo y el máximo alcanzado
+static size_t reservas = 0;
+static size_t vivos = 0;
+static size_t pico = 0;
+
+// Cabecera con el tamaño pedido, alineada como malloc
+static const size_t TAM_CABECERA = alignof(max_align_t);
+
+void *operator new(size_t tam) {
+  char *p = (char *)malloc(tam + TAM_CABECERA);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  *(size_t *)p = tam;
+  reservas++;
+  vivos += tam;
+  pico = max(pico, vivos);
+  return p + TAM_CABECERA;
+}
+
+void operator delete(void *p) noexcept {
+  if (!p) {
+    return;
+  }
+  char *bloque = (char *)p - TAM_CABECERA;
+  vivos -= *(size_t *)bloque;
+  free(bloque);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+static void medirDesdeAqui() {
+  reservas = 0;
+  pico = vivos;
+}
+
+// La misma página con el escritor
+static bool paginaConEscritor(EscritorBuffer &html, const Lectura &l) {
+  html.agregar("<!DOCTYPE html><html><head>");
+  html.agregar("<meta charset='UTF-8'>");
+  html.agregar("<meta name='viewport' content='width=device-width, initial-scale=1'>");
+  html.agregar("<title>ESP32 - Sistema de Sensores</title>");
+  html.agregar("<style>");
+  html.agregar("body { font-family: Arial, sans-serif; margin: 0; padding: 20px; background: #f0f0f0; }");
+  html.agregar(".container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 0 10px rgba(0,0,0,0.1); }");
+  html.agregar("h1 { color: #333; text-align: center; }");
+  html.agregar(".sensor-data { background: #e9ecef; padding: 15px; margin: 10px 0; border-radius: 5px; }");
+  html.agregar(".refresh-btn { background: #007bff; color: white; padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; margin: 10px 0; }");
+  html.agregar(".refresh-btn:hover { background: #0056b3; }");
+  html.agregar("</style>");
+  html.agregar("<script>");
+  html.agregar("function autoRefresh() { setTimeout(function(){ location.reload(); }, 2000); }");
+  html.agregar("</script>");
+  html.agregar("</head><body onload='autoRefresh()'>");
+  html.agregar("<div class='container'>");
+  html.agregar("<h1>ESP32 - Sistema de Sensores</h1>");
+
+  html.agregar("<div class='sensor-data'>");
+  html.agregar("<h3>Contador de Cajas</h3>");
+  html.agregar("<p><strong>Total detectado: ").agregarSinSigno(l.cajas).agregar("</strong></p>");
+  html.agregar("</div>");
+
+  html.agregar("<div class='sensor-data'>");
+  html.agregar("<h3>Sensor AS5600 (Magnético)</h3>");
+  if (l.conectado) {
+    float grados = l.angulo * 0.087890625;
+    html.agregar("<p>Ángulo: <strong>").agregarSinSigno(l.angulo).agregar("</strong> (RAW)</p>");
+    html.agregar("<p>Grados: <strong>").agregarFijo(grados, 1).agregar("°</strong></p>");
+    html.agregar("<p>Estado: <span style='color: green;'>Conectado</span></p>");
+  } else {
+    html.agregar("<p>Estado: <span style='color: red;'>No conectado</span></p>");
+  }
+  html.agregar("</div>");
+
+  html.agregar("<div class='sensor-data'>");
+  html.agregar("<h3>Sensor E18-D80NK (Proximidad)</h3>");
+  html.agregar("<p>Estado: <strong>").agregar(l.libre ? "LIBRE" : "OBSTÁCULO DETECTADO").agregar("</strong></p>");
+  html.agregar("<p>Color: <span style='color: ").agregar(l.libre ? "green" : "red").agregar(";'>●</span></p>");
+  html.agregar("</div>");
+
+  html.agregar("<button class='refresh-btn' onclick='location.reload()'>Actualizar</button>");
+  html.agregar("<p style='text-align: center; color: #666; font-size: 12px;'>Actualización automática cada 2 segundos</p>");
+  html.agregar("</div></body></html>");
+  return html.vaciar() && !html.desbordado();
+}
+
+// Destino de los trozos: un buffer fijo para no tocar el heap
+struct Recepcion {
+  char datos[4096];
+  size_t longitud;
+  size_t trozos;
+  size_t mayorTrozo;
+  size_t fallarEnTrozo;  // 0: nunca
+};
+
+static bool recibirTrozo(void *contexto, const char *datos, size_t longitud) {
+  Recepcion &r = *(Recepcion *)contexto;
+  if (++r.trozos == r.fallarEnTrozo || r.longitud + longitud > sizeof(r.datos)) {
+    return false;
+  }
+  memcpy(r.datos + r.longitud, datos, longitud);
+  r.longitud += longitud;
+  r.mayorTrozo = max(r.mayorTrozo, longitud);
+  return true;
+}
+
+static char pagina[4096];
+
+void setUp() {}
+void tearDown() {}
+
+static void test_mismo_texto_que_string() {
+  CadenaArduino esperada = paginaConString(LECTURA);
+  EscritorBuffer html(pagina, sizeof(pagina));
+  TEST_ASSERT_TRUE(paginaConEscritor(html, LECTURA));
+  TEST_ASSERT_EQUAL_STRING(esperada.c_str(), html.c_str());
+
+  Lectura otra = {0, 4095, false, true};
+  CadenaArduino otraEsperada = paginaConString(otra);
+  html.reiniciar();
+  TEST_ASSERT_TRUE(paginaConEscritor(html, otra));
+  TEST_ASSERT_EQUAL_STRING(otraEsperada.c_str(), html.c_str());
+}
+
+static void test_por_trozos_igual_que_entero() {
+  EscritorBuffer entero(pagina, sizeof(pagina));
+  TEST_ASSERT_TRUE(paginaConEscritor(entero, LECTURA));
+
+  // Ventanas desde 2 bytes (1 útil) hasta más grandes que la página
+  const size_t ventanas[] = {2, 3, 7, 64, 512, sizeof(pagina)};
+  for (size_t ventana : ventanas) {
+    static Recepcion r;
+    r = {};
+    char trozo[sizeof(pagina)];
+    EscritorBuffer html(trozo, ventana, recibirTrozo, &r);
+    TEST_ASSERT_TRUE(paginaConEscritor(html, LECTURA));
+    TEST_ASSERT_EQUAL(entero.longitud(), r.longitud);
+    TEST_ASSERT_EQUAL_MEMORY(entero.c_str(), r.datos, r.longitud);
+    TEST_ASSERT_LESS_OR_EQUAL(ventana - 1, r.mayorTrozo);
+    TEST_ASSERT_EQUAL(0, html.longitud());
+  }
+}
+
+static void test_fallo_de_entrega() {
+  static Recepcion r;
+  r = {};
+  r.fallarEnTrozo = 3;
+  char trozo[64];
+  EscritorBuffer html(trozo, sizeof(trozo), recibirTrozo, &r);
+  TEST_ASSERT_FALSE(paginaConEscritor(html, LECTURA));
+  TEST_ASSERT_TRUE(html.desbordado());
+  // Lo entregado son los dos trozos completos anteriores al fallo
+  TEST_ASSERT_EQUAL(2 * (sizeof(trozo) - 1), r.longitud);
+
+  // Tras el fallo no se vuelve a llamar a la entrega
+  size_t trozos = r.trozos;
+  html.agregar("más texto");
+  TEST_ASSERT_FALSE(html.vaciar());
+  TEST_ASSERT_EQUAL(trozos, r.trozos);
+}
+
+static void test_desborde_sin_vaciado() {
+  char buffer[4];
+  EscritorBuffer texto(buffer, sizeof(buffer));
+  texto.agregar("ab");
+  TEST_ASSERT_FALSE(texto.desbordado());
+  texto.agregar("cdef");
+  TEST_ASSERT_TRUE(texto.desbordado());
+  TEST_ASSERT_EQUAL_STRING("abc", texto.c_str());
+  TEST_ASSERT_EQUAL(3, texto.longitud());
+
+  texto.reiniciar();
+  TEST_ASSERT_FALSE(texto.desbordado());
+  texto.agregarEntero(-12);
+  TEST_ASSERT_EQUAL_STRING("-12", texto.c_str());
+}
+
+static void test_enteros() {
+  char buffer[64];
+  EscritorBuffer texto(buffer, sizeof(buffer));
+  texto.agregarSinSigno(0).agregar(' ').agregarSinSigno(UINT32_MAX).agregar(' ');
+  texto.agregarEntero(INT32_MIN).agregar(' ').agregarEntero(INT32_MAX);
+  TEST_ASSERT_EQUAL_STRING("0 4294967295 -2147483648 2147483647", texto.c_str());
+}
+
+static void test_coma_fija() {
+  struct Caso {
+    float valor;
+    uint8_t decimales;
+    const char *esperado;
+  };
+  const Caso casos[] = {
+    {12.345f, 1, "12.3"},
+    {0.05f, 1, "0.1"},
+    {-1.25f, 2, "-1.25"},
+    {3.0f, 0, "3"},
+    {0.001f, 3, "0.001"},
+    {359.9f, 1, "359.9"},
+    {1.5f, 9, "1.500000"},  // Más de 6 decimales se limita a 6
+  };
+  for (const Caso &c : casos) {
+    char buffer[32];
+    EscritorBuffer texto(buffer, sizeof(buffer));
+    texto.agregarFijo(c.valor, c.decimales);
+    TEST_ASSERT_EQUAL_STRING(c.esperado, texto.c_str());
+  }
+}
+
+static void test_coma_fija_fuera_de_rango() {
+  struct Caso {
+    float valor;
+    uint8_t decimales;
+    const char *esperado;
+  };
+  const Caso casos[] = {
+    {NAN, 2, "nan"},
+    {INFINITY, 1, "inf"},
+    {-INFINITY, 1, "-inf"},
+    {1000.5f, 4, "1000.5000"},      // Aún cabe con todos los decimales
+    {1e9f, 3, "1000000000"},        // Solo cabe sin decimales
+    {4e8f, 2, "400000000.0"},       // Cabe con uno
+    {5e9f, 1, "4294967295"},        // No cabe: se satura
+    {-3e38f, 0, "-4294967295"},
+  };
+  for (const Caso &c : casos) {
+    char buffer[32];
+    EscritorBuffer texto(buffer, sizeof(buffer));
+    texto.agregarFijo(c.valor, c.decimales);
+    TEST_ASSERT_EQUAL_STRING(c.esperado, texto.c_str());
+  }
+}
+
+// Reservas, pico de heap y tiempo por página de cada camino. Los tiempos son
+// del PC: valen para comparar, no como cifra del ESP32.
+static void test_rendimiento() {
+  const int VUELTAS = 2000;
+  char mensaje[160];
+
+  medirDesdeAqui();
+  size_t base = vivos;
+  size_t longitud = paginaConString(LECTURA).length();
+  size_t reservasString = reservas;
+  size_t picoString = pico - base;
+  auto inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < VUELTAS; i++) {
+    CadenaArduino html = paginaConString(LECTURA);
+    TEST_ASSERT_EQUAL(longitud, html.length());
+  }
+  double usString = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  medirDesdeAqui();
+  EscritorBuffer html(pagina, sizeof(pagina));
+  TEST_ASSERT_TRUE(paginaConEscritor(html, LECTURA));
+  TEST_ASSERT_EQUAL(0, reservas);
+  TEST_ASSERT_EQUAL(base, pico);
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < VUELTAS; i++) {
+    html.reiniciar();
+    paginaConEscritor(html, LECTURA);
+  }
+  double usEscritor = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  static Recepcion r;
+  char trozo[512];
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < VUELTAS; i++) {
+    r = {};
+    EscritorBuffer porTrozos(trozo, sizeof(trozo), recibirTrozo, &r);
+    paginaConEscritor(porTrozos, LECTURA);
+  }
+  double usTrozos = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+  TEST_ASSERT_EQUAL(0, reservas);
+
+  snprintf(mensaje, sizeof(mensaje), "Página de %u bytes", (unsigned)longitud);
+  TEST_MESSAGE(mensaje);
+  snprintf(mensaje, sizeof(mensaje), "String:           %u reservas, pico %u bytes de heap, %.2f us",
+           (unsigned)reservasString, (unsigned)picoString, usString);
+  TEST_MESSAGE(mensaje);
+  snprintf(mensaje, sizeof(mensaje), "Escritor 4096 B:  0 reservas, pico 0 bytes de heap, %.2f us", usEscritor);
+  TEST_MESSAGE(mensaje);
+  snprintf(mensaje, sizeof(mensaje), "Escritor 512 B:   0 reservas, pico 0 bytes de heap, %.2f us", usTrozos);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_GREATER_THAN(30, reservasString);
+  TEST_ASSERT_GREATER_THAN(longitud, picoString);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_mismo_texto_que_string);
+  RUN_TEST(test_por_trozos_igual_que_entero);
+  RUN_TEST(test_fallo_de_entrega);
+  RUN_TEST(test_desborde_sin_vaciado);
+  RUN_TEST(test_enteros);
+  RUN_TEST(test_coma_fija);
+  RUN_TEST(test_coma_fija_fuera_de_rango);
+  RUN_TEST(test_rendimiento);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <unity.h>
+#include <stdio.h>
+#include "historial.h"
+
+// El historial es global: cada prueba empieza en un segundo nuevo, lejos
+// de la anterior, y cierra su punto con una muestra del periodo siguiente
+static uint32_t inicioMs = 10000;
+
+struct Leido {
+  int cmin, cmax, cmed, amin, amax, amed, vmin, vmax, vmed;
+  int nulos;   // Puntos vacíos al final, tras el último con datos
+};
+
+// Último punto con datos del nivel y los vacíos que le siguen
+static Leido ultimoPunto(uint8_t nivel) {
+  static char texto[8192];
+  EscritorBuffer json(texto, sizeof(texto));
+  TEST_ASSERT_TRUE(escribirHistorial(json, nivel, inicioMs));
+
+  Leido l = {};
+  const char *p = strrchr(texto, '[');
+  TEST_ASSERT_NOT_NULL(p);
+  TEST_ASSERT_EQUAL(9, sscanf(p, "[%d,%d,%d,%d,%d,%d,%d,%d,%d]", &l.cmin, &l.cmax, &l.cmed,
+                              &l.amin, &l.amax, &l.amed, &l.vmin, &l.vmax, &l.vmed));
+  for (const char *c = strchr(p, ']'); (c = strstr(c, "null")); c++) {
+    l.nulos++;
+  }
+  return l;
+}
+
+// Muestras cada 100 ms dentro de un mismo segundo
+static void segundo(const uint16_t *angulos, size_t n, uint32_t cajas = 0) {
+  for (size_t i = 0; i < n; i++) {
+    agregarHistorial(inicioMs + i * 100, cajas + i, angulos[i], 0);
+  }
+  inicioMs += 1000;
+}
+
+void setUp() {
+  iniciarHistorial();
+  inicioMs += 60000;
+}
+
+void tearDown() {}
+
+static void test_media_sin_vuelta() {
+  const uint16_t angulos[] = {100, 200, 300};
+  segundo(angulos, 3, 7);
+  agregarHistorial(inicioMs, 10, 0, 0);
+  Leido l = ultimoPunto(0);
+  TEST_ASSERT_EQUAL(100, l.amin);
+  TEST_ASSERT_EQUAL(300, l.amax);
+  TEST_ASSERT_EQUAL(200, l.amed);
+  TEST_ASSERT_EQUAL(7, l.cmin);
+  TEST_ASSERT_EQUAL(9, l.cmax);
+}
+
+static void test_media_cruzando_cero() {
+  // La media de las cuentas en bruto sería 2048
+  const uint16_t angulos[] = {4090, 4094, 2, 6};
+  segundo(angulos, 4);
+  agregarHistorial(inicioMs, 0, 0, 0);
+  TEST_ASSERT_EQUAL(0, ultimoPunto(0).amed);
+}
+
+static void test_media_hacia_atras() {
+  const uint16_t angulos[] = {5, 1, 4093};
+  segundo(angulos, 3);
+  agregarHistorial(inicioMs, 0, 0, 0);
+  TEST_ASSERT_EQUAL(1, ultimoPunto(0).amed);
+}
+
+static void test_media_varias_vueltas() {
+  // Giro constante de 1000 cuentas por muestra: casi 2,5 vueltas en el
+  // segundo; la media es la posición a mitad de camino
+  const uint16_t angulos[] = {0, 1000, 2000, 3000, 4000, 904, 1904, 2904, 3904, 808};
+  segundo(angulos, 10);
+  agregarHistorial(inicioMs, 0, 0, 0);
+  TEST_ASSERT_EQUAL(4500 % 4096, ultimoPunto(0).amed);
+}
+
+static void test_media_minuto_en_cero() {
+  // Eje quieto en 0 con una cuenta de ruido durante un minuto entero
+  inicioMs = (inicioMs / 60000 + 1) * 60000;
+  for (uint32_t i = 0; i < 600; i++) {
+    agregarHistorial(inicioMs + i * 100, 0, i % 2 ? 1 : 4095, 0);
+  }
+  inicioMs += 60000;
+  agregarHistorial(inicioMs, 0, 0, 0);
+  Leido l = ultimoPunto(1);
+  TEST_ASSERT_EQUAL(0, l.amed);
+  TEST_ASSERT_EQUAL(1, l.amin);
+  TEST_ASSERT_EQUAL(4095, l.amax);
+}
+
+static void test_huecos_vacios() {
+  const uint16_t angulos[] = {50};
+  segundo(angulos, 1);
+  // Tres segundos sin muestras
+  inicioMs += 3000;
+  agregarHistorial(inicioMs, 0, 0, 0);
+  Leido l = ultimoPunto(0);
+  TEST_ASSERT_EQUAL(50, l.amed);
+  TEST_ASSERT_EQUAL(3, l.nulos);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_media_sin_vuelta);
+  RUN_TEST(test_media_cruzando_cero);
+  RUN_TEST(test_media_hacia_atras);
+  RUN_TEST(test_media_varias_vueltas);
+  RUN_TEST(test_media_minuto_en_cero);
+  RUN_TEST(test_huecos_vacios);
+  return UNITY_END();
+}
@@ -0,0 +1,302 @@
+#include <unity.h>
+#include <FS.h>
+#include <string>
+#include <vector>
+#include "enlace_http.h"
+#include "lote_telemetria.h"
+
+// Servidor simulado: recibe los lotes por el despacho del enlace y los
+// descompone en puntos como haría el servidor real
+struct PuntoRecibido {
+  uint32_t tiempoMs;
+  uint32_t angulo;
+  uint32_t conteo;
+  uint32_t lote;
+};
+
+static std::vector<PuntoRecibido> recibidos;
+static uint32_t lotesRecibidos = 0;
+
+// Lee la columna "clave":[a,b,...] de un JSON de lote
+static std::vector<uint32_t> columna(const std::string &json, const char *clave) {
+  std::vector<uint32_t> valores;
+  std::string buscada = std::string("\"") + clave + "\":[";
+  size_t p = json.find(buscada);
+  if (p == std::string::npos) {
+    return valores;
+  }
+  const char *c = json.c_str() + p + buscada.size();
+  while (*c != ']') {
+    char *fin;
+    valores.push_back(strtoul(c, &fin, 10));
+    c = *fin == ',' ? fin + 1 : fin;
+  }
+  return valores;
+}
+
+static uint32_t campo(const std::string &json, const char *clave) {
+  std::string buscada = std::string("\"") + clave + "\":";
+  size_t p = json.find(buscada);
+  return p == std::string::npos ? 0 : strtoul(json.c_str() + p + buscada.size(), nullptr, 10);
+}
+
+static int servidorJson(void *, const char *datos, size_t longitud, uint32_t, uint32_t numero) {
+  std::string json(datos, longitud);
+  if (json.front() != '{' || json.back() != '}') {
+    return 400;
+  }
+  uint32_t t0 = campo(json, "t0");
+  std::vector<uint32_t> t = columna(json, "t");
+  std::vector<uint32_t> angulos = columna(json, "angulo");
+  std::vector<uint32_t> conteos = columna(json, "conteo_cajas");
+  if (t.size() != angulos.size() || t.size() != conteos.size()) {
+    return 400;
+  }
+  for (size_t i = 0; i < t.size(); i++) {
+    recibidos.push_back({t0 + t[i], angulos[i], conteos[i], numero});
+  }
+  lotesRecibidos++;
+  return 200;
+}
+
+static LoteTelemetria lote;
+
+void setUp() {
+  relojPruebaUs = 1000000;
+  recibidos.clear();
+  lotesRecibidos = 0;
+  lote.vaciar();
+}
+
+void tearDown() {}
+
+static Muestra muestra(uint16_t angulo, uint32_t conteo, bool conectado = true) {
+  Muestra m = {};
+  m.tiempoUs = micros();
+  m.angulo = angulo;
+  m.conteo = conteo;
+  m.conectado = conectado;
+  return m;
+}
+
+void test_se_llena_por_tamano() {
+  for (uint32_t i = 0; i < LOTE_MAX_PUNTOS; i++) {
+    TEST_ASSERT_FALSE(lote.listoParaEnviar(millis()));
+    TEST_ASSERT_TRUE(lote.agregar(muestra(i, i)));
+    relojPruebaUs += LOTE_INTERVALO_MS * 1000;
+  }
+  TEST_ASSERT_TRUE(lote.listoParaEnviar(millis()));
+  TEST_ASSERT_EQUAL(LOTE_MAX_PUNTOS, lote.cantidad());
+
+  // Lleno: el punto siguiente se pierde y se cuenta
+  TEST_ASSERT_FALSE(lote.agregar(muestra(0, 0)));
+  TEST_ASSERT_EQUAL(1, lote.perdidos());
+}
+
+void test_se_envia_por_edad() {
+  lote.agregar(muestra(10, 1));
+  relojPruebaUs += LOTE_INTERVALO_MS * 1000;
+  lote.agregar(muestra(20, 2));
+  TEST_ASSERT_FALSE(lote.listoParaEnviar(millis()));
+
+  relojPruebaUs += (LOTE_MAX_EDAD_MS - LOTE_INTERVALO_MS - 1) * 1000;
+  TEST_ASSERT_FALSE(lote.listoParaEnviar(millis()));
+  relojPruebaUs += 1000;
+  TEST_ASSERT_TRUE(lote.listoParaEnviar(millis()));
+}
+
+void test_un_punto_por_intervalo() {
+  // Muestras a 1 kHz: solo se guarda una cada LOTE_INTERVALO_MS
+  for (uint32_t i = 0; i < 1000; i++) {
+    lote.agregar(muestra(i % 4096, i));
+    relojPruebaUs += 1000;
+  }
+  TEST_ASSERT_EQUAL(1000 / LOTE_INTERVALO_MS, lote.cantidad());
+  for (size_t i = 1; i < lote.cantidad(); i++) {
+    TEST_ASSERT_EQUAL(LOTE_INTERVALO_MS, lote.punto(i).tiempoMs - lote.punto(i - 1).tiempoMs);
+  }
+}
+
+void test_sensor_desconectado_envia_cero() {
+  lote.agregar(muestra(1234, 5, false));
+  TEST_ASSERT_EQUAL(0, lote.punto(0).angulo);
+  TEST_ASSERT_EQUAL(5, lote.punto(0).conteo);
+}
+
+// Varios lotes completos por el enlace: el servidor recibe todos los puntos,
+// con su contenido y en orden
+void test_lotes_llegan_completos_y_en_orden() {
+  fs::FS flash;
+  DiarioTelemetria diario;
+  diario.iniciar(flash);
+  static char bufferReenvio[ENLACE_TAM_PAYLOAD];
+  DespachoEnlace enlace(diario, bufferReenvio, sizeof(bufferReenvio), servidorJson, nullptr);
+
+  static char payload[ENLACE_TAM_PAYLOAD];
+  const uint32_t total = 3 * LOTE_MAX_PUNTOS + 17;
+  uint32_t numeroLote = 0;
+  for (uint32_t i = 0; i < total; i++) {
+    lote.agregar(muestra((i * 37) % 4096, i / 3));
+    relojPruebaUs += LOTE_INTERVALO_MS * 1000;
+    bool ultimo = i == total - 1;
+    if (lote.listoParaEnviar(millis()) || ultimo) {
+      EscritorBuffer json(payload, sizeof(payload));
+      TEST_ASSERT_TRUE(lote.serializar(json, millis()));
+      enlace.despachar(json.c_str(), json.longitud(), numeroLote++, true);
+      lote.vaciar();
+    }
+  }
+
+  TEST_ASSERT_EQUAL(4, lotesRecibidos);
+  TEST_ASSERT_EQUAL(total, recibidos.size());
+  TEST_ASSERT_EQUAL(4, enlace.estadisticas().enviados);
+  for (uint32_t i = 0; i < total; i++) {
+    TEST_ASSERT_EQUAL((i * 37) % 4096, recibidos[i].angulo);
+    TEST_ASSERT_EQUAL(i / 3, recibidos[i].conteo);
+    TEST_ASSERT_EQUAL(i / LOTE_MAX_PUNTOS, recibidos[i].lote);
+    if (i > 0) {
+      TEST_ASSERT_EQUAL(recibidos[i - 1].tiempoMs + LOTE_INTERVALO_MS, recibidos[i].tiempoMs);
+    }
+  }
+}
+
+void test_lote_lleno_cabe_en_el_payload() {
+  // Peor caso: ángulo y conteo con el máximo de dígitos y el lote a punto
+  // de vencer por edad
+  uint32_t paso = LOTE_MAX_EDAD_MS / LOTE_MAX_PUNTOS;
+  for (uint32_t i = 0; i < LOTE_MAX_PUNTOS; i++) {
+    lote.agregar(muestra(4095, 4000000000UL + i));
+    relojPruebaUs += max(paso, (uint32_t)LOTE_INTERVALO_MS) * 1000;
+  }
+  TEST_ASSERT_EQUAL(LOTE_MAX_PUNTOS, lote.cantidad());
+  static char payload[ENLACE_TAM_PAYLOAD];
+  EscritorBuffer json(payload, sizeof(payload));
+  TEST_ASSERT_TRUE(lote.serializar(json, millis()));
+}
+
+// Llena el lote con ángulos que dan vueltas en los dos sentidos, cajas a
+// ritmo irregular y algo de fluctuación en los tiempos
+static void llenarVariado(uint32_t puntos) {
+  uint32_t angulo = 4000;
+  uint32_t conteo = 123456;
+  for (uint32_t i = 0; i < puntos; i++) {
+    angulo = (angulo + (i % 7 < 4 ? 300 : 4096 - 150)) % 4096;
+    conteo += i % 5 == 0 ? 1 : 0;
+    lote.agregar(muestra(angulo, conteo));
+    relojPruebaUs += (LOTE_INTERVALO_MS + i % 3) * 1000;
+  }
+}
+
+static void compararLotes(const LoteTelemetria &a, const LoteTelemetria &b) {
+  TEST_ASSERT_EQUAL(a.cantidad(), b.cantidad());
+  for (size_t i = 0; i < a.cantidad(); i++) {
+    TEST_ASSERT_EQUAL(a.punto(i).tiempoMs, b.punto(i).tiempoMs);
+    TEST_ASSERT_EQUAL(a.punto(i).angulo, b.punto(i).angulo);
+    TEST_ASSERT_EQUAL(a.punto(i).conteo, b.punto(i).conteo);
+  }
+}
+
+void test_binario_ida_y_vuelta() {
+  llenarVariado(LOTE_MAX_PUNTOS);
+  uint8_t binario[ENLACE_TAM_PAYLOAD];
+  size_t bytes = lote.codificarBinario(binario, sizeof(binario), millis());
+  TEST_ASSERT_TRUE(bytes > 0);
+  TEST_ASSERT_NOT_EQUAL('{', binario[0]);
+
+  static LoteTelemetria decodificado;
+  uint32_t ahoraMs = 0;
+  TEST_ASSERT_TRUE(decodificado.decodificarBinario(binario, bytes, ahoraMs));
+  TEST_ASSERT_EQUAL(millis(), ahoraMs);
+  compararLotes(lote, decodificado);
+
+  // Bytes por punto de cada formato
+  static char json[ENLACE_TAM_PAYLOAD];
+  EscritorBuffer escritor(json, sizeof(json));
+  TEST_ASSERT_TRUE(lote.serializar(escritor, millis()));
+  char informe[96];
+  snprintf(informe, sizeof(informe), "Bytes por punto: binario %.2f, JSON %.2f",
+           (double)bytes / lote.cantidad(), (double)escritor.longitud() / lote.cantidad());
+  TEST_MESSAGE(informe);
+  TEST_ASSERT_TRUE(bytes * 3 < escritor.longitud());
+}
+
+void test_binario_valores_extremos() {
+  // Saltos de ángulo de media vuelta, conteo que desborda y puntos separados
+  // menos que el intervalo (t vuelve hacia atrás en el delta de segundo orden)
+  const uint16_t angulos[] = {0, 4095, 0, 2048, 0, 2047, 4095, 1};
+  const uint32_t conteos[] = {0, 0xFFFFFFFF, 0, 5, 0x80000000, 3, 3, 0};
+  for (uint32_t i = 0; i < 8; i++) {
+    lote.agregar(muestra(angulos[i], conteos[i]));
+    relojPruebaUs += (i % 2 ? LOTE_INTERVALO_MS : 60000) * 1000;
+  }
+  TEST_ASSERT_EQUAL(8, lote.cantidad());
+  uint8_t binario[256];
+  size_t bytes = lote.codificarBinario(binario, sizeof(binario), millis());
+  TEST_ASSERT_TRUE(bytes > 0);
+
+  static LoteTelemetria decodificado;
+  uint32_t ahoraMs;
+  TEST_ASSERT_TRUE(decodificado.decodificarBinario(binario, bytes, ahoraMs));
+  compararLotes(lote, decodificado);
+}
+
+void test_binario_vacio() {
+  uint8_t binario[16];
+  size_t bytes = lote.codificarBinario(binario, sizeof(binario), 5000);
+  TEST_ASSERT_TRUE(bytes > 0);
+  static LoteTelemetria decodificado;
+  uint32_t ahoraMs;
+  TEST_ASSERT_TRUE(decodificado.decodificarBinario(binario, bytes, ahoraMs));
+  TEST_ASSERT_EQUAL(0, decodificado.cantidad());
+  TEST_ASSERT_EQUAL(5000, ahoraMs);
+}
+
+void test_binario_mal_formado() {
+  llenarVariado(20);
+  uint8_t binario[256];
+  size_t bytes = lote.codificarBinario(binario, sizeof(binario), millis());
+  static LoteTelemetria decodificado;
+  uint32_t ahoraMs;
+
+  // Cortado en cualquier punto
+  for (size_t corte = 0; corte < bytes; corte++) {
+    TEST_ASSERT_FALSE(decodificado.decodificarBinario(binario, corte, ahoraMs));
+    TEST_ASSERT_EQUAL(0, decodificado.cantidad());
+  }
+  // Con bytes de sobra
+  binario[bytes] = 0;
+  TEST_ASSERT_FALSE(decodificado.decodificarBinario(binario, bytes + 1, ahoraMs));
+  // Otra versión
+  binario[0] = LOTE_VERSION_BINARIO + 1;
+  TEST_ASSERT_FALSE(decodificado.decodificarBinario(binario, bytes, ahoraMs));
+  // Más puntos de los que caben
+  const uint8_t demasiados[] = {LOTE_VERSION_BINARIO, 0xFF, 0x7F, 0, 0, 100};
+  TEST_ASSERT_FALSE(decodificado.decodificarBinario(demasiados, sizeof(demasiados), ahoraMs));
+  // Un varint de más de 5 bytes
+  const uint8_t largo[] = {LOTE_VERSION_BINARIO, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+  TEST_ASSERT_FALSE(decodificado.decodificarBinario(largo, sizeof(largo), ahoraMs));
+}
+
+void test_binario_no_cabe() {
+  llenarVariado(LOTE_MAX_PUNTOS);
+  uint8_t binario[ENLACE_TAM_PAYLOAD];
+  size_t bytes = lote.codificarBinario(binario, sizeof(binario), millis());
+  TEST_ASSERT_EQUAL(0, lote.codificarBinario(binario, bytes - 1, millis()));
+  TEST_ASSERT_EQUAL(bytes, lote.codificarBinario(binario, bytes, millis()));
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_se_llena_por_tamano);
+  RUN_TEST(test_se_envia_por_edad);
+  RUN_TEST(test_un_punto_por_intervalo);
+  RUN_TEST(test_sensor_desconectado_envia_cero);
+  RUN_TEST(test_lotes_llegan_completos_y_en_orden);
+  RUN_TEST(test_lote_lleno_cabe_en_el_payload);
+  RUN_TEST(test_binario_ida_y_vuelta);
+  RUN_TEST(test_binario_valores_extremos);
+  RUN_TEST(test_binario_vacio);
+  RUN_TEST(test_binario_mal_formado);
+  RUN_TEST(test_binario_no_cabe);
+  return UNITY_END();
+}
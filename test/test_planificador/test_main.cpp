@@ -0,0 +1,133 @@
+#include <unity.h>
+#include "planificador.h"
+
+// Reloj virtual: solo avanza cuando lo mueven las tareas o la prueba
+static uint32_t relojUs = 0;
+
+static uint32_t relojVirtualMs() {
+  return relojUs / 1000;
+}
+
+static uint32_t relojVirtualUs() {
+  return relojUs;
+}
+
+static Planificador *plan = nullptr;
+static uint32_t ejecucionesRapida = 0;
+static uint32_t ejecucionesLenta = 0;
+static uint32_t ejecucionesSegunda = 0;
+static int idSegunda = -1;
+
+// Tarda más que su propio periodo: siempre está vencida
+static void tareaAcaparadora() {
+  ejecucionesRapida++;
+  relojUs += 1500;
+}
+
+static void tareaLenta() {
+  ejecucionesLenta++;
+  relojUs += 100;
+}
+
+static void tareaSegunda() {
+  ejecucionesSegunda++;
+  relojUs += 10;
+}
+
+// Una tarea de una sola vez que programa otra: su hueco no debe reutilizarse
+// hasta que se anoten sus estadísticas
+static void tareaEncadenada() {
+  idSegunda = plan->programarUnaVez("segunda", tareaSegunda, 5, 1000);
+  relojUs += 3000;
+}
+
+void setUp() {
+  relojUs = 0;
+  ejecucionesRapida = 0;
+  ejecucionesLenta = 0;
+  ejecucionesSegunda = 0;
+  idSegunda = -1;
+}
+
+void tearDown() {
+  plan = nullptr;
+}
+
+// Avanza el reloj 1 ms cada vez que no hay nada que ejecutar
+static void correr(Planificador &p, uint32_t hastaMs) {
+  while (relojVirtualMs() < hastaMs) {
+    if (!p.ejecutar()) {
+      relojUs += 1000;
+    }
+  }
+}
+
+void test_sin_inanicion() {
+  Planificador p(relojVirtualMs, relojVirtualUs);
+  int rapida = p.agregarPeriodica("rapida", tareaAcaparadora, 1, 500);
+  int lenta = p.agregarPeriodica("lenta", tareaLenta, 100, 500);
+  correr(p, 10000);
+
+  // La tarea acaparadora siempre está vencida, pero la lenta no pierde turnos
+  TEST_ASSERT_INT_WITHIN(2, 100, ejecucionesLenta);
+  TEST_ASSERT_GREATER_THAN(1000, ejecucionesRapida);
+  EstadisticasTarea stats = p.estadisticas(lenta);
+  TEST_ASSERT_LESS_OR_EQUAL(3, stats.retrasoMaxMs);
+  TEST_ASSERT_EQUAL(ejecucionesRapida, p.estadisticas(rapida).desbordes);
+}
+
+void test_retraso_acotado_con_muchas_tareas() {
+  Planificador p(relojVirtualMs, relojVirtualUs);
+  for (uint8_t i = 0; i < PLANIFICADOR_MAX_TAREAS - 1; i++) {
+    p.agregarPeriodica("rapida", tareaAcaparadora, 1, 500);
+  }
+  int lenta = p.agregarPeriodica("lenta", tareaLenta, 50, 500);
+  correr(p, 5000);
+
+  // Peor caso: esperar a que pasen todas las demás una vez
+  TEST_ASSERT_GREATER_THAN(50, ejecucionesLenta);
+  TEST_ASSERT_LESS_OR_EQUAL(PLANIFICADOR_MAX_TAREAS * 2, p.estadisticas(lenta).retrasoMaxMs);
+}
+
+void test_una_vez_que_programa_otra() {
+  Planificador p(relojVirtualMs, relojVirtualUs);
+  plan = &p;
+  int primera = p.programarUnaVez("primera", tareaEncadenada, 0, 1000);
+  TEST_ASSERT_TRUE(p.ejecutar());
+
+  // La segunda va a otro hueco y empieza sin estadísticas
+  TEST_ASSERT_NOT_EQUAL(primera, idSegunda);
+  TEST_ASSERT_EQUAL(1, p.estadisticas(primera).ejecuciones);
+  TEST_ASSERT_EQUAL(3000, p.estadisticas(primera).duracionMaxUs);
+  TEST_ASSERT_EQUAL(1, p.estadisticas(primera).desbordes);
+  TEST_ASSERT_EQUAL(0, p.estadisticas(idSegunda).ejecuciones);
+
+  correr(p, 20);
+  TEST_ASSERT_EQUAL(1, ejecucionesSegunda);
+  TEST_ASSERT_EQUAL(1, p.estadisticas(idSegunda).ejecuciones);
+  TEST_ASSERT_EQUAL(0, p.estadisticas(idSegunda).desbordes);
+
+  // Ya terminadas, sus huecos se reutilizan
+  TEST_ASSERT_EQUAL(primera, p.programarUnaVez("tercera", tareaSegunda, 0, 1000));
+}
+
+void test_no_recupera_ejecuciones_perdidas() {
+  Planificador p(relojVirtualMs, relojVirtualUs);
+  int lenta = p.agregarPeriodica("lenta", tareaLenta, 10, 500);
+  TEST_ASSERT_TRUE(p.ejecutar());
+  relojUs += 1000000;   // Un segundo sin llamar a ejecutar()
+  correr(p, 1100);
+
+  // Una sola ejecución atrasada y luego de nuevo cada 10 ms
+  TEST_ASSERT_INT_WITHIN(2, 1 + 1 + 10, ejecucionesLenta);
+  TEST_ASSERT_GREATER_OR_EQUAL(990, p.estadisticas(lenta).retrasoMaxMs);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_sin_inanicion);
+  RUN_TEST(test_retraso_acotado_con_muchas_tareas);
+  RUN_TEST(test_una_vez_que_programa_otra);
+  RUN_TEST(test_no_recupera_ejecuciones_perdidas);
+  return UNITY_END();
+}
@@ -0,0 +1,123 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include "pagina_anterior.h"
+#include "recursos_portal.h"
+
+// Antes la página se generaba entera en cada petición y se recargaba sola
+// cada 2 s. Ahora la estructura va comprimida en flash, se revalida con ETag
+// y los valores llegan aparte (/datos y /eventos).
+static const uint32_t RECARGA_ANTERIOR_S = 2;
+
+static const RecursoPortal *buscar(const char *ruta) {
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    if (strcmp(RECURSOS_PORTAL[i].ruta, ruta) == 0) {
+      return &RECURSOS_PORTAL[i];
+    }
+  }
+  return nullptr;
+}
+
+// Los 4 últimos bytes de un gzip son el tamaño original (little endian)
+static uint32_t tamanoOriginal(const RecursoPortal &r) {
+  const uint8_t *p = r.datos + r.longitud - 4;
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static size_t bytesPrimeraVisita() {
+  size_t total = 0;
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    total += RECURSOS_PORTAL[i].longitud;
+  }
+  return total;
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_recursos_en_gzip() {
+  TEST_ASSERT_NOT_NULL(buscar("/"));
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    const RecursoPortal &r = RECURSOS_PORTAL[i];
+    TEST_ASSERT_GREATER_THAN(18, r.longitud);
+    TEST_ASSERT_EQUAL(0x1f, r.datos[0]);
+    TEST_ASSERT_EQUAL(0x8b, r.datos[1]);
+    TEST_ASSERT_GREATER_THAN(r.longitud, tamanoOriginal(r));
+    // ETag entre comillas y dentro del buffer con que se compara If-None-Match
+    TEST_ASSERT_EQUAL('"', r.etag[0]);
+    TEST_ASSERT_LESS_OR_EQUAL(15, strlen(r.etag));
+  }
+}
+
+static void test_cache() {
+  // La página se revalida (cambia con cada versión del firmware); el resto
+  // lleva el hash en la URL y no se vuelve a pedir
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    const RecursoPortal &r = RECURSOS_PORTAL[i];
+    TEST_ASSERT_EQUAL(strcmp(r.ruta, "/") != 0, r.inmutable);
+  }
+}
+
+static void test_bytes_transferidos() {
+  size_t anterior = paginaConString(LECTURA).length();
+  size_t primera = bytesPrimeraVisita();
+  size_t original = 0;
+  for (size_t i = 0; i < CANTIDAD_RECURSOS_PORTAL; i++) {
+    original += tamanoOriginal(RECURSOS_PORTAL[i]);
+  }
+
+  // Un minuto con la página abierta. Antes: 30 páginas completas. Ahora: la
+  // carga inicial y como mucho un evento cada EVENTOS_PERIODO_MS (200 ms) con
+  // el ángulo cambiando sin parar; "data: {"angulo":4095}\n\n" son 23 bytes.
+  const uint32_t EVENTO = 23;
+  const uint32_t EVENTOS_MINUTO = 60 * 1000 / 200;
+  size_t minutoAnterior = anterior * 60 / RECARGA_ANTERIOR_S;
+  size_t minutoNuevo = primera + EVENTO * EVENTOS_MINUTO;
+
+  char mensaje[160];
+  snprintf(mensaje, sizeof(mensaje), "Antes: %u B por carga, %u B por minuto abierta",
+           (unsigned)anterior, (unsigned)minutoAnterior);
+  TEST_MESSAGE(mensaje);
+  snprintf(mensaje, sizeof(mensaje), "Ahora: %u B primera visita (%u B sin gzip), 0 B al volver (304), "
+           "%u B por minuto abierta como mucho", (unsigned)primera, (unsigned)original, (unsigned)minutoNuevo);
+  TEST_MESSAGE(mensaje);
+
+  TEST_ASSERT_LESS_THAN(original / 2, primera);
+  TEST_ASSERT_LESS_THAN(minutoAnterior / 4, minutoNuevo);
+}
+
+// Tiempo hasta tener el primer byte listo para enviar, sin la red (igual en
+// los dos casos). Antes hacía falta generar la página entera; ahora basta
+// con encontrar el recurso. Tiempos del PC: valen para comparar.
+static void test_primer_byte() {
+  const int VUELTAS = 5000;
+  volatile size_t primero = 0;
+
+  auto inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < VUELTAS; i++) {
+    CadenaArduino html = paginaConString(LECTURA);
+    primero += html.c_str()[0];
+  }
+  double nsAnterior = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  inicio = std::chrono::steady_clock::now();
+  for (int i = 0; i < VUELTAS; i++) {
+    const RecursoPortal *r = buscar(i % 2 ? "/" : "/portal.js");
+    primero += r->datos[0];
+  }
+  double nsAhora = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - inicio).count() / VUELTAS;
+
+  char mensaje[128];
+  snprintf(mensaje, sizeof(mensaje), "Primer byte: antes %.0f ns, ahora %.0f ns", nsAnterior, nsAhora);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_TRUE(nsAhora < nsAnterior);
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_recursos_en_gzip);
+  RUN_TEST(test_cache);
+  RUN_TEST(test_bytes_transferidos);
+  RUN_TEST(test_primer_byte);
+  return UNITY_END();
+}
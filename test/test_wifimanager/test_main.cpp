@@ -0,0 +1,292 @@
+#include <unity.h>
+#include <new>
+#include <stdio.h>
+#include "pagina_anterior.h"
+#include "wm_strings_en.h"
+
+// handleRoot() y handleWifi() de WiFiManager con los textos de la librería,
+// antes (la página entera en un String y HTTPSend) y ahora (HTTPSendHead y
+// HTTPSendChunk tras cada trozo). Mismos pasos y mismas cadenas que
+// WiFiManager.cpp con la configuración por defecto. El WebServer no se
+// cuenta: sus reservas para la cabecera HTTP son iguales en los dos casos.
+
+// Contabilidad del heap de todo el programa, como en test_escritor
+static size_t reservas = 0;
+static size_t vivos = 0;
+static size_t pico = 0;
+
+static const size_t TAM_CABECERA = alignof(max_align_t);
+
+void *operator new(size_t tam) {
+  char *p = (char *)malloc(tam + TAM_CABECERA);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  *(size_t *)p = tam;
+  reservas++;
+  vivos += tam;
+  pico = max(pico, vivos);
+  return p + TAM_CABECERA;
+}
+
+void operator delete(void *p) noexcept {
+  if (!p) {
+    return;
+  }
+  char *bloque = (char *)p - TAM_CABECERA;
+  vivos -= *(size_t *)bloque;
+  free(bloque);
+}
+
+void operator delete(void *p, size_t) noexcept {
+  operator delete(p);
+}
+
+// Lo que recibe el cliente, fuera del heap
+struct Envio {
+  char texto[16384];
+  size_t longitud;
+  size_t trozos;
+};
+static Envio envio;
+
+static void enviar(const CadenaArduino &c) {
+  TEST_ASSERT_TRUE(envio.longitud + c.length() < sizeof(envio.texto));
+  memcpy(envio.texto + envio.longitud, c.c_str(), c.length());
+  envio.longitud += c.length();
+  envio.trozos++;
+}
+
+// HTTPSend() y HTTPSendChunk()
+static void httpSend(const CadenaArduino &pagina) {
+  enviar(pagina);
+}
+
+static void httpSendChunk(CadenaArduino &pagina) {
+  if (pagina.length() > 0) {
+    enviar(pagina);
+  }
+  pagina = "";
+}
+
+// sendContent_P(): directo desde flash
+static void enviarFlash(const char *texto) {
+  size_t n = strlen(texto);
+  TEST_ASSERT_TRUE(envio.longitud + n < sizeof(envio.texto));
+  memcpy(envio.texto + envio.longitud, texto, n);
+  envio.longitud += n;
+  envio.trozos++;
+}
+
+// Estado del portal durante la prueba
+static const char *AP_NOMBRE = "ESP32_Sensores";
+static const char *SSID_GUARDADO = "Planta-Norte";
+static const char *IP_LOCAL = "192.168.4.2";
+static const uint8_t MENU_POR_DEFECTO[] = {0, 2, 6, 9, 8};   // wifi, info, exit, sep, update
+
+struct Red {
+  const char *ssid;
+  int rssi;
+  bool cifrada;
+};
+
+static Red redes[40];
+static int cantidadRedes = 0;
+
+static void escanear(int n) {
+  static char nombres[40][24];
+  cantidadRedes = n;
+  for (int i = 0; i < n; i++) {
+    snprintf(nombres[i], sizeof(nombres[i]), "Planta-AP-%02d", i);
+    redes[i] = {nombres[i], -40 - i * 2, i % 4 != 0};
+  }
+}
+
+static CadenaArduino getHTTPHead(CadenaArduino title, CadenaArduino classes) {
+  CadenaArduino page;
+  page += HTTP_HEAD_START;
+  page.replace(T_v, title);
+  page += HTTP_SCRIPT;
+  page += HTTP_STYLE;
+  page += "";   // _customHeadElement
+  CadenaArduino p = HTTP_HEAD_END;
+  p.replace(T_c, classes);
+  page += p;
+  return page;
+}
+
+static void httpSendHead(CadenaArduino title, CadenaArduino classes) {
+  CadenaArduino page = HTTP_HEAD_START;
+  page.replace(T_v, title);
+  httpSendChunk(page);
+  enviarFlash(HTTP_SCRIPT);
+  enviarFlash(HTTP_STYLE);
+  page += "";   // _customHeadElement
+  CadenaArduino p = HTTP_HEAD_END;
+  p.replace(T_c, classes);
+  page += p;
+  httpSendChunk(page);
+}
+
+static CadenaArduino getHTTPEnd() {
+  CadenaArduino end = HTTP_END;
+  return end;
+}
+
+static CadenaArduino getMenuOut() {
+  CadenaArduino page;
+  for (uint8_t id : MENU_POR_DEFECTO) {
+    CadenaArduino token = _menutokens[id];   // (String)_menutokens[menuId]
+    page += HTTP_PORTAL_MENU[id];
+  }
+  return page;
+}
+
+static void reportStatus(CadenaArduino &page) {
+  CadenaArduino str;
+  str = HTTP_STATUS_ON;
+  str.replace(T_i, CadenaArduino(IP_LOCAL));
+  str.replace(T_v, CadenaArduino(SSID_GUARDADO));   // htmlEntities()
+  page += str;
+}
+
+static CadenaArduino getScanItemOut() {
+  CadenaArduino page;
+  if (cantidadRedes == 0) {
+    page += S_nonetworks;
+    page += "<br/><br/>";
+    return page;
+  }
+  CadenaArduino item_str = HTTP_ITEM;
+  item_str.replace("{qp}", HTTP_ITEM_QP);
+  item_str.replace("{h}", "h");
+  item_str.replace("{qi}", HTTP_ITEM_QI);
+  item_str.replace("{h}", "");
+  for (int i = 0; i < cantidadRedes; i++) {
+    int rssiperc = constrain(2 * (redes[i].rssi + 100), 0, 100);
+    CadenaArduino item = item_str;
+    item.replace(T_V, CadenaArduino(redes[i].ssid));
+    item.replace(T_v, CadenaArduino(redes[i].ssid));
+    item.replace(T_r, CadenaArduino((uint32_t)rssiperc));
+    item.replace(T_q, CadenaArduino((uint32_t)(rssiperc * 3 / 100 + 1)));
+    item.replace(T_i, redes[i].cifrada ? "l" : "");
+    page += item;
+  }
+  page += HTTP_BR;
+  return page;
+}
+
+static void handleRoot(bool porTrozos) {
+  CadenaArduino page;
+  if (porTrozos) {
+    httpSendHead(S_brand, C_root);
+  } else {
+    page = getHTTPHead(S_brand, C_root);
+  }
+  CadenaArduino str = HTTP_ROOT_MAIN;
+  str.replace(T_t, S_brand);
+  str.replace(T_v, AP_NOMBRE);
+  page += str;
+  page += HTTP_PORTAL_OPTIONS;
+  page += getMenuOut();
+  if (porTrozos) {
+    httpSendChunk(page);
+  }
+  reportStatus(page);
+  page += getHTTPEnd();
+  if (porTrozos) {
+    httpSendChunk(page);
+  } else {
+    httpSend(page);
+  }
+}
+
+static void handleWifi(bool porTrozos) {
+  CadenaArduino page;
+  if (porTrozos) {
+    httpSendHead(S_titlewifi, C_wifi);
+    page = getScanItemOut();
+    httpSendChunk(page);
+  } else {
+    page = getHTTPHead(S_titlewifi, C_wifi);
+    page += getScanItemOut();
+  }
+  CadenaArduino pitem = "";
+  pitem = HTTP_FORM_START;
+  pitem.replace(T_v, "wifisave");
+  page += pitem;
+  pitem = HTTP_FORM_WIFI;
+  pitem.replace(T_v, SSID_GUARDADO);
+  pitem.replace(T_p, S_passph);
+  page += pitem;
+  page += CadenaArduino();   // getStaticOut()
+  page += HTTP_FORM_WIFI_END;
+  page += HTTP_FORM_END;
+  page += HTTP_SCAN_LINK;
+  reportStatus(page);
+  page += getHTTPEnd();
+  if (porTrozos) {
+    httpSendChunk(page);
+  } else {
+    httpSend(page);
+  }
+}
+
+struct Medida {
+  size_t reservas;
+  size_t pico;
+  size_t bytes;
+  size_t trozos;
+};
+
+static Medida medir(void (*pagina)(bool), bool porTrozos) {
+  envio.longitud = 0;
+  envio.trozos = 0;
+  size_t base = vivos;
+  reservas = 0;
+  pico = vivos;
+  pagina(porTrozos);
+  TEST_ASSERT_EQUAL(base, vivos);
+  return {reservas, pico - base, envio.longitud, envio.trozos};
+}
+
+// Antes y ahora, el mismo texto y el pico de heap de cada forma
+static void comparar(const char *nombre, void (*pagina)(bool)) {
+  static char entera[sizeof(envio.texto)];
+  Medida antes = medir(pagina, false);
+  memcpy(entera, envio.texto, antes.bytes);
+  Medida ahora = medir(pagina, true);
+  TEST_ASSERT_EQUAL(antes.bytes, ahora.bytes);
+  TEST_ASSERT_EQUAL_MEMORY(entera, envio.texto, antes.bytes);
+
+  char mensaje[160];
+  snprintf(mensaje, sizeof(mensaje), "%s, %u B: entera %u reservas, pico %u B; por trozos (%u) %u reservas, pico %u B",
+           nombre, (unsigned)antes.bytes, (unsigned)antes.reservas, (unsigned)antes.pico,
+           (unsigned)ahora.trozos, (unsigned)ahora.reservas, (unsigned)ahora.pico);
+  TEST_MESSAGE(mensaje);
+  TEST_ASSERT_LESS_THAN(antes.pico, ahora.pico);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_raiz() {
+  comparar("Raíz", handleRoot);
+}
+
+static void test_wifi_con_redes() {
+  const int cantidades[] = {0, 12, 30};
+  for (int n : cantidades) {
+    escanear(n);
+    char nombre[32];
+    snprintf(nombre, sizeof(nombre), "Wifi con %d redes", n);
+    comparar(nombre, handleWifi);
+  }
+}
+
+int main(int, char **) {
+  UNITY_BEGIN();
+  RUN_TEST(test_raiz);
+  RUN_TEST(test_wifi_con_redes);
+  return UNITY_END();
+}